@@ -0,0 +1,86 @@
+/**	@file	FilterBenchmark.cpp
+	@brief	Microbenchmark of per-report pose smoothing cost
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "PoseFilter.h"
+#include "MonotonicClock.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+/// Precomputed input, so only the filter is timed
+static const int SAMPLES = 4096;
+static const double FRAME_RATE = 100.0;
+
+int main(int argc, char * argv[]) {
+	long passes = 2000;
+	if (argc > 1) {
+		passes = std::atol(argv[1]);
+	}
+
+	// A head swaying and turning, with a little solver noise
+	static double positions[SAMPLES][3];
+	static double quats[SAMPLES][4];
+	std::srand(1);
+	for (int i = 0; i < SAMPLES; ++i) {
+		const double t = i / FRAME_RATE;
+		const double noise = (std::rand() / double(RAND_MAX) - 0.5) * 0.002;
+		positions[i][0] = 0.1 * std::sin(t) + noise;
+		positions[i][1] = 0.05 * std::cos(0.7 * t) - noise;
+		positions[i][2] = 0.6 + noise;
+		const double half = 0.25 * std::sin(0.5 * t) + noise;
+		quats[i][0] = 0;
+		quats[i][1] = std::sin(half);
+		quats[i][2] = 0;
+		quats[i][3] = std::cos(half);
+	}
+
+	PoseFilter filter;
+	filter.setParameters(FilterParameters(1.0, 1.0, 10.0, 2.0));
+
+	double pos[3];
+	double quat[4];
+	double checksum = 0;
+	const double start = monotonic::seconds();
+	for (long pass = 0; pass < passes; ++pass) {
+		for (int i = 0; i < SAMPLES; ++i) {
+			pos[0] = positions[i][0];
+			pos[1] = positions[i][1];
+			pos[2] = positions[i][2];
+			quat[0] = quats[i][0];
+			quat[1] = quats[i][1];
+			quat[2] = quats[i][2];
+			quat[3] = quats[i][3];
+			filter.filter((pass * SAMPLES + i) / FRAME_RATE, pos, quat);
+			checksum += pos[0] + quat[3];
+		}
+	}
+	const double elapsed = monotonic::seconds() - start;
+	const double reports = double(passes) * SAMPLES;
+
+	std::cout << "PoseFilter::filter: " << std::fixed << std::setprecision(1) <<
+		elapsed / reports * 1.0e9 << " ns/report over " << std::setprecision(0) << reports <<
+		" reports (checksum " << std::setprecision(3) << checksum << ")" << std::endl;
+	return 0;
+}
@@ -0,0 +1,441 @@
+/**	@file	PipelineBenchmark.cpp
+	@brief	End-to-end latency and throughput benchmark of the tracking server
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "TrackingSystem.h"
+#include "TrackerConfiguration.h"
+#include "SimulatedWiimote.h"
+#include "FromString.h"
+#include "MonotonicClock.h"
+
+// Library/third-party includes
+#include <vrpn_Connection.h>
+#include <vrpn_Tracker.h>
+#include <vrpn_Analog.h>
+
+// Standard includes
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/// Names the server side serves station 0 under
+static const char * TRACKER_NAME = "Tracker0";
+static const char * WIIMOTE_NAME = "WiiMote0";
+
+struct BenchmarkOptions {
+	BenchmarkOptions() :
+			rate(100),
+			seconds(10),
+			warmup(2),
+			port(3884),
+			stall(0),
+			latestValue(false),
+			transport(TRANSPORT_DEFAULT),
+			allTransports(false),
+			displayPeriod(0) {}
+	float rate;
+	float seconds;
+	float warmup;
+	int port;
+	/// Milliseconds the client stops reading for, every STALL_EVERY
+	float stall;
+	/// Whether the server sends slow clients only the newest reports
+	bool latestValue;
+	PoseTransport transport;
+	/// Run once per transport, each on its own port, to compare them
+	bool allTransports;
+	/// Milliseconds between deadlines of a display to publish for, or 0
+	float displayPeriod;
+};
+
+static const char * transportName(const PoseTransport transport) {
+	switch (transport) {
+		case TRANSPORT_RELIABLE:	return "reliable";
+		case TRANSPORT_UNRELIABLE:	return "unreliable";
+		case TRANSPORT_DEFAULT:		break;
+	}
+	return "default";
+}
+
+/// Seconds between the starts of a stalling client's stalls
+static const double STALL_EVERY = 2.0;
+
+/// @brief What the client measured, passed back to the server process
+/// as one line of text.
+struct ClientResults {
+	ClientResults() :
+			poses(0),
+			throughput(0),
+			p50(0),
+			p99(0),
+			p999(0) {}
+	unsigned long poses;
+	/// Poses per second received
+	double throughput;
+	/// @name Input-to-client latency percentiles, in seconds
+	/// @{
+	double p50;
+	double p99;
+	double p999;
+	/// @}
+};
+
+static double cpuSeconds() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+		(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1.0e6;
+}
+
+static double percentile(const std::vector<double> & sorted, const double p) {
+	if (sorted.empty()) {
+		return 0;
+	}
+	std::size_t i = std::size_t(p * sorted.size());
+	return sorted[std::min(i, sorted.size() - 1)];
+}
+
+/// @name Client process
+/// @{
+
+/// @brief Client state: the latest Wiimote report seen is the input the
+/// next pose was computed from - the server publishes each frame's pose
+/// right after the frame itself.
+struct ClientState {
+	ClientState() :
+			haveInput(false),
+			measuring(false) {}
+	bool haveInput;
+	struct timeval lastInput;
+	bool measuring;
+	std::vector<double> latencies;
+};
+
+static void VRPN_CALLBACK clientWiimoteHandler(void * userdata, const vrpn_ANALOGCB info) {
+	ClientState * state = static_cast<ClientState *>(userdata);
+	state->lastInput = info.msg_time;
+	state->haveInput = true;
+}
+
+static void VRPN_CALLBACK clientPoseHandler(void * userdata, const vrpn_TRACKERCB) {
+	ClientState * state = static_cast<ClientState *>(userdata);
+	if (!state->haveInput) {
+		return;
+	}
+	if (state->measuring) {
+		struct timeval now;
+		vrpn_gettimeofday(&now, NULL);
+		state->latencies.push_back(vrpn_TimevalDuration(now, state->lastInput));
+	}
+	state->haveInput = false;
+}
+
+/// @brief Receive poses from the server process for warmup + seconds,
+/// and print what was measured to stdout.
+static int runClient(const BenchmarkOptions & opts) {
+	std::ostringstream address;
+	address << "@localhost:" << opts.port;
+	vrpn_Analog_Remote wiimote((WIIMOTE_NAME + address.str()).c_str());
+	vrpn_Tracker_Remote tracker((TRACKER_NAME + address.str()).c_str());
+	vrpn_Connection * connection = tracker.connectionPtr();
+	if (!connection) {
+		return 1;
+	}
+
+	ClientState state;
+	state.latencies.reserve(std::size_t(opts.rate * opts.seconds * 1.5));
+	wiimote.register_change_handler(&state, &clientWiimoteHandler);
+	tracker.register_change_handler(&state, &clientPoseHandler, 0);
+
+	// Block on the socket rather than spin, like a well-behaved client
+	struct timeval wait;
+	wait.tv_sec = 0;
+	wait.tv_usec = 10000;
+
+	// Wait up to a few seconds for the server to come up and send a pose
+	double start = monotonic::seconds();
+	while (!state.haveInput) {
+		connection->mainloop(&wait);
+		if (monotonic::seconds() - start > 10.0) {
+			std::cerr << "Client: no data from the server" << std::endl;
+			return 1;
+		}
+	}
+	start = monotonic::seconds();
+	while (monotonic::seconds() - start < opts.warmup) {
+		connection->mainloop(&wait);
+	}
+	state.measuring = true;
+	start = monotonic::seconds();
+	double nextStall = start + STALL_EVERY / 2;
+	while (monotonic::seconds() - start < opts.seconds) {
+		connection->mainloop(&wait);
+		if (opts.stall > 0 && monotonic::seconds() >= nextStall) {
+			// Play a client that hangs now and then - a long frame,
+			// a debugger - and leaves the server's reports unread
+			vrpn_SleepMsecs(opts.stall);
+			nextStall += STALL_EVERY;
+		}
+	}
+	const double elapsed = monotonic::seconds() - start;
+
+	std::sort(state.latencies.begin(), state.latencies.end());
+	ClientResults results;
+	results.poses = state.latencies.size();
+	results.throughput = results.poses / elapsed;
+	results.p50 = percentile(state.latencies, 0.5);
+	results.p99 = percentile(state.latencies, 0.99);
+	results.p999 = percentile(state.latencies, 0.999);
+	std::cout << std::setprecision(9) << results.poses << " " << results.throughput << " " <<
+		results.p50 << " " << results.p99 << " " << results.p999 << std::endl;
+	return 0;
+}
+/// @}
+
+/// @name Server process
+/// @{
+
+/// @brief Start the client as a separate process, its stdout on a pipe.
+/// @returns the child's pid, or -1
+static pid_t spawnClient(const char * self, const BenchmarkOptions & opts, int & resultsFd) {
+	int fds[2];
+	if (pipe(fds) != 0) {
+		return -1;
+	}
+	std::ostringstream rate, seconds, warmup, port, stall;
+	rate << opts.rate;
+	seconds << opts.seconds;
+	warmup << opts.warmup;
+	port << opts.port;
+	stall << opts.stall;
+
+	const pid_t pid = fork();
+	if (pid == 0) {
+		// A fresh exec, not just a fork: the child shares nothing
+		// with the server but the loopback socket
+		dup2(fds[1], STDOUT_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+		execlp(self, self, "--client", "--rate", rate.str().c_str(),
+			"--seconds", seconds.str().c_str(), "--warmup", warmup.str().c_str(),
+			"--port", port.str().c_str(), "--stall", stall.str().c_str(), (char *)NULL);
+		_exit(127);
+	}
+	close(fds[1]);
+	resultsFd = fds[0];
+	return pid;
+}
+
+static bool readResults(const int fd, ClientResults & results) {
+	std::string text;
+	char buf[256];
+	ssize_t n;
+	while ((n = read(fd, buf, sizeof(buf))) > 0) {
+		text.append(buf, std::size_t(n));
+	}
+	std::istringstream fields(text);
+	return bool(fields >> results.poses >> results.throughput >>
+		results.p50 >> results.p99 >> results.p999);
+}
+
+static int runServer(const char * self, const BenchmarkOptions & opts) {
+	// Publish each frame as it arrives: one pose per input
+	TransportParameters transport;
+	transport.mode = opts.transport;
+	TrackerConfiguration config(.205f, TRACKER_NAME, 60, true, 0,
+		PREDICT_CONSTANT_VELOCITY, FilterParameters(), 250, LedConstellation(), transport,
+		opts.displayPeriod);
+	SimulationParameters simulation;
+	simulation.frameRate = opts.rate;
+
+	TrackingSystem system;
+	system.addPipeline(config, SOURCE_SIMULATED);
+	system.setSimulation(simulation);
+	system.setListenPort(opts.port);
+	system.useLatestValue(opts.latestValue);
+	if (!system.startThread()) {
+		std::cerr << "Could not start the tracking thread" << std::endl;
+		return 1;
+	}
+	system.postCommand(TrackingCommand(TrackingCommand::CMD_START));
+
+	int resultsFd = -1;
+	const pid_t client = spawnClient(self, opts, resultsFd);
+	if (client < 0) {
+		std::cerr << "Could not start the client process" << std::endl;
+		system.stopThread();
+		return 1;
+	}
+
+	// Measure our CPU use over roughly the client's window: the ratio
+	// to wall time is what matters, so the edges needn't line up
+	vrpn_SleepMsecs((opts.warmup + 1.0) * 1000.0);
+	const double wallStart = monotonic::seconds();
+	const double cpuStart = cpuSeconds();
+	// Collect what the server saw of the client while it is connected
+	unsigned long superseded = 0;
+	StageMetrics metrics;
+	while (monotonic::seconds() - wallStart < opts.seconds - 1.0) {
+		vrpn_SleepMsecs(250);
+		if (system.latestMetrics(metrics)) {
+			unsigned long total = 0;
+			for (int i = 0; i < StageMetrics::CLIENTS; ++i) {
+				total += metrics.clients[i].superseded;
+			}
+			superseded = std::max(superseded, total);
+		}
+	}
+	ClientResults results;
+	const bool haveResults = readResults(resultsFd, results);
+	const double cpu = cpuSeconds() - cpuStart;
+	const double wall = monotonic::seconds() - wallStart;
+	close(resultsFd);
+	int status = 0;
+	waitpid(client, &status, 0);
+	system.stopThread();
+
+	SystemEvent evt;
+	while (system.nextEvent(evt)) {}
+
+	if (!haveResults || results.poses == 0) {
+		std::cerr << "The client received no poses" << std::endl;
+		return 1;
+	}
+	const double cpuPerReport = (cpu / wall) / results.throughput;
+
+	// One line, the same fields every time, for comparing commits
+	std::cout << std::fixed <<
+		"pipelinebenchmark: rate " << std::setprecision(0) << opts.rate <<
+		" Hz, " << transportName(opts.transport) << " transport, " <<
+		results.poses << " poses in " << opts.seconds << " s; " <<
+		"throughput " << std::setprecision(1) << results.throughput << " poses/s; " <<
+		"input-to-client latency p50 " << std::setprecision(3) << results.p50 * 1000.0 <<
+		" ms, p99 " << results.p99 * 1000.0 <<
+		" ms, p99.9 " << results.p999 * 1000.0 << " ms; " <<
+		"server CPU " << std::setprecision(1) << cpuPerReport * 1.0e6 << " us/report";
+	if (opts.stall > 0) {
+		std::cout << "; client stalls " << std::setprecision(0) << opts.stall <<
+			" ms every " << STALL_EVERY << " s, " <<
+			(opts.latestValue ? "latest-value" : "queued") << " delivery, " <<
+			superseded << " reports superseded";
+	}
+	if (opts.displayPeriod > 0) {
+		const LatencyHistogram & age = metrics.stages[STAGE_DISPLAY];
+		std::cout << "; display every " << std::setprecision(3) << opts.displayPeriod <<
+			" ms, frame age at deadline p50 " << age.getPercentile(0.5) * 1000.0 <<
+			" ms, p99 " << age.getPercentile(0.99) * 1000.0 <<
+			" ms, max " << age.getMax() * 1000.0 << " ms";
+	}
+	std::cout << std::endl;
+	return 0;
+}
+/// @}
+
+static void usage(const char * argv0) {
+	std::cerr << "Usage: " << argv0 << " [options]" << std::endl <<
+		"  --rate HZ      Simulated IR frames per second (default 100, up to " <<
+		SimulationParameters::MAX_FRAME_RATE << ")" << std::endl <<
+		"  --seconds S    Length of the measured run (default 10)" << std::endl <<
+		"  --warmup S     Time to settle before measuring (default 2)" << std::endl <<
+		"  --port N       Loopback port to serve on (default 3884)" << std::endl <<
+		"  --stall MS     Have the client stop reading for MS every " << STALL_EVERY <<
+		" s (default 0)" << std::endl <<
+		"  --latest-value Send a client that falls behind only the newest reports" << std::endl <<
+		"  --transport M  Send poses default, reliable or unreliable - or all, to" << std::endl <<
+		"                 run once with each, on successive ports" << std::endl <<
+		"  --display-period MS" << std::endl <<
+		"                 Publish for a display refreshing every MS instead" << std::endl;
+}
+
+int main(int argc, char * argv[]) {
+	BenchmarkOptions opts;
+	bool client = false;
+	for (int i = 1; i < argc; ++i) {
+		const bool haveValue = (i + 1 < argc);
+		bool ok = true;
+		if (std::strcmp(argv[i], "--client") == 0) {
+			client = true;
+		} else if (std::strcmp(argv[i], "--rate") == 0 && haveValue) {
+			ok = fromString<float>(opts.rate, argv[++i]) && opts.rate > 0 &&
+				opts.rate <= SimulationParameters::MAX_FRAME_RATE;
+		} else if (std::strcmp(argv[i], "--seconds") == 0 && haveValue) {
+			ok = fromString<float>(opts.seconds, argv[++i]) && opts.seconds > 0;
+		} else if (std::strcmp(argv[i], "--warmup") == 0 && haveValue) {
+			ok = fromString<float>(opts.warmup, argv[++i]) && opts.warmup >= 0;
+		} else if (std::strcmp(argv[i], "--port") == 0 && haveValue) {
+			ok = fromString<int>(opts.port, argv[++i]) && opts.port > 0 && opts.port <= 65535;
+		} else if (std::strcmp(argv[i], "--stall") == 0 && haveValue) {
+			ok = fromString<float>(opts.stall, argv[++i]) && opts.stall >= 0 &&
+				opts.stall < STALL_EVERY * 1000.0;
+		} else if (std::strcmp(argv[i], "--latest-value") == 0) {
+			opts.latestValue = true;
+		} else if (std::strcmp(argv[i], "--display-period") == 0 && haveValue) {
+			ok = fromString<float>(opts.displayPeriod, argv[++i]) && opts.displayPeriod >= 2 &&
+				opts.displayPeriod <= 1000;
+		} else if (std::strcmp(argv[i], "--transport") == 0 && haveValue) {
+			const std::string mode(argv[++i]);
+			opts.allTransports = (mode == "all");
+			if (mode == "reliable") {
+				opts.transport = TRANSPORT_RELIABLE;
+			} else if (mode == "unreliable") {
+				opts.transport = TRANSPORT_UNRELIABLE;
+			} else {
+				ok = (mode == "default" || mode == "all");
+			}
+		} else {
+			ok = false;
+		}
+		if (!ok) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (client) {
+		return runClient(opts);
+	}
+	if (!opts.allTransports) {
+		return runServer(argv[0], opts);
+	}
+	const PoseTransport transports[] = {
+		TRANSPORT_DEFAULT,
+		TRANSPORT_RELIABLE,
+		TRANSPORT_UNRELIABLE
+	};
+	int ret = 0;
+	for (int t = 0; t < 3; ++t) {
+		BenchmarkOptions run(opts);
+		run.transport = transports[t];
+		// A fresh port, so no socket from the last run gets in the way
+		run.port = opts.port + t;
+		if (runServer(argv[0], run) != 0) {
+			ret = 1;
+		}
+	}
+	return ret;
+}
@@ -0,0 +1,143 @@
+/**	@file	PnPBenchmark.cpp
+	@brief	Microbenchmark of the per-frame 6-DOF constellation solve
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "PnPSolver.h"
+#include "IrCamera.h"
+#include "QuaternionMath.h"
+#include "MonotonicClock.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+/// Precomputed frames, so only the solver is timed
+static const int FRAMES = 4096;
+static const double FRAME_RATE = 100.0;
+/// Each solve has to fit in this with plenty to spare
+static const double BUDGET = 100e-6;
+
+struct Frame {
+	double points[LedConstellation::MAX_LEDS][2];
+	int numPoints;
+	double pos[3];
+	double quat[4];
+};
+
+int main(int argc, char * argv[]) {
+	long passes = 50;
+	if (argc > 1) {
+		passes = std::atol(argv[1]);
+	}
+
+	// Four LEDs on a head band: two at the temples, one up front, one low
+	LedConstellation leds;
+	leds.add(-0.09, 0, 0);
+	leds.add(0.09, 0, 0);
+	leds.add(0, 0.05, 0.04);
+	leds.add(0, -0.04, 0.02);
+
+	// A head swaying and turning in front of the camera, seen in whole
+	// pixels, blobs in no particular order
+	static Frame frames[FRAMES];
+	for (int i = 0; i < FRAMES; ++i) {
+		Frame & f = frames[i];
+		const double t = i / FRAME_RATE;
+		f.pos[0] = 0.1 * std::sin(t);
+		f.pos[1] = 0.05 * std::cos(0.7 * t);
+		f.pos[2] = 0.7 + 0.05 * std::sin(0.3 * t);
+		const double turn[3] = {0.2 * std::sin(0.5 * t), 0.5 * std::sin(0.4 * t), 0.2 * std::cos(0.3 * t)};
+		quatmath::fromRotationVector(f.quat, turn);
+		f.numPoints = 0;
+		for (int led = 0; led < leds.count; ++led) {
+			const int which = (led + i) % leds.count;
+			double p[3];
+			quatmath::rotate(p, f.quat, leds.leds[which]);
+			for (int k = 0; k < 3; ++k) {
+				p[k] += f.pos[k];
+			}
+			double u;
+			double v;
+			if (ircamera::project(p, u, v)) {
+				ircamera::normalize(std::floor(u + 0.5), std::floor(v + 0.5), f.points[f.numPoints++]);
+			}
+		}
+	}
+
+	PnPSolver solver;
+	solver.setConstellation(leds);
+
+	std::vector<double> times;
+	times.reserve(passes * FRAMES);
+	double pos[3];
+	double quat[4];
+	double worstPosition = 0;
+	double worstAngle = 0;
+	long iterations = 0;
+	long failures = 0;
+	long coldSolves = 0;
+	for (long pass = 0; pass < passes; ++pass) {
+		for (int i = 0; i < FRAMES; ++i) {
+			const Frame & f = frames[i];
+			const double start = monotonic::seconds();
+			const bool solved = solver.solve(f.points, f.numPoints, pos, quat);
+			times.push_back(monotonic::seconds() - start);
+			if (!solved) {
+				failures++;
+				continue;
+			}
+			if (solver.wasCold()) {
+				coldSolves++;
+				continue;
+			}
+			iterations += solver.getIterations();
+			double error = 0;
+			for (int k = 0; k < 3; ++k) {
+				error += (pos[k] - f.pos[k]) * (pos[k] - f.pos[k]);
+			}
+			worstPosition = std::max(worstPosition, std::sqrt(error));
+			worstAngle = std::max(worstAngle, quatmath::angleBetween(quat, f.quat));
+		}
+	}
+
+	std::sort(times.begin(), times.end());
+	const double tracked = double(times.size() - failures - coldSolves);
+	const double p50 = times[times.size() / 2];
+	const double p99 = times[std::size_t(times.size() * 0.99)];
+	const double worst = times.back();
+
+	std::cout << "PnPSolver::solve (4 LEDs): " << std::fixed << std::setprecision(2) <<
+		p50 * 1.0e6 << " us p50, " << p99 * 1.0e6 << " us p99, " <<
+		worst * 1.0e6 << " us max over " << times.size() << " frames; " <<
+		std::setprecision(1) << (tracked > 0 ? iterations / tracked : 0) << " iterations/frame when tracking, " <<
+		coldSolves << " cold, " << failures << " failed; worst error " <<
+		std::setprecision(2) << worstPosition * 1000.0 << " mm, " <<
+		worstAngle * 180.0 / 3.14159265358979323846 << " deg" << std::endl;
+	if (p99 > BUDGET || failures > 0) {
+		std::cout << "Over budget of " << BUDGET * 1.0e6 << " us, or failing to solve" << std::endl;
+		return 1;
+	}
+	return 0;
+}
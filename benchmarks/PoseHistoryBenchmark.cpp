@@ -0,0 +1,154 @@
+/**	@file	PoseHistoryBenchmark.cpp
+	@brief	Query rate of pose-at-time lookups, in-process and in shared memory
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "PoseHistory.h"
+#include "SharedPose.h"
+#include "QuaternionMath.h"
+#include "MonotonicClock.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+/// Poses are stamped from this epoch time on, as VRPN report times are
+static const double EPOCH = 1.3e9;
+static const double FRAME_RATE = 100.0;
+/// Query times are precomputed, so only the lookup is timed
+static const int QUERIES = 4096;
+/// A renderer needs far fewer, but lookups must never be what it waits on
+static const double REQUIRED_RATE = 1.0e6;
+
+/// Results go here, so the timed lookups can't be optimized away
+static volatile double g_sink;
+
+/// @brief A head swaying and turning, as in the PnP benchmark
+static void headAt(const double t, double pos[3], double quat[4]) {
+	pos[0] = 0.1 * std::sin(t);
+	pos[1] = 0.05 * std::cos(0.7 * t);
+	pos[2] = 0.7 + 0.05 * std::sin(0.3 * t);
+	const double turn[3] = {0.2 * std::sin(0.5 * t), 0.5 * std::sin(0.4 * t), 0.2 * std::cos(0.3 * t)};
+	quatmath::fromRotationVector(quat, turn);
+}
+
+/// @brief Times spread over [oldest, newest], in a scrambled order
+static void makeQueries(double queries[], const double oldest, const double newest) {
+	unsigned long state = 12345;
+	for (int i = 0; i < QUERIES; ++i) {
+		state = state * 1103515245UL + 12345UL;
+		const double u = double((state >> 8) & 0xffff) / 65535.0;
+		queries[i] = oldest + u * (newest - oldest);
+	}
+}
+
+int main(int argc, char * argv[]) {
+	long passes = 2000;
+	if (argc > 1) {
+		passes = std::atol(argv[1]);
+	}
+
+	// A full history, with a little jitter in the frame times
+	PoseHistory history;
+	static sharedpose::Segment segment;
+	std::memset(&segment, 0, sizeof(segment));
+	const int frames = PoseHistory::CAPACITY + 100;
+	for (int i = 0; i < frames; ++i) {
+		const double t = (i + 0.2 * std::sin(i * 1.7)) / FRAME_RATE;
+		sharedpose::Pose pose;
+		pose.time = EPOCH + t;
+		pose.confidence = 1;
+		headAt(t, pose.pos, pose.quat);
+		history.push(pose.time, pose.pos, pose.quat);
+		sharedpose::write(segment, pose);
+	}
+
+	double oldest;
+	double newest;
+	history.span(oldest, newest);
+	static double queries[QUERIES];
+	makeQueries(queries, oldest, newest);
+
+	// Sanity first: interpolation at 100 Hz should be well under a
+	// millimeter and a tenth of a degree off this motion
+	double worstPosition = 0;
+	double worstAngle = 0;
+	for (int i = 0; i < QUERIES; ++i) {
+		double pos[3];
+		double quat[4];
+		double truePos[3];
+		double trueQuat[4];
+		if (!history.poseAt(queries[i], pos, quat)) {
+			std::cout << "PoseHistory::poseAt missed a time inside its span" << std::endl;
+			return 1;
+		}
+		headAt(queries[i] - EPOCH, truePos, trueQuat);
+		double error = 0;
+		for (int k = 0; k < 3; ++k) {
+			error += (pos[k] - truePos[k]) * (pos[k] - truePos[k]);
+		}
+		worstPosition = std::max(worstPosition, std::sqrt(error));
+		worstAngle = std::max(worstAngle, quatmath::angleBetween(quat, trueQuat));
+	}
+
+	double checksum = 0;
+	double start = monotonic::seconds();
+	for (long pass = 0; pass < passes; ++pass) {
+		for (int i = 0; i < QUERIES; ++i) {
+			double pos[3];
+			double quat[4];
+			history.poseAt(queries[i], pos, quat);
+			checksum += pos[0];
+		}
+	}
+	const double historyRate = passes * double(QUERIES) / (monotonic::seconds() - start);
+
+	const double sharedOldest = segment.poses[segment.published % sharedpose::HISTORY].time;
+	const double sharedNewest = segment.poses[(segment.published - 1) % sharedpose::HISTORY].time;
+	makeQueries(queries, sharedOldest, sharedNewest);
+	start = monotonic::seconds();
+	for (long pass = 0; pass < passes; ++pass) {
+		for (int i = 0; i < QUERIES; ++i) {
+			sharedpose::Pose pose;
+			sharedpose::poseAt(segment, queries[i], pose);
+			checksum += pose.pos[0];
+		}
+	}
+	const double sharedRate = passes * double(QUERIES) / (monotonic::seconds() - start);
+	g_sink = checksum;
+
+	std::cout << "PoseHistory::poseAt (" << PoseHistory::CAPACITY << " poses): " <<
+		std::fixed << std::setprecision(1) << historyRate / 1.0e6 << " M queries/s, " <<
+		std::setprecision(0) << 1.0e9 / historyRate << " ns each; " <<
+		"sharedpose::poseAt (" << sharedpose::HISTORY << " poses): " <<
+		std::setprecision(1) << sharedRate / 1.0e6 << " M queries/s, " <<
+		std::setprecision(0) << 1.0e9 / sharedRate << " ns each; worst error " <<
+		std::setprecision(3) << worstPosition * 1000.0 << " mm, " <<
+		worstAngle * 180.0 / 3.14159265358979323846 << " deg" << std::endl;
+	if (historyRate < REQUIRED_RATE || sharedRate < REQUIRED_RATE) {
+		std::cout << "Under the required " << REQUIRED_RATE / 1.0e6 << " M queries/s" << std::endl;
+		return 1;
+	}
+	return 0;
+}
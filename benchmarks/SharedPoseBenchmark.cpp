@@ -0,0 +1,158 @@
+/**	@file	SharedPoseBenchmark.cpp
+	@brief	Benchmark of pose delivery through shared memory to a same-host reader
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "SharedPoseSink.h"
+#include "SharedPoseReader.h"
+#include "MonotonicClock.h"
+#include "FromString.h"
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+
+// Standard includes
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include <sched.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/// Segment the writer serves, under a name no real tracker uses
+static const char * TRACKER_NAME = "SharedPoseBenchmark";
+
+static double percentile(const std::vector<double> & sorted, const double p) {
+	if (sorted.empty()) {
+		return 0;
+	}
+	std::size_t i = std::size_t(p * sorted.size());
+	return sorted[std::min(i, sorted.size() - 1)];
+}
+
+/// @brief Publish count poses at rate Hz. The benchmark pose carries the
+/// monotonic time it was written in pos[0], which (being system-wide)
+/// the reader process can compare against its own clock.
+static int runWriter(const double rate, const long count) {
+	SharedPoseSink sink;
+	if (!sink.open(TRACKER_NAME)) {
+		return 1;
+	}
+	// Give the reader time to map the segment
+	vrpn_SleepMsecs(200);
+	const double quat[4] = {0, 0, 0, 1};
+	double next = monotonic::seconds();
+	for (long i = 0; i < count; ++i) {
+		// Sleep between poses like the tracker's loop does
+		next += 1.0 / rate;
+		const double wait = next - monotonic::seconds();
+		if (wait > 0) {
+			vrpn_SleepMsecs(wait * 1000.0);
+		}
+		struct timeval now;
+		vrpn_gettimeofday(&now, NULL);
+		const double pos[3] = {monotonic::seconds(), 0, 0};
+		sink.publish(now, pos, quat, 1.0);
+	}
+	// Let the reader see the last one before the segment goes
+	vrpn_SleepMsecs(200);
+	sink.close();
+	return 0;
+}
+
+int main(int argc, char * argv[]) {
+	float rate = 1000;
+	float seconds = 5;
+	for (int i = 1; i < argc; ++i) {
+		const bool haveValue = (i + 1 < argc);
+		bool ok = true;
+		if (std::strcmp(argv[i], "--rate") == 0 && haveValue) {
+			ok = fromString<float>(rate, argv[++i]) && rate > 0;
+		} else if (std::strcmp(argv[i], "--seconds") == 0 && haveValue) {
+			ok = fromString<float>(seconds, argv[++i]) && seconds > 0;
+		} else {
+			ok = false;
+		}
+		if (!ok) {
+			std::cerr << "Usage: " << argv[0] << " [--rate HZ] [--seconds S]" << std::endl;
+			return 1;
+		}
+	}
+	const long count = long(rate * seconds);
+
+	const pid_t writer = fork();
+	if (writer < 0) {
+		std::cerr << "Could not start the writer process" << std::endl;
+		return 1;
+	}
+	if (writer == 0) {
+		_exit(runWriter(rate, count));
+	}
+
+	SharedPoseReader reader;
+	const double deadline = monotonic::seconds() + 2.0;
+	while (!reader.open(TRACKER_NAME)) {
+		if (monotonic::seconds() > deadline) {
+			std::cerr << "Writer never created its segment" << std::endl;
+			waitpid(writer, NULL, 0);
+			return 1;
+		}
+		vrpn_SleepMsecs(1);
+	}
+
+	// Poll the segment, as a render loop wanting the newest pose would,
+	// and time both delivery and each read. Yielding between polls keeps
+	// the writer running on a machine with a single core.
+	std::vector<double> latencies;
+	std::vector<double> reads;
+	latencies.reserve(count);
+	reads.reserve(count);
+	unsigned int seen = reader.published();
+	const double end = monotonic::seconds() + seconds + 1.0;
+	while (long(latencies.size()) < count && monotonic::seconds() < end) {
+		if (reader.published() == seen) {
+			sched_yield();
+			continue;
+		}
+		sharedpose::Pose pose;
+		const double start = monotonic::seconds();
+		const bool read = reader.latest(pose);
+		const double done = monotonic::seconds();
+		seen = reader.published();
+		if (!read) {
+			continue;
+		}
+		reads.push_back(done - start);
+		latencies.push_back(start - pose.pos[0]);
+	}
+	waitpid(writer, NULL, 0);
+
+	std::sort(latencies.begin(), latencies.end());
+	std::sort(reads.begin(), reads.end());
+	std::cout << "Shared memory: " << latencies.size() << " of " << count << " poses seen at " <<
+		rate << " Hz; write-to-read latency " << std::fixed << std::setprecision(2) <<
+		percentile(latencies, 0.5) * 1.0e6 << " us p50, " <<
+		percentile(latencies, 0.99) * 1.0e6 << " us p99, " <<
+		percentile(latencies, 0.999) * 1.0e6 << " us p99.9; read " <<
+		std::setprecision(0) << percentile(reads, 0.5) * 1.0e9 << " ns p50" << std::endl;
+	return 0;
+}
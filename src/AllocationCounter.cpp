@@ -0,0 +1,104 @@
+/**	@file	AllocationCounter.cpp
+	@brief	Implementation of optional counting of heap allocations
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "AllocationCounter.h"
+#include "AtomicOps.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstdlib>
+#include <new>
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+
+#if __cplusplus >= 201103L
+#	define ALLOCATION_THROWS
+#	define ALLOCATION_NOTHROW noexcept
+#else
+#	define ALLOCATION_THROWS throw(std::bad_alloc)
+#	define ALLOCATION_NOTHROW throw()
+#endif
+
+#if defined(_MSC_VER)
+#	define ALLOCATION_THREAD_LOCAL __declspec(thread)
+#else
+#	define ALLOCATION_THREAD_LOCAL __thread
+#endif
+
+static volatile long s_allocations = 0;
+static ALLOCATION_THREAD_LOCAL bool t_ignored = false;
+
+static void * countedAllocate(std::size_t size) {
+	if (!t_ignored) {
+		atomic::increment(&s_allocations);
+	}
+	void * p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void * operator new(std::size_t size) ALLOCATION_THROWS {
+	return countedAllocate(size);
+}
+
+void * operator new[](std::size_t size) ALLOCATION_THROWS {
+	return countedAllocate(size);
+}
+
+void operator delete(void * p) ALLOCATION_NOTHROW {
+	std::free(p);
+}
+
+void operator delete[](void * p) ALLOCATION_NOTHROW {
+	std::free(p);
+}
+
+namespace allocations {
+	bool counted() {
+		return true;
+	}
+
+	unsigned long total() {
+		return atomic::load(&s_allocations);
+	}
+
+	void ignoreThisThread(const bool ignore) {
+		t_ignored = ignore;
+	}
+} // end of allocations namespace
+
+#else // COUNT_HEAP_ALLOCATIONS
+
+namespace allocations {
+	bool counted() {
+		return false;
+	}
+
+	unsigned long total() {
+		return 0;
+	}
+
+	void ignoreThisThread(const bool) {}
+} // end of allocations namespace
+
+#endif // COUNT_HEAP_ALLOCATIONS
@@ -0,0 +1,57 @@
+/** @file	AllocationCounter.h
+	@brief	header for optional counting of heap allocations
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _ALLOCATIONCOUNTER_H
+#define _ALLOCATIONCOUNTER_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+/// @brief When built with COUNT_HEAP_ALLOCATIONS, global operator new is
+/// replaced by one that counts calls, so the loop statistics can show
+/// how many allocations each published pose costs.
+namespace allocations {
+
+/// @addtogroup FreeFunctions Free Functions
+/// @{
+
+	/// @brief Whether this build counts allocations at all.
+	bool counted();
+
+	/// @brief Number of operator new calls so far, in all threads not
+	/// ignored.
+	unsigned long total();
+
+	/// @brief Leave the calling thread's allocations out of total() -
+	/// for a test's own client, sharing the process with the loop it
+	/// watches.
+	void ignoreThisThread(const bool ignore);
+
+/// @}
+
+} // end of allocations namespace
+
+#endif // _ALLOCATIONCOUNTER_H
@@ -0,0 +1,92 @@
+/** @file	AtomicOps.h
+	@brief	header for the few atomic primitives the lock-free queues need
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _ATOMICOPS_H
+#define _ATOMICOPS_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+#if defined(_MSC_VER)
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#endif
+
+// Standard includes
+// - none
+
+namespace atomic {
+
+/// @addtogroup FreeFunctions Free Functions
+/// @{
+
+	/// @brief Full hardware and compiler memory barrier.
+	inline void barrier() {
+#if defined(_MSC_VER)
+		MemoryBarrier();
+#else
+		__sync_synchronize();
+#endif
+	}
+
+	/// @brief Atomically replace *target with value, returning the old value.
+	inline long exchange(volatile long * target, long value) {
+#if defined(_MSC_VER)
+		return InterlockedExchange(target, value);
+#else
+		long old = *target;
+		long seen;
+		while ((seen = __sync_val_compare_and_swap(target, old, value)) != old) {
+			old = seen;
+		}
+		return old;
+#endif
+	}
+
+	/// @brief Atomically add one to *target, returning the new value.
+	inline long increment(volatile long * target) {
+#if defined(_MSC_VER)
+		return InterlockedIncrement(target);
+#else
+		return __sync_add_and_fetch(target, 1);
+#endif
+	}
+
+	/// @brief Read a value published by another thread (acquire).
+	inline long load(volatile long const * source) {
+		const long value = *source;
+		barrier();
+		return value;
+	}
+
+	/// @brief Publish a value to another thread (release).
+	inline void store(volatile long * target, long value) {
+		barrier();
+		*target = value;
+	}
+
+/// @}
+
+} // end of atomic namespace
+
+#endif // _ATOMICOPS_H
@@ -0,0 +1,151 @@
+/**	@file	EventLoop.cpp
+	@brief	Implementation of readiness-driven waiting
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "EventLoop.h"
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+
+// Standard includes
+#include <algorithm>
+#ifdef _WIN32
+#	include <winsock2.h>
+#else
+#	include <unistd.h>
+#	include <fcntl.h>
+#endif
+
+/// Longest we block when no other thread can wake us early.
+const double UNWAKEABLE_MAX_WAIT = 0.01;
+
+EventLoop::EventLoop() :
+		_wakeRead(-1),
+		_wakeWrite(-1) {
+#ifndef _WIN32
+	int fds[2];
+	if (pipe(fds) == 0) {
+		for (int i = 0; i < 2; ++i) {
+			fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+			// Not to be inherited by programs started with system()
+			fcntl(fds[i], F_SETFD, fcntl(fds[i], F_GETFD) | FD_CLOEXEC);
+		}
+		_wakeRead = fds[0];
+		_wakeWrite = fds[1];
+	}
+#endif
+}
+
+EventLoop::~EventLoop() {
+#ifndef _WIN32
+	if (_wakeRead >= 0) {
+		close(_wakeRead);
+		close(_wakeWrite);
+	}
+#endif
+}
+
+void EventLoop::wake() {
+#ifndef _WIN32
+	if (_wakeWrite >= 0) {
+		const char c = 0;
+		// A full pipe already guarantees a wakeup, so ignore failure.
+		ssize_t ret = write(_wakeWrite, &c, 1);
+		(void)ret;
+	}
+#endif
+}
+
+void EventLoop::clearDescriptors() {
+	_fds.clear();
+}
+
+void EventLoop::addDescriptor(int fd) {
+	if (fd >= 0 && std::find(_fds.begin(), _fds.end(), fd) == _fds.end()) {
+		_fds.push_back(fd);
+	}
+}
+
+bool EventLoop::hasDescriptors() const {
+	return !_fds.empty();
+}
+
+bool EventLoop::wait(double maxSeconds) {
+	_failed.clear();
+	if (maxSeconds < 0) {
+		maxSeconds = 0;
+	}
+
+	if (_wakeRead < 0 && maxSeconds > UNWAKEABLE_MAX_WAIT) {
+		maxSeconds = UNWAKEABLE_MAX_WAIT;
+	}
+
+	if (_fds.empty() && _wakeRead < 0) {
+		// Nothing to block on: fall back to a timed sleep.
+		vrpn_SleepMsecs(maxSeconds * 1000.0);
+		return false;
+	}
+
+#ifdef _WIN32
+	fd_set readSet;
+	FD_ZERO(&readSet);
+	for (unsigned int i = 0; i < _fds.size(); ++i) {
+		if (_fds[i] >= 0) {
+			FD_SET(static_cast<SOCKET>(_fds[i]), &readSet);
+		}
+	}
+	if (readSet.fd_count == 0) {
+		// select() refuses empty sets
+		vrpn_SleepMsecs(maxSeconds * 1000.0);
+		return false;
+	}
+	struct timeval timeout;
+	timeout.tv_sec = static_cast<long>(maxSeconds);
+	timeout.tv_usec = static_cast<long>((maxSeconds - timeout.tv_sec) * 1000000.0);
+	return select(0, &readSet, NULL, NULL, &timeout) > 0;
+#else
+	/// Round up so we never wake a hair before a deadline and spin.
+	const int timeoutMsecs = static_cast<int>(maxSeconds * 1000.0 + 0.999);
+	_pollfds.resize(_fds.size() + 1);
+	for (unsigned int i = 0; i < _fds.size(); ++i) {
+		_pollfds[i].fd = _fds[i];
+		_pollfds[i].events = POLLIN;
+		_pollfds[i].revents = 0;
+	}
+	struct pollfd & wakeFd = _pollfds[_fds.size()];
+	wakeFd.fd = _wakeRead;
+	wakeFd.events = POLLIN;
+	wakeFd.revents = 0;
+
+	const bool ready = poll(&(_pollfds[0]), _pollfds.size(), timeoutMsecs) > 0;
+	if (ready && (wakeFd.revents & POLLIN)) {
+		// Drain all pending wake requests at once.
+		char buf[64];
+		while (read(_wakeRead, buf, sizeof(buf)) > 0) {}
+	}
+	for (unsigned int i = 0; ready && i < _fds.size(); ++i) {
+		if (_pollfds[i].revents & (POLLNVAL | POLLERR | POLLHUP)) {
+			// Closed or dead since it was registered: it would wake every
+			// poll from now on, so stop waiting on it and say so
+			_failed.push_back(_fds[i]);
+			_fds[i] = -1;
+		}
+	}
+	return ready;
+#endif
+}
@@ -0,0 +1,79 @@
+/** @file	EventLoop.h
+	@brief	header for readiness-driven waiting in the main loop
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _EVENTLOOP_H
+#define _EVENTLOOP_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <vector>
+#ifndef _WIN32
+#	include <poll.h>
+#endif
+
+/// @brief Blocks the calling thread until one of a set of descriptors
+/// becomes readable or a timeout expires, instead of sleeping blindly.
+class EventLoop {
+	public:
+		EventLoop();
+		~EventLoop();
+
+		/// @name Descriptor registration
+		/// @{
+		void clearDescriptors();
+		void addDescriptor(int fd);
+		bool hasDescriptors() const;
+		/// @brief Descriptors the last wait() found closed, hung up or in
+		/// error: they are not waited on again until added again.
+		const std::vector<int> & getFailedDescriptors() const;
+		/// @}
+
+		/// @brief Wait up to maxSeconds for input on a registered descriptor.
+		/// @returns true if woken by input, false on timeout (or error).
+		bool wait(double maxSeconds);
+
+		/// @brief Make a wait() in progress (or the next one) return
+		/// immediately - safe to call from any thread.
+		void wake();
+
+	protected:
+		std::vector<int> _fds;
+		std::vector<int> _failed;
+		/// Self-pipe used by wake(); -1 where unavailable.
+		int _wakeRead;
+		int _wakeWrite;
+#ifndef _WIN32
+		/// Reused between calls so waiting does not allocate.
+		std::vector<struct pollfd> _pollfds;
+#endif
+};
+
+// -- inline implementations -- //
+
+inline const std::vector<int> & EventLoop::getFailedDescriptors() const {
+	return _failed;
+}
+
+#endif // _EVENTLOOP_H
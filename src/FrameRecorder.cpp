@@ -0,0 +1,358 @@
+/**	@file	FrameRecorder.cpp
+	@brief	Implementation of recording raw Wiimote reports to a memory-mapped log
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "FrameRecorder.h"
+#include "AtomicOps.h"
+
+// Library/third-party includes
+#ifdef _WIN32
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#else
+#	include <sys/types.h>
+#	include <sys/mman.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+// Standard includes
+#include <cstring>
+#include <iostream>
+
+/// Records per mapped chunk: 8 MB, over twenty minutes of one Wiimote
+static const unsigned long CHUNK_RECORDS = 131072;
+static const unsigned long CHUNK_BYTES = CHUNK_RECORDS * irlog::RECORD_SIZE;
+
+/// @name States of the next chunk
+/// @{
+static const long NEXT_NONE = 0;
+static const long NEXT_READY = 1;
+static const long NEXT_FAILED = 2;
+/// @}
+
+/// @brief Round a channel value to a camera coordinate, or NO_POINT
+static inline vrpn_uint16 toPixel(const double value) {
+	if (value < 0) {
+		return vrpn_uint16(irlog::NO_POINT);
+	}
+	if (value >= irlog::NO_POINT) {
+		return vrpn_uint16(irlog::NO_POINT - 1);
+	}
+	return vrpn_uint16(value + 0.5);
+}
+
+static void growthThread(vrpn_ThreadData & data) {
+	static_cast<FrameRecorder*>(data.pvUD)->runGrowth();
+}
+
+FrameRecorder::FrameRecorder() :
+		_header(NULL),
+		_chunk(NULL),
+		_chunkFirst(0),
+		_frames(0),
+		_next(NULL),
+		_nextFirst(0),
+		_nextRequested(false),
+		_nextState(NEXT_NONE),
+		_retired(NULL),
+		_growthWork(0),
+		_growthThread(NULL),
+		_growthQuit(0),
+		_growthFinished(1),
+#ifdef _WIN32
+		_file(INVALID_HANDLE_VALUE),
+		_mapping(NULL) {
+#else
+		_fd(-1) {
+#endif
+}
+
+FrameRecorder::~FrameRecorder() {
+	close();
+}
+
+bool FrameRecorder::open(const std::string & filename) {
+	close();
+	_filename = filename;
+	_frames = 0;
+
+#ifdef _WIN32
+	_file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+		NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (_file == INVALID_HANDLE_VALUE) {
+		std::cerr << "Could not create recording " << filename << std::endl;
+		return false;
+	}
+#else
+	_fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (_fd < 0) {
+		std::cerr << "Could not create recording " << filename << std::endl;
+		return false;
+	}
+#endif
+
+	// The first chunk brings the header region with it, and is mapped
+	// here: later ones are the helper thread's job.
+	_chunk = mapChunk(0);
+	_chunkFirst = 0;
+#ifdef _WIN32
+	if (_chunk) {
+		_header = static_cast<irlog::Header *>(MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, irlog::HEADER_SIZE));
+	}
+#else
+	if (_chunk) {
+		void * header = mmap(NULL, irlog::HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+		_header = (header == MAP_FAILED) ? NULL : static_cast<irlog::Header *>(header);
+	}
+#endif
+	if (!_header || !startGrowth()) {
+		if (_chunk && !_header) {
+			std::cerr << "Could not map recording " << filename << std::endl;
+		}
+		close();
+		return false;
+	}
+	std::memset(_header, 0, sizeof(irlog::Header));
+	std::strncpy(_header->magic, irlog::magic(), sizeof(_header->magic));
+	_header->version = irlog::VERSION;
+	_header->headerSize = irlog::HEADER_SIZE;
+	_header->recordSize = irlog::RECORD_SIZE;
+	_header->frames = 0;
+	return true;
+}
+
+char * FrameRecorder::mapChunk(const unsigned long first) {
+	const unsigned long long offset = irlog::HEADER_SIZE +
+		(unsigned long long)(first) * irlog::RECORD_SIZE;
+	const unsigned long long end = offset + CHUNK_BYTES;
+	char * chunk = NULL;
+
+#ifdef _WIN32
+	// A mapping can't outgrow the size it was created with: make a new
+	// one for the larger file. Existing views keep the old one alive.
+	if (_mapping) {
+		CloseHandle(_mapping);
+	}
+	_mapping = CreateFileMappingA(_file, NULL, PAGE_READWRITE,
+		DWORD(end >> 32), DWORD(end & 0xFFFFFFFF), NULL);
+	if (!_mapping) {
+		std::cerr << "Could not grow recording " << _filename << std::endl;
+		return NULL;
+	}
+	chunk = static_cast<char *>(MapViewOfFile(_mapping, FILE_MAP_WRITE,
+		DWORD(offset >> 32), DWORD(offset & 0xFFFFFFFF), CHUNK_BYTES));
+#else
+	// Reserve the blocks now, where we can: a write through the mapping
+	// to a sparse file on a full disk would be a SIGBUS, not an error.
+#	ifdef __linux__
+	const int err = posix_fallocate(_fd, 0, off_t(end));
+#	else
+	const int err = ftruncate(_fd, off_t(end));
+#	endif
+	if (err != 0) {
+		std::cerr << "Could not grow recording " << _filename << std::endl;
+		return NULL;
+	}
+	void * mapped = mmap(NULL, CHUNK_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, off_t(offset));
+	chunk = (mapped == MAP_FAILED) ? NULL : static_cast<char *>(mapped);
+#endif
+
+	if (!chunk) {
+		std::cerr << "Could not map recording " << _filename << std::endl;
+	}
+	return chunk;
+}
+
+void FrameRecorder::unmapChunk(char * chunk) {
+	if (!chunk) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(chunk);
+#else
+	munmap(chunk, CHUNK_BYTES);
+#endif
+}
+
+bool FrameRecorder::startGrowth() {
+	_next = NULL;
+	_nextRequested = false;
+	_retired = NULL;
+	atomic::store(&_nextState, NEXT_NONE);
+	atomic::store(&_growthQuit, 0);
+	atomic::store(&_growthFinished, 0);
+
+	vrpn_ThreadData td;
+	td.pvUD = this;
+	td.ps = NULL;
+	_growthThread = new vrpn_Thread(growthThread, td);
+	if (!_growthThread->go()) {
+		std::cerr << "Could not start the recording thread!" << std::endl;
+		delete _growthThread;
+		_growthThread = NULL;
+		atomic::store(&_growthFinished, 1);
+		return false;
+	}
+	return true;
+}
+
+void FrameRecorder::stopGrowth() {
+	if (!_growthThread) {
+		return;
+	}
+	atomic::store(&_growthQuit, 1);
+	_growthWork.v();
+	while (!atomic::load(&_growthFinished)) {
+		vrpn_SleepMsecs(1);
+	}
+	delete _growthThread;
+	_growthThread = NULL;
+
+	// Whatever the helper left behind is ours again
+	unmapChunk(_retired);
+	_retired = NULL;
+	if (atomic::load(&_nextState) == NEXT_READY) {
+		unmapChunk(_next);
+	}
+	_next = NULL;
+	atomic::store(&_nextState, NEXT_NONE);
+}
+
+void FrameRecorder::runGrowth() {
+	while (true) {
+		_growthWork.p();
+		if (atomic::load(&_growthQuit)) {
+			break;
+		}
+		// A swap hands over the old chunk; a request, made once the
+		// current chunk is half full, asks for the one after it.
+		if (_retired) {
+			unmapChunk(_retired);
+			_retired = NULL;
+		}
+		if (_nextRequested && atomic::load(&_nextState) == NEXT_NONE) {
+			_next = mapChunk(_nextFirst);
+			atomic::store(&_nextState, _next ? NEXT_READY : NEXT_FAILED);
+		}
+	}
+	atomic::store(&_growthFinished, 1);
+}
+
+bool FrameRecorder::record(const int station, const struct timeval & time,
+		const double channels[], const int numChannels) {
+	if (!_header || numChannels < WiimoteSource::CHANNEL_COUNT) {
+		return false;
+	}
+	const unsigned long used = _frames - _chunkFirst;
+	if (used >= CHUNK_RECORDS / 2 && !_nextRequested) {
+		_nextFirst = _chunkFirst + CHUNK_RECORDS;
+		_nextRequested = true;
+		_growthWork.v();
+	}
+	if (used >= CHUNK_RECORDS) {
+		const long state = atomic::load(&_nextState);
+		if (state == NEXT_FAILED) {
+			// Out of disk or address space: stop rather than retry every frame
+			close();
+			return false;
+		}
+		if (state != NEXT_READY) {
+			// The helper is over ten minutes behind: drop the report
+			// rather than wait for it
+			return false;
+		}
+		_retired = _chunk;
+		_chunk = _next;
+		_chunkFirst = _nextFirst;
+		_next = NULL;
+		_nextRequested = false;
+		atomic::store(&_nextState, NEXT_NONE);
+		_growthWork.v();
+	}
+
+	irlog::Record * r = reinterpret_cast<irlog::Record *>(_chunk +
+		(_frames - _chunkFirst) * irlog::RECORD_SIZE);
+	r->seconds = vrpn_int32(time.tv_sec);
+	r->microseconds = vrpn_int32(time.tv_usec);
+	r->station = vrpn_uint16(station);
+	r->battery = vrpn_float32(channels[WiimoteSource::CHANNEL_BATTERY]);
+	for (int i = 0; i < 3; ++i) {
+		r->accel[i] = vrpn_float32(channels[WiimoteSource::CHANNEL_ACCEL + i]);
+	}
+	vrpn_uint16 points = 0;
+	for (int p = 0; p < WiimoteSource::IR_POINTS; ++p) {
+		const double * blob = channels + WiimoteSource::CHANNEL_IR + 3 * p;
+		for (int i = 0; i < 3; ++i) {
+			r->ir[p][i] = toPixel(blob[i]);
+		}
+		if (r->ir[p][0] != irlog::NO_POINT) {
+			points++;
+		}
+	}
+	r->points = points;
+
+	_frames++;
+	_header->frames = vrpn_uint32(_frames);
+	return true;
+}
+
+void FrameRecorder::close() {
+	const unsigned long long size = irlog::HEADER_SIZE +
+		(unsigned long long)(_frames) * irlog::RECORD_SIZE;
+	stopGrowth();
+	unmapChunk(_chunk);
+	_chunk = NULL;
+
+#ifdef _WIN32
+	if (_header) {
+		UnmapViewOfFile(_header);
+		_header = NULL;
+	}
+	if (_mapping) {
+		CloseHandle(_mapping);
+		_mapping = NULL;
+	}
+	if (_file != INVALID_HANDLE_VALUE) {
+		// Trim the unused part of the last chunk
+		LARGE_INTEGER end;
+		end.QuadPart = LONGLONG(size);
+		SetFilePointerEx(_file, end, NULL, FILE_BEGIN);
+		SetEndOfFile(_file);
+		CloseHandle(_file);
+		_file = INVALID_HANDLE_VALUE;
+		std::cout << "Recorded " << _frames << " Wiimote reports to " << _filename << std::endl;
+	}
+#else
+	if (_header) {
+		munmap(_header, irlog::HEADER_SIZE);
+		_header = NULL;
+	}
+	if (_fd >= 0) {
+		// Trim the unused part of the last chunk
+		if (ftruncate(_fd, off_t(size)) != 0) {
+			std::cerr << "Could not trim recording " << _filename << std::endl;
+		}
+		::close(_fd);
+		_fd = -1;
+		std::cout << "Recorded " << _frames << " Wiimote reports to " << _filename << std::endl;
+	}
+#endif
+}
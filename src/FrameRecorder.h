@@ -0,0 +1,123 @@
+/** @file	FrameRecorder.h
+	@brief	header for recording raw Wiimote reports to a memory-mapped log
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _FRAMERECORDER_H
+#define _FRAMERECORDER_H
+
+// Internal Includes
+#include "IrLog.h"
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+#include <vrpn_Thread.h>
+
+// Standard includes
+#include <cstddef>
+#include <string>
+
+/// @brief Appends every Wiimote report it is given to an irlog file.
+///
+/// The file is grown a chunk at a time, with its disk space reserved up
+/// front where the platform allows, and written through a memory mapping:
+/// recording a report is a copy into memory, never a write() call, and
+/// the kernel flushes pages in the background. A helper thread grows the
+/// file and maps the next chunk once the current one is half full, and
+/// unmaps the old one, so moving on to the next chunk only swaps pointers.
+class FrameRecorder {
+	public:
+		FrameRecorder();
+		~FrameRecorder();
+
+		/// @brief Start a new log, replacing any file of that name.
+		bool open(const std::string & filename);
+		/// @brief Finish the log, trimming it to the records written.
+		void close();
+		bool isOpen() const;
+
+		/// @brief Append a report in the vrpn_WiiMote channel layout.
+		/// @returns false if it could not be recorded.
+		bool record(const int station, const struct timeval & time,
+			const double channels[], const int numChannels);
+
+		unsigned long getFrameCount() const;
+		const std::string & getFilename() const;
+
+		/// @brief Body of the helper thread: maps chunks ahead of the
+		/// writer until close().
+		void runGrowth();
+
+	protected:
+		/// @brief Grow the file to hold the chunk starting at record
+		/// first, and map it.
+		/// @returns the mapping, or NULL on failure.
+		char * mapChunk(const unsigned long first);
+		void unmapChunk(char * chunk);
+		bool startGrowth();
+		void stopGrowth();
+
+		std::string _filename;
+		irlog::Header * _header;
+		char * _chunk;
+		/// Index of the first record in the mapped chunk
+		unsigned long _chunkFirst;
+		unsigned long _frames;
+
+		/// @name Handed between record() and the helper thread
+		/// @{
+		/// Next chunk, valid once _nextState is NEXT_READY
+		char * _next;
+		unsigned long _nextFirst;
+		/// Whether the next chunk has been asked for since the last swap
+		bool _nextRequested;
+		volatile long _nextState;
+		/// Chunk swapped out, for the helper to unmap
+		char * _retired;
+		vrpn_Semaphore _growthWork;
+		vrpn_Thread * _growthThread;
+		volatile long _growthQuit;
+		volatile long _growthFinished;
+		/// @}
+
+		/// @name Platform file and mapping handles
+		/// @{
+#ifdef _WIN32
+		void * _file;
+		void * _mapping;
+#else
+		int _fd;
+#endif
+		/// @}
+};
+
+// -- inline implementations -- //
+
+inline bool FrameRecorder::isOpen() const {
+	return _header != NULL;
+}
+
+inline unsigned long FrameRecorder::getFrameCount() const {
+	return _frames;
+}
+
+inline const std::string & FrameRecorder::getFilename() const {
+	return _filename;
+}
+
+#endif // _FRAMERECORDER_H
@@ -21,7 +21,7 @@
 // - none
 
 // Library/third-party includes
-#include <FL/Enumerations.H>
+// - none
 
 // Standard includes
 #include <string>
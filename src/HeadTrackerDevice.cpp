@@ -0,0 +1,402 @@
+/**	@file	HeadTrackerDevice.cpp
+	@brief	Implementation of the head tracker server device with an in-process tap
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "HeadTrackerDevice.h"
+#include "MonotonicClock.h"
+#include "IrCamera.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <algorithm>
+
+/// Rate the base class is built with: higher than we ever call mainloop(),
+/// so it reports whenever we do and the schedule is all ours.
+static const float BASE_UPDATE_RATE = 2000.0f;
+
+/// How long before a display deadline its report is sent, to reach a
+/// client on this host in time
+static const double DISPLAY_LEAD = 0.001;
+
+HeadTrackerDevice::HeadTrackerDevice(const char * name,
+		vrpn_Connection * trackercon,
+		const char * wiimote,
+		float publish_rate,
+		bool adaptive,
+		float led_spacing) :
+		vrpn_Tracker_WiimoteHead(name, trackercon, wiimote, BASE_UPDATE_RATE, led_spacing),
+		_observer(NULL),
+		_metrics(NULL),
+		_frameArrivedAt(0),
+		_builtSpacing(led_spacing),
+		_positionScale(1.0),
+		_period(1.0 / publish_rate),
+		_adaptive(adaptive),
+		_newFrame(false),
+		_displayPeriod(0),
+		_displayPhase(0),
+		_filter(),
+		_fusion(),
+		_confidenceServer(new vrpn_Analog_Server(name, trackercon, CONFIDENCE_CHANNELS)),
+		_confidence(0),
+		_pnp(),
+		_numPoints(0),
+		_pnpSolved(false),
+		_predictor(),
+		_predictionHorizon(0),
+		_reportIsFresh(false),
+		_reported(false) {
+	vrpn_gettimeofday(&_nextDue, NULL);
+	_epoch = _nextDue;
+	_lastFrame = _nextDue;
+	_deadline = _nextDue;
+	_sendingFor = _nextDue;
+	_baseTimestamp = _nextDue;
+	for (int i = 0; i < 3; ++i) {
+		_fixPos[i] = _pnpPos[i] = 0;
+	}
+	_fixQuat[0] = _fixQuat[1] = _fixQuat[2] = 0;
+	_fixQuat[3] = 1;
+	std::copy(_fixQuat, _fixQuat + 4, _pnpQuat);
+}
+
+HeadTrackerDevice::~HeadTrackerDevice() {
+	delete _confidenceServer;
+}
+
+void HeadTrackerDevice::mainloop() {
+	struct timeval now;
+	vrpn_gettimeofday(&now, NULL);
+	const bool due = untilDue(now) <= 0;
+	if (!due) {
+		// Keep answering pings between publications
+		server_mainloop();
+		_confidenceServer->mainloop();
+		return;
+	}
+	_reportIsFresh = _newFrame;
+	_newFrame = false;
+
+	if (_displayPeriod > 0) {
+		_sendingFor = _deadline;
+		_deadline = nextDeadline(vrpn_TimevalSum(_sendingFor, vrpn_MsecsTimeval(1)));
+		if (vrpn_TimevalGreater(now, _deadline)) {
+			// Missed some: skip to the next we can make
+			_deadline = nextDeadline(now);
+		}
+	}
+
+	// Advance the clock by whole periods so a fixed rate doesn't drift,
+	// but don't try to catch up after a stall.
+	_nextDue = vrpn_TimevalSum(_nextDue, vrpn_MsecsTimeval(_period * 1000.0));
+	if (vrpn_TimevalDuration(now, _nextDue) > 0 || _adaptive) {
+		_nextDue = vrpn_TimevalSum(now, vrpn_MsecsTimeval(_period * 1000.0));
+	}
+
+	_reported = false;
+	vrpn_Tracker_WiimoteHead::mainloop();
+	if (_reported) {
+		// The base class packs the pose with timestamp after encoding
+		// it, so a deadline stamp can only come off now
+		timestamp = _baseTimestamp;
+	}
+	_confidenceServer->mainloop();
+	if (_reported && _predictionHorizon > 0) {
+		reportPrediction(now);
+	}
+}
+
+void HeadTrackerDevice::reportPrediction(const struct timeval & now) {
+	// Aim at when this report is sent plus the horizon, so resampling
+	// age is made up for as well.
+	const double target = vrpn_TimevalDuration(now, _epoch) + _predictionHorizon;
+	vrpn_float64 predictedPos[3];
+	vrpn_float64 predictedQuat[4];
+	if (!_predictor.predict(target, predictedPos, predictedQuat)) {
+		return;
+	}
+
+	vrpn_float64 solvedPos[3];
+	vrpn_float64 solvedQuat[4];
+	for (int i = 0; i < 3; ++i) {
+		solvedPos[i] = pos[i];
+		pos[i] = predictedPos[i];
+	}
+	for (int i = 0; i < 4; ++i) {
+		solvedQuat[i] = d_quat[i];
+		d_quat[i] = predictedQuat[i];
+	}
+	d_sensor = PREDICTED_SENSOR;
+
+	// Straight to the base encoder: this is not a pose to observe
+	char msgbuf[1000];
+	const int len = vrpn_Tracker_WiimoteHead::encode_to(msgbuf);
+	if (d_connection && d_connection->pack_message(len, timestamp,
+			position_m_id, d_sender_id, msgbuf, vrpn_CONNECTION_LOW_LATENCY)) {
+		std::cerr << "HeadTrackerDevice: cannot write predicted pose message" << std::endl;
+	}
+
+	d_sensor = RAW_SENSOR;
+	for (int i = 0; i < 3; ++i) {
+		pos[i] = solvedPos[i];
+	}
+	for (int i = 0; i < 4; ++i) {
+		d_quat[i] = solvedQuat[i];
+	}
+}
+
+void HeadTrackerDevice::setObserver(TrackerObserver * observer) {
+	_observer = observer;
+}
+
+void HeadTrackerDevice::setLEDSpacing(float led_spacing) {
+	_positionScale = led_spacing / _builtSpacing;
+}
+
+void HeadTrackerDevice::setPublication(float publish_rate, bool adaptive) {
+	_period = 1.0 / publish_rate;
+	_adaptive = adaptive;
+	vrpn_gettimeofday(&_nextDue, NULL);
+}
+
+void HeadTrackerDevice::setDisplaySync(double period, double phase) {
+	_displayPeriod = period;
+	_displayPhase = phase;
+	if (period > 0) {
+		struct timeval now;
+		vrpn_gettimeofday(&now, NULL);
+		_deadline = nextDeadline(now);
+	}
+}
+
+struct timeval HeadTrackerDevice::nextDeadline(const struct timeval & now) const {
+	// Whole periods since the phase offset, counted on from the last
+	// whole second so the arithmetic keeps microsecond precision
+	struct timeval base;
+	base.tv_sec = now.tv_sec;
+	base.tv_usec = 0;
+	const double sinceBase = now.tv_usec / 1.0e6 + DISPLAY_LEAD;
+	const double baseOffset = std::fmod(now.tv_sec - _displayPhase, _displayPeriod);
+	const double periods = std::floor((sinceBase + baseOffset) / _displayPeriod) + 1;
+	return vrpn_TimevalSum(base,
+		vrpn_MsecsTimeval((periods * _displayPeriod - baseOffset) * 1000.0));
+}
+
+void HeadTrackerDevice::setPrediction(double horizon, PredictionModel model) {
+	if (model != _predictor.getModel()) {
+		_predictor.reset();
+	}
+	_predictor.setModel(model);
+	_predictionHorizon = horizon;
+}
+
+void HeadTrackerDevice::setSmoothing(const FilterParameters & params) {
+	_filter.setParameters(params);
+}
+
+void HeadTrackerDevice::setConstellation(const LedConstellation & constellation) {
+	if (constellation == _pnp.getConstellation()) {
+		// Keep tracking from the last pose
+		return;
+	}
+	_pnp.setConstellation(constellation);
+	_pnpSolved = false;
+	_fusion.setPointsNeeded(constellation.usable() ? int(LedConstellation::MIN_LEDS) : 2);
+}
+
+void HeadTrackerDevice::setCoastTime(double seconds) {
+	_fusion.setCoastTime(seconds);
+}
+
+void HeadTrackerDevice::setMetrics(StageMetrics * metrics) {
+	_metrics = metrics;
+}
+
+void HeadTrackerDevice::frameArrived(const struct timeval & frameTime,
+		const double channels[], int numChannels) {
+	_newFrame = true;
+	_lastFrame = frameTime;
+	_fusion.frameArrived(vrpn_TimevalDuration(frameTime, _epoch), channels, numChannels);
+	if (_pnp.getConstellation().usable()) {
+		// Unseen points are reported as -1
+		_numPoints = 0;
+		for (int i = 0; i < WiimoteSource::IR_POINTS; ++i) {
+			const int x = WiimoteSource::CHANNEL_IR + 3 * i;
+			if (x + 1 < numChannels && channels[x] >= 0) {
+				ircamera::normalize(channels[x], channels[x + 1], _points[_numPoints]);
+				_numPoints++;
+			}
+		}
+	}
+	if (_metrics) {
+		_frameArrivedAt = monotonic::seconds();
+	}
+}
+
+double HeadTrackerDevice::untilDue(const struct timeval & now) const {
+	if (_displayPeriod > 0) {
+		const double until = vrpn_TimevalDuration(_deadline, now) - DISPLAY_LEAD;
+		return until > 0 ? until : 0;
+	}
+	if (_adaptive && _newFrame) {
+		return 0;
+	}
+	const double until = vrpn_TimevalDuration(_nextDue, now);
+	return until > 0 ? until : 0;
+}
+
+int HeadTrackerDevice::encode_to(char * buf) {
+	const bool constellation = _pnp.getConstellation().usable();
+	if (constellation && _reportIsFresh) {
+		solveConstellation();
+	}
+	const double encodeStart = _metrics ? monotonic::seconds() : 0;
+	if (_metrics && _reportIsFresh) {
+		_metrics->stages[STAGE_SOLVE].record(encodeStart - _frameArrivedAt);
+	}
+
+	// Work on this report only, leaving the base class' own state alone.
+	vrpn_float64 computedPos[3];
+	vrpn_float64 computedQuat[4];
+	for (int i = 0; i < 3; ++i) {
+		computedPos[i] = pos[i];
+	}
+	for (int i = 0; i < 4; ++i) {
+		computedQuat[i] = d_quat[i];
+	}
+
+	if (constellation) {
+		for (int i = 0; i < 3; ++i) {
+			pos[i] = _pnpPos[i];
+		}
+		for (int i = 0; i < 4; ++i) {
+			d_quat[i] = _pnpQuat[i];
+		}
+	} else if (_positionScale != 1.0) {
+		// The head distance, and so every position component, is
+		// proportional to the LED spacing; orientation does not depend
+		// on it.
+		for (int i = 0; i < 3; ++i) {
+			pos[i] *= _positionScale;
+		}
+	}
+
+	// Only a pose solved from a new frame tells us about motion: a
+	// resampled report repeats the last output rather than filtering the
+	// same input twice.
+	const bool fresh = _reportIsFresh;
+	_reportIsFresh = false;
+	const double frameTime = vrpn_TimevalDuration(_lastFrame, _epoch);
+	if (!_fusion.hasFix()) {
+		// Whatever the base class made of too few points is no pose:
+		// nothing from this frame reaches the filter or the predictor.
+		coast(frameTime);
+	} else {
+		if (_filter.getParameters().enabled()) {
+			if (fresh || !_filter.last(pos, d_quat)) {
+				_filter.filter(frameTime, pos, d_quat);
+			}
+		}
+		if (fresh) {
+			_predictor.addSample(frameTime, pos, d_quat);
+			_fusion.fixUsed(frameTime);
+		}
+		for (int i = 0; i < 3; ++i) {
+			_fixPos[i] = pos[i];
+		}
+		for (int i = 0; i < 4; ++i) {
+			_fixQuat[i] = d_quat[i];
+		}
+	}
+
+	_baseTimestamp = timestamp;
+	if (_displayPeriod > 0) {
+		aimAtDeadline(frameTime);
+	}
+
+	_confidence = _fusion.getConfidence(frameTime);
+	if (_observer) {
+		_observer->poseReported(timestamp, pos, d_quat);
+	}
+	_reported = true;
+	const int len = vrpn_Tracker_WiimoteHead::encode_to(buf);
+	reportConfidence(frameTime);
+
+	for (int i = 0; i < 3; ++i) {
+		pos[i] = computedPos[i];
+	}
+	for (int i = 0; i < 4; ++i) {
+		d_quat[i] = computedQuat[i];
+	}
+	if (_metrics) {
+		_metrics->stages[STAGE_ENCODE].record(monotonic::seconds() - encodeStart);
+	}
+	return len;
+}
+
+void HeadTrackerDevice::solveConstellation() {
+	_pnpSolved = _pnp.solve(_points, _numPoints, _pnpPos, _pnpQuat);
+	if (!_pnpSolved) {
+		_fusion.fixFailed();
+	}
+}
+
+void HeadTrackerDevice::coast(const double frameTime) {
+	double target;
+	if (!_fusion.coastTarget(frameTime, target)) {
+		// Never had a fix: nothing better to offer than the base pose
+		return;
+	}
+	if (!_predictor.predict(target, pos, d_quat)) {
+		for (int i = 0; i < 3; ++i) {
+			pos[i] = _fixPos[i];
+		}
+		for (int i = 0; i < 4; ++i) {
+			d_quat[i] = _fixQuat[i];
+		}
+	}
+}
+
+void HeadTrackerDevice::aimAtDeadline(const double frameTime) {
+	const double deadline = vrpn_TimevalDuration(_sendingFor, _epoch);
+	if (_fusion.hasFix()) {
+		// A coasting pose is already carried on as far as it should go
+		vrpn_float64 predictedPos[3];
+		vrpn_float64 predictedQuat[4];
+		if (_predictor.predict(deadline, predictedPos, predictedQuat)) {
+			std::copy(predictedPos, predictedPos + 3, pos);
+			std::copy(predictedQuat, predictedQuat + 4, d_quat);
+		}
+	}
+	timestamp = _sendingFor;
+	if (_metrics) {
+		_metrics->stages[STAGE_DISPLAY].record(deadline - frameTime);
+	}
+}
+
+void HeadTrackerDevice::reportConfidence(const double frameTime) {
+	vrpn_float64 * channels = _confidenceServer->channels();
+	channels[CONFIDENCE_CHANNEL] = _confidence;
+	channels[SINCE_FIX_CHANNEL] = _fusion.sinceFix(frameTime);
+	_confidenceServer->report_changes(vrpn_CONNECTION_LOW_LATENCY, _baseTimestamp);
+}
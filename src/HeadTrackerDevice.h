@@ -0,0 +1,244 @@
+/** @file	HeadTrackerDevice.h
+	@brief	header for the head tracker server device with an in-process tap
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _HEADTRACKERDEVICE_H
+#define _HEADTRACKERDEVICE_H
+
+// Internal Includes
+#include "TrackerObserver.h"
+#include "PosePredictor.h"
+#include "PoseFilter.h"
+#include "OcclusionFusion.h"
+#include "PnPSolver.h"
+#include "StageMetrics.h"
+#include "WiimoteSource.h"
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+#include <vrpn_Tracker_WiimoteHead.h>
+#include <vrpn_Analog.h>
+
+// Standard includes
+// - none
+
+/// @brief vrpn_Tracker_WiimoteHead that also hands each pose it reports
+/// to an in-process TrackerObserver, and whose LED spacing and publication
+/// schedule can be changed without rebuilding it.
+///
+/// The base class is built to report on every mainloop() call; this class
+/// decides when to make that call - at a fixed rate, resampling the latest
+/// IR frame, or (adaptive) as soon as a new frame has arrived.
+///
+/// With smoothing enabled, every pose sent (and tapped) is the output of
+/// a PoseFilter fed with the solved pose of each new frame.
+///
+/// With a prediction horizon set, each report on sensor 0 (the solved
+/// pose) is followed by one on PREDICTED_SENSOR, extrapolated that far
+/// past the moment it is sent.
+///
+/// Given a constellation of three or four LEDs, every pose is solved by
+/// PnPSolver from the blobs seen instead, for full 6-DOF tracking in the
+/// camera's frame (see IrCamera.h) - LED spacing and the base class'
+/// two-LED solution then play no part.
+///
+/// Synced to a display, reports go out on the display's clock instead:
+/// DISPLAY_LEAD before each deadline (a multiple of the display period
+/// past the phase offset, on the system clock), with the pose predicted
+/// to that deadline and stamped with it. The age at each deadline of the
+/// newest frame behind the pose is timed into STAGE_DISPLAY.
+///
+/// While too few LEDs are seen the pose coasts on from the last
+/// fixes for up to the coast time, then holds. A vrpn_Analog under the
+/// tracker's own name carries the confidence in each pose
+/// (CONFIDENCE_CHANNEL) and the seconds since the last IR fix
+/// (SINCE_FIX_CHANNEL).
+class HeadTrackerDevice : public vrpn_Tracker_WiimoteHead {
+	public:
+		enum {
+			RAW_SENSOR = 0,
+			PREDICTED_SENSOR = 1
+		};
+
+		/// @brief Channels of the confidence analog
+		enum {
+			CONFIDENCE_CHANNEL = 0,
+			SINCE_FIX_CHANNEL = 1,
+			CONFIDENCE_CHANNELS = 2
+		};
+
+		HeadTrackerDevice(const char * name,
+			vrpn_Connection * trackercon,
+			const char * wiimote,
+			float publish_rate,
+			bool adaptive,
+			float led_spacing);
+		virtual ~HeadTrackerDevice();
+
+		/// @brief Publish (and compute) a pose if one is due.
+		virtual void mainloop();
+
+		/// @brief Set the observer to tap reports, or NULL for none.
+		void setObserver(TrackerObserver * observer);
+
+		/// @brief Time the solve and encode stages into metrics, or NULL
+		/// for no timing.
+		void setMetrics(StageMetrics * metrics);
+
+		/// @brief Change the LED spacing in place - positions reported
+		/// from now on are for the new spacing.
+		void setLEDSpacing(float led_spacing);
+
+		/// @brief Change the publication schedule in place.
+		void setPublication(float publish_rate, bool adaptive);
+
+		/// @brief Publish for a display refreshing every period seconds,
+		/// its deadlines phase seconds past each multiple of the period
+		/// since the epoch - or on the publication schedule, given a
+		/// period of 0.
+		void setDisplaySync(double period, double phase);
+
+		/// @brief Set how far ahead to predict (seconds), 0 to stop
+		/// publishing PREDICTED_SENSOR.
+		void setPrediction(double horizon, PredictionModel model);
+
+		/// @brief Change the pose smoothing in place.
+		void setSmoothing(const FilterParameters & params);
+
+		/// @brief Solve for the LEDs of a usable constellation, or go back
+		/// to the two-LED bar given an empty one.
+		void setConstellation(const LedConstellation & constellation);
+
+		/// @brief Set the longest LED occlusion (seconds) to coast through.
+		void setCoastTime(double seconds);
+
+		/// @brief Confidence (0 to 1) in the last pose sent.
+		double getConfidence() const;
+
+		/// @brief Tell the device a new Wiimote frame, stamped frameTime,
+		/// has been delivered - for adaptive publication, prediction and
+		/// coasting through occlusion.
+		void frameArrived(const struct timeval & frameTime,
+			const double channels[], int numChannels);
+
+		/// @brief Seconds until the next scheduled publication (or, in
+		/// adaptive mode, keep-alive) is due - 0 if overdue.
+		double untilDue(const struct timeval & now) const;
+
+		/// @brief Called by the base class for every pose it sends.
+		virtual int encode_to(char * buf);
+
+	protected:
+		/// @brief Send the extrapolated pose on PREDICTED_SENSOR.
+		void reportPrediction(const struct timeval & now);
+
+		/// @brief Solve the constellation from the newest frame's blobs.
+		void solveConstellation();
+
+		/// @brief Replace the pose with one carried on from the last fixes.
+		void coast(const double frameTime);
+
+		/// @brief Send the confidence in the pose just encoded.
+		void reportConfidence(const double frameTime);
+
+		/// @brief First display deadline far enough after now to be
+		/// published for in time
+		struct timeval nextDeadline(const struct timeval & now) const;
+		/// @brief Predict the pose being encoded to the display deadline
+		/// it is sent for, and stamp it with that - only until mainloop()
+		/// has sent it
+		void aimAtDeadline(const double frameTime);
+
+		TrackerObserver * _observer;
+		StageMetrics * _metrics;
+		/// Monotonic time the latest frame was delivered
+		double _frameArrivedAt;
+		/// Spacing the base class computes positions with
+		const double _builtSpacing;
+		/// Current spacing divided by _builtSpacing
+		double _positionScale;
+
+		/// @name Publication schedule
+		/// @{
+		double _period;
+		bool _adaptive;
+		bool _newFrame;
+		struct timeval _nextDue;
+		/// @}
+
+		/// @name Display-synchronized schedule
+		/// @{
+		/// Seconds, 0 when not synced
+		double _displayPeriod;
+		double _displayPhase;
+		/// Deadline of the next report, and of the one being sent
+		struct timeval _deadline;
+		struct timeval _sendingFor;
+		/// Report time as the base class set it, put back once a
+		/// deadline-stamped report has gone
+		struct timeval _baseTimestamp;
+		/// @}
+
+		/// @name Smoothing stage
+		/// @{
+		PoseFilter _filter;
+		/// @}
+
+		/// @name Occlusion stage
+		/// @{
+		OcclusionFusion _fusion;
+		vrpn_Analog_Server * _confidenceServer;
+		double _confidence;
+		/// Pose sent from the last fix, to hold when there's no coasting
+		vrpn_float64 _fixPos[3];
+		vrpn_float64 _fixQuat[4];
+		/// @}
+
+		/// @name Constellation solve
+		/// @{
+		PnPSolver _pnp;
+		/// Blobs of the newest frame, in normalized camera coordinates
+		double _points[WiimoteSource::IR_POINTS][2];
+		int _numPoints;
+		bool _pnpSolved;
+		double _pnpPos[3];
+		double _pnpQuat[4];
+		/// @}
+
+		/// @name Prediction stage
+		/// @{
+		PosePredictor _predictor;
+		double _predictionHorizon;
+		/// Zero point for the predictor's times, to keep them small
+		struct timeval _epoch;
+		struct timeval _lastFrame;
+		/// Whether the report being encoded is from a new frame
+		bool _reportIsFresh;
+		/// Whether the last mainloop() sent a report
+		bool _reported;
+		/// @}
+};
+
+// -- inline implementations -- //
+
+inline double HeadTrackerDevice::getConfidence() const {
+	return _confidence;
+}
+
+#endif // _HEADTRACKERDEVICE_H
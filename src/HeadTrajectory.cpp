@@ -0,0 +1,128 @@
+/**	@file	HeadTrajectory.cpp
+	@brief	Implementation of the head motion driving a simulated Wiimote
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "HeadTrajectory.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static const double PI = 3.14159265358979323846;
+static const double TWO_PI = 2.0 * PI;
+
+/// @name Built-in sway: sitting about 70 cm from the camera
+/// @{
+static const double HEAD_DISTANCE = 0.7;
+static const double SWAY_X = 0.10;
+static const double SWAY_Y = 0.05;
+static const double SWAY_Z = 0.05;
+static const double MAX_YAW = 0.3;
+static const double MAX_ROLL = 0.1;
+/// @}
+
+HeadTrajectory::HeadTrajectory(const double phase) :
+		_phase(phase) {}
+
+bool HeadTrajectory::load(const std::string & filename) {
+	std::ifstream file(filename.c_str());
+	if (!file.is_open()) {
+		std::cerr << "Could not open head trajectory " << filename << std::endl;
+		return false;
+	}
+	std::vector<Keyframe> keys;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		const std::string::size_type comment = line.find('#');
+		if (comment != std::string::npos) {
+			line.erase(comment);
+		}
+		std::istringstream fields(line);
+		Keyframe k;
+		double yawDegrees;
+		double rollDegrees;
+		if (!(fields >> k.time)) {
+			// Blank or comment-only line
+			continue;
+		}
+		if (!(fields >> k.pos[0] >> k.pos[1] >> k.pos[2] >> yawDegrees >> rollDegrees) ||
+				(!keys.empty() && k.time <= keys.back().time)) {
+			std::cerr << filename << ":" << lineNumber <<
+				": expected increasing time, x, y, z, yaw and roll" << std::endl;
+			return false;
+		}
+		if (!(fields >> k.hidden)) {
+			k.hidden = 0;
+		}
+		k.yaw = yawDegrees * PI / 180.0;
+		k.roll = rollDegrees * PI / 180.0;
+		keys.push_back(k);
+	}
+	if (keys.size() < 2) {
+		std::cerr << "Head trajectory " << filename << " needs at least two keyframes" << std::endl;
+		return false;
+	}
+	_keys.swap(keys);
+	return true;
+}
+
+void HeadTrajectory::sample(const double t, double pos[3], double & yaw, double & roll,
+		unsigned int & hidden) const {
+	if (!isScripted()) {
+		sway(t + _phase, pos, yaw, roll);
+		hidden = 0;
+		return;
+	}
+	// Loop the script, starting from its first keyframe
+	const double start = _keys.front().time;
+	const double length = _keys.back().time - start;
+	double s = std::fmod(t + _phase, length);
+	if (s < 0) {
+		s += length;
+	}
+	s += start;
+
+	std::size_t i = 1;
+	while (i + 1 < _keys.size() && _keys[i].time < s) {
+		++i;
+	}
+	const Keyframe & a = _keys[i - 1];
+	const Keyframe & b = _keys[i];
+	const double u = (s - a.time) / (b.time - a.time);
+	for (int j = 0; j < 3; ++j) {
+		pos[j] = a.pos[j] + u * (b.pos[j] - a.pos[j]);
+	}
+	yaw = a.yaw + u * (b.yaw - a.yaw);
+	roll = a.roll + u * (b.roll - a.roll);
+	hidden = a.hidden;
+}
+
+void HeadTrajectory::sway(const double s, double pos[3], double & yaw, double & roll) const {
+	pos[0] = SWAY_X * std::sin(TWO_PI * 0.20 * s);
+	pos[1] = SWAY_Y * std::sin(TWO_PI * 0.13 * s);
+	pos[2] = HEAD_DISTANCE + SWAY_Z * std::sin(TWO_PI * 0.07 * s);
+	yaw = MAX_YAW * std::sin(TWO_PI * 0.10 * s);
+	roll = MAX_ROLL * std::sin(TWO_PI * 0.17 * s);
+}
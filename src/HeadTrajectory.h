@@ -0,0 +1,87 @@
+/** @file	HeadTrajectory.h
+	@brief	header for the head motion driving a simulated Wiimote
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _HEADTRAJECTORY_H
+#define _HEADTRAJECTORY_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <string>
+#include <vector>
+
+/// @brief Where a head wearing the LED bar is at a given time, in the
+/// camera's frame (meters, z out of the camera): either a built-in sway
+/// or a script of keyframes, interpolated linearly and looped.
+///
+/// A script is a text file with one keyframe per line:
+/// @code
+/// # seconds  x      y      z     yaw(deg) roll(deg) [hidden]
+/// 0          0      0      0.7   0        0
+/// 2.5        0.1    0.02   0.65  15       -5        3
+/// 2.7        0.12   0.02   0.65  15       -5
+/// @endcode
+/// Pitch is left out: turning about the bar's own axis doesn't move
+/// two LEDs' images, so the tracker couldn't see it anyway. The optional
+/// last column occludes LEDs from that keyframe to the next, bit n for
+/// LED n: for the bar, 1 for the left, 2 for the right, 3 for both.
+class HeadTrajectory {
+	public:
+		struct Keyframe {
+			double time;
+			double pos[3];
+			/// Radians
+			double yaw;
+			double roll;
+			/// Mask of LEDs occluded until the next keyframe
+			unsigned int hidden;
+		};
+
+		/// @brief The built-in sway, offset by phase seconds
+		explicit HeadTrajectory(const double phase = 0);
+
+		/// @brief Replace the sway with a script.
+		/// @returns false, keeping the sway, if it can't be read.
+		bool load(const std::string & filename);
+		bool isScripted() const;
+
+		/// @brief Head pose at time t (seconds), and the mask of LEDs
+		/// occluded then
+		void sample(const double t, double pos[3], double & yaw, double & roll,
+			unsigned int & hidden) const;
+
+	protected:
+		void sway(const double t, double pos[3], double & yaw, double & roll) const;
+
+		double _phase;
+		std::vector<Keyframe> _keys;
+};
+
+// -- inline implementations -- //
+
+inline bool HeadTrajectory::isScripted() const {
+	return _keys.size() > 1;
+}
+
+#endif // _HEADTRAJECTORY_H
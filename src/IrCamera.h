@@ -0,0 +1,70 @@
+/** @file	IrCamera.h
+	@brief	header for the Wiimote IR camera's projection model
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _IRCAMERA_H
+#define _IRCAMERA_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+
+/// @brief The Wiimote's IR camera: a 1024x768 sensor about 41 degrees
+/// across, each pixel covering the same angle. Camera frame: x along the
+/// sensor's u axis, y along v, z out of the camera.
+///
+/// Since u and v grow with atan(x / z) and atan(y / z), a blob's pixel
+/// position converts exactly to the pinhole ("normalized") coordinates
+/// x / z and y / z that pose solvers work in.
+namespace ircamera {
+
+	static const double SENSOR_WIDTH = 1024.0;
+	static const double SENSOR_HEIGHT = 768.0;
+	static const double RADIANS_PER_PIXEL = (41.0 * 3.14159265358979323846 / 180.0) / SENSOR_WIDTH;
+
+/// @addtogroup FreeFunctions Free Functions
+/// @{
+
+	/// @brief Pixel position of a point p in the camera frame.
+	/// @returns false if it is behind the camera or off the sensor.
+	inline bool project(const double p[3], double & u, double & v) {
+		if (p[2] <= 0) {
+			return false;
+		}
+		u = SENSOR_WIDTH / 2.0 + std::atan2(p[0], p[2]) / RADIANS_PER_PIXEL;
+		v = SENSOR_HEIGHT / 2.0 + std::atan2(p[1], p[2]) / RADIANS_PER_PIXEL;
+		return u >= 0 && u < SENSOR_WIDTH && v >= 0 && v < SENSOR_HEIGHT;
+	}
+
+	/// @brief Normalized coordinates (x / z, y / z) of a blob at (u, v)
+	inline void normalize(const double u, const double v, double dest[2]) {
+		dest[0] = std::tan((u - SENSOR_WIDTH / 2.0) * RADIANS_PER_PIXEL);
+		dest[1] = std::tan((v - SENSOR_HEIGHT / 2.0) * RADIANS_PER_PIXEL);
+	}
+
+/// @}
+
+} // end of ircamera namespace
+
+#endif // _IRCAMERA_H
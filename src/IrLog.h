@@ -0,0 +1,82 @@
+/** @file	IrLog.h
+	@brief	header describing the raw IR frame log file format
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _IRLOG_H
+#define _IRLOG_H
+
+// Internal Includes
+#include "WiimoteSource.h"
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+
+// Standard includes
+// - none
+
+/// @brief Layout of the files FrameRecorder writes: a fixed-size header,
+/// then one fixed-size record per Wiimote report, in arrival order.
+/// Fields are in the byte order of the machine that recorded them.
+namespace irlog {
+	enum {
+		VERSION = 1,
+		/// Room for the header: a multiple of every platform's mapping
+		/// granularity, so records start on a mappable boundary
+		HEADER_SIZE = 65536,
+		RECORD_SIZE = 64,
+		/// IR coordinate or size of a point the camera didn't see
+		NO_POINT = 0xFFFF
+	};
+
+	struct Header {
+		/// "WIIRLOG" and a NUL
+		char magic[8];
+		vrpn_uint32 version;
+		vrpn_uint32 headerSize;
+		vrpn_uint32 recordSize;
+		/// Records written so far - kept current while recording, so a
+		/// log cut short by a crash is still readable
+		vrpn_uint32 frames;
+	};
+
+	struct Record {
+		/// Report time stamp
+		vrpn_int32 seconds;
+		vrpn_int32 microseconds;
+		/// Station (pipeline) the report came from
+		vrpn_uint16 station;
+		/// IR points seen
+		vrpn_uint16 points;
+		vrpn_float32 battery;
+		/// In g
+		vrpn_float32 accel[3];
+		/// x, y and size of each point, in camera pixels, or NO_POINT
+		vrpn_uint16 ir[WiimoteSource::IR_POINTS][3];
+		char reserved[12];
+	};
+
+	/// @brief Fails to compile if Record doesn't come out at RECORD_SIZE
+	typedef char RecordSizeCheck[sizeof(Record) == RECORD_SIZE ? 1 : -1];
+
+	inline const char * magic() {
+		return "WIIRLOG";
+	}
+} // end of irlog namespace
+
+#endif // _IRLOG_H
@@ -0,0 +1,115 @@
+/**	@file	LatencyHistogram.cpp
+	@brief	Implementation of a fixed-size log-linear latency histogram
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "LatencyHistogram.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+LatencyHistogram::LatencyHistogram() {
+	reset();
+}
+
+void LatencyHistogram::reset() {
+	for (int i = 0; i < BUCKETS; ++i) {
+		_buckets[i] = 0;
+	}
+	_count = 0;
+	_sum = 0;
+	_max = 0;
+}
+
+int LatencyHistogram::bucketFor(const double seconds) {
+	if (seconds <= 0) {
+		return 0;
+	}
+	const double us = seconds * 1.0e6;
+	// Anything past the top lands in the last bucket
+	if (us >= double(SUB_BUCKETS) * double(1UL << (OCTAVES - 1))) {
+		return BUCKETS - 1;
+	}
+	const unsigned long u = (unsigned long)(us);
+	if (u < SUB_BUCKETS) {
+		return int(u);
+	}
+	// Octave k >= 1 covers [16 << (k - 1), 16 << k) in buckets 2^(k-1) wide
+	int k = 1;
+	while ((u >> k) >= SUB_BUCKETS) {
+		++k;
+	}
+	return k * SUB_BUCKETS + int(u >> (k - 1)) - SUB_BUCKETS;
+}
+
+double LatencyHistogram::getBucketLowerBound(const int bucket) {
+	const int k = bucket / SUB_BUCKETS;
+	const int sub = bucket % SUB_BUCKETS;
+	if (k == 0) {
+		return sub * 1.0e-6;
+	}
+	return double((unsigned long)(SUB_BUCKETS + sub) << (k - 1)) * 1.0e-6;
+}
+
+double LatencyHistogram::getBucketUpperBound(const int bucket) {
+	const int k = bucket / SUB_BUCKETS;
+	const unsigned long width = (k == 0) ? 1UL : (1UL << (k - 1));
+	return getBucketLowerBound(bucket) + width * 1.0e-6;
+}
+
+void LatencyHistogram::record(const double seconds) {
+	_buckets[bucketFor(seconds)]++;
+	_count++;
+	_sum += seconds;
+	if (seconds > _max) {
+		_max = seconds;
+	}
+}
+
+void LatencyHistogram::merge(const LatencyHistogram & other) {
+	for (int i = 0; i < BUCKETS; ++i) {
+		_buckets[i] += other._buckets[i];
+	}
+	_count += other._count;
+	_sum += other._sum;
+	if (other._max > _max) {
+		_max = other._max;
+	}
+}
+
+double LatencyHistogram::getPercentile(const double p) const {
+	if (_count == 0) {
+		return 0;
+	}
+	// Smallest bucket holding at least a fraction p of the values
+	unsigned long rank = (unsigned long)(p * _count + 0.5);
+	if (rank < 1) {
+		rank = 1;
+	}
+	unsigned long seen = 0;
+	for (int i = 0; i < BUCKETS; ++i) {
+		seen += _buckets[i];
+		if (seen >= rank) {
+			const double upper = getBucketUpperBound(i);
+			return (upper < _max) ? upper : _max;
+		}
+	}
+	return _max;
+}
@@ -0,0 +1,103 @@
+/** @file	LatencyHistogram.h
+	@brief	header for a fixed-size log-linear latency histogram
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _LATENCYHISTOGRAM_H
+#define _LATENCYHISTOGRAM_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+/// @brief Counts durations in log-linear buckets: 1 microsecond wide up
+/// to 16 us, then each doubling of the range split into 16 equal
+/// buckets, up to about two minutes - so any value is resolved to within
+/// about 6%, in a few kilobytes that never grow.
+///
+/// Recording is a handful of integer operations and never allocates.
+class LatencyHistogram {
+	public:
+		enum {
+			SUB_BUCKETS = 16,
+			OCTAVES = 24,
+			BUCKETS = SUB_BUCKETS * OCTAVES
+		};
+
+		LatencyHistogram();
+
+		void reset();
+
+		/// @brief Count a duration, in seconds
+		void record(const double seconds);
+
+		/// @brief Add another histogram's counts to this one
+		void merge(const LatencyHistogram & other);
+
+		unsigned long getCount() const;
+		/// @name Summary values, in seconds - 0 if nothing recorded
+		/// @{
+		double getMean() const;
+		double getMax() const;
+		/// @brief Upper edge of the bucket holding the p-quantile
+		/// (0 to 1), but never more than the largest value seen
+		double getPercentile(const double p) const;
+		/// @}
+
+		/// @name Raw buckets
+		/// @{
+		unsigned long getBucketCount(const int bucket) const;
+		/// @brief Lower edge of a bucket, in seconds
+		static double getBucketLowerBound(const int bucket);
+		/// @brief Upper edge of a bucket, in seconds
+		static double getBucketUpperBound(const int bucket);
+		/// @}
+
+	protected:
+		static int bucketFor(const double seconds);
+
+		unsigned long _buckets[BUCKETS];
+		unsigned long _count;
+		double _sum;
+		double _max;
+};
+
+// -- inline implementations -- //
+
+inline unsigned long LatencyHistogram::getCount() const {
+	return _count;
+}
+
+inline double LatencyHistogram::getMean() const {
+	return _count ? _sum / _count : 0;
+}
+
+inline double LatencyHistogram::getMax() const {
+	return _max;
+}
+
+inline unsigned long LatencyHistogram::getBucketCount(const int bucket) const {
+	return _buckets[bucket];
+}
+
+#endif // _LATENCYHISTOGRAM_H
@@ -0,0 +1,170 @@
+/**	@file	LedConstellation.cpp
+	@brief	Implementation of the arrangement of LEDs on the head
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "LedConstellation.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+/// Closer than this (meters) is the same LED; less area than its square
+/// is a line.
+static const double MIN_SEPARATION = 0.005;
+
+LedConstellation LedConstellation::bar(const double spacing) {
+	LedConstellation c;
+	c.add(-spacing / 2.0, 0, 0);
+	c.add(spacing / 2.0, 0, 0);
+	return c;
+}
+
+bool LedConstellation::add(const double x, const double y, const double z) {
+	if (count >= MAX_LEDS) {
+		return false;
+	}
+	leds[count][0] = x;
+	leds[count][1] = y;
+	leds[count][2] = z;
+	count++;
+	return true;
+}
+
+bool LedConstellation::isValid() const {
+	if (count == 0) {
+		return true;
+	}
+	if (!usable()) {
+		return false;
+	}
+	// Some three of them must span a triangle of reasonable size
+	for (int a = 0; a < count; ++a) {
+		for (int b = a + 1; b < count; ++b) {
+			for (int c = b + 1; c < count; ++c) {
+				double ab[3];
+				double ac[3];
+				for (int i = 0; i < 3; ++i) {
+					ab[i] = leds[b][i] - leds[a][i];
+					ac[i] = leds[c][i] - leds[a][i];
+				}
+				const double cross[3] = {
+					ab[1] * ac[2] - ab[2] * ac[1],
+					ab[2] * ac[0] - ab[0] * ac[2],
+					ab[0] * ac[1] - ab[1] * ac[0]
+				};
+				const double area = 0.5 * std::sqrt(cross[0] * cross[0] +
+					cross[1] * cross[1] + cross[2] * cross[2]);
+				if (area >= MIN_SEPARATION * MIN_SEPARATION) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+bool LedConstellation::operator==(const LedConstellation & other) const {
+	if (count != other.count) {
+		return false;
+	}
+	for (int led = 0; led < count; ++led) {
+		for (int i = 0; i < 3; ++i) {
+			if (leds[led][i] != other.leds[led][i]) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+std::ostream & operator<<(std::ostream & s, const LedConstellation & rhs) {
+	s << rhs.count;
+	for (int led = 0; led < rhs.count; ++led) {
+		s << " " << rhs.leds[led][0] << " " << rhs.leds[led][1] << " " << rhs.leds[led][2];
+	}
+	return s;
+}
+
+std::istream & operator>>(std::istream & s, LedConstellation & rhs) {
+	int count;
+	if (!(s >> count)) {
+		return s;
+	}
+	if (count < 0 || count > LedConstellation::MAX_LEDS) {
+		s.setstate(std::ios::failbit);
+		return s;
+	}
+	LedConstellation read;
+	for (int led = 0; led < count; ++led) {
+		double x;
+		double y;
+		double z;
+		if (!(s >> x >> y >> z)) {
+			return s;
+		}
+		read.add(x, y, z);
+	}
+	rhs = read;
+	return s;
+}
+
+bool loadConstellation(const std::string & filename, LedConstellation & constellation) {
+	std::ifstream file(filename.c_str());
+	if (!file.is_open()) {
+		std::cerr << "Could not open LED constellation " << filename << std::endl;
+		return false;
+	}
+	LedConstellation read;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		const std::string::size_type comment = line.find('#');
+		if (comment != std::string::npos) {
+			line.erase(comment);
+		}
+		std::istringstream fields(line);
+		double x;
+		if (!(fields >> x)) {
+			// Blank or comment-only line
+			continue;
+		}
+		double y;
+		double z;
+		if (!(fields >> y >> z)) {
+			std::cerr << filename << ":" << lineNumber << ": expected x, y and z" << std::endl;
+			return false;
+		}
+		if (!read.add(x, y, z)) {
+			std::cerr << filename << ":" << lineNumber << ": at most " <<
+				int(LedConstellation::MAX_LEDS) << " LEDs" << std::endl;
+			return false;
+		}
+	}
+	if (!read.usable() || !read.isValid()) {
+		std::cerr << "LED constellation " << filename << " needs " << int(LedConstellation::MIN_LEDS) <<
+			" to " << int(LedConstellation::MAX_LEDS) << " LEDs, not all in a line" << std::endl;
+		return false;
+	}
+	constellation = read;
+	return true;
+}
@@ -0,0 +1,88 @@
+/** @file	LedConstellation.h
+	@brief	header for the arrangement of LEDs on the head
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _LEDCONSTELLATION_H
+#define _LEDCONSTELLATION_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <string>
+#include <iostream>
+
+/// @brief Where the LEDs sit on the head, in meters in the head's own
+/// frame. With the head's orientation at identity that frame lines up
+/// with the camera's (see IrCamera.h), so x runs across the face.
+///
+/// Three or four LEDs, not all in a line, are enough for PnPSolver to
+/// find the full 6-DOF pose; an empty constellation leaves tracking to
+/// the two-LED bar.
+struct LedConstellation {
+	enum {
+		MIN_LEDS = 3,
+		MAX_LEDS = 4
+	};
+
+	LedConstellation() : count(0) {}
+
+	/// @brief Two LEDs spacing apart along x, centered on the origin
+	static LedConstellation bar(const double spacing);
+
+	/// @returns false if there is no room for another LED.
+	bool add(const double x, const double y, const double z);
+
+	/// @brief Enough LEDs for a 6-DOF solve
+	bool usable() const;
+
+	/// @brief Empty, or usable and not degenerate (points coincident
+	/// or in a line).
+	bool isValid() const;
+
+	bool operator==(const LedConstellation & other) const;
+	bool operator!=(const LedConstellation & other) const;
+
+	int count;
+	double leds[MAX_LEDS][3];
+};
+
+/// @brief On one line: the count, then x y z for each LED
+std::ostream & operator<<(std::ostream & s, const LedConstellation & rhs);
+std::istream & operator>>(std::istream & s, LedConstellation & rhs);
+
+/// @brief Read a constellation from a text file with one "x y z" per
+/// line, in meters; '#' starts a comment.
+/// @returns false, leaving constellation alone, if it can't be read.
+bool loadConstellation(const std::string & filename, LedConstellation & constellation);
+
+// -- inline implementations -- //
+
+inline bool LedConstellation::usable() const {
+	return count >= MIN_LEDS;
+}
+
+inline bool LedConstellation::operator!=(const LedConstellation & other) const {
+	return !(*this == other);
+}
+
+#endif // _LEDCONSTELLATION_H
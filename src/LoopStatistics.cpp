@@ -0,0 +1,125 @@
+/**	@file	LoopStatistics.cpp
+	@brief	Implementation of main loop wakeup and latency accounting
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "LoopStatistics.h"
+#include "AllocationCounter.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <iomanip>
+
+LoopStatistics::LoopStatistics(const double interval) :
+		_interval(interval),
+		_started(false),
+		_wakeups(0),
+		_inputPending(false),
+		_latencySum(0),
+		_latencyMax(0),
+		_latencyCount(0),
+		_poses(0),
+		_allocationsAtStart(0),
+		_wakeupsPerSecond(0),
+		_meanLatency(0),
+		_maxLatency(0),
+		_allocationsPerPose(0) {
+}
+
+void LoopStatistics::reset() {
+	_started = false;
+	_wakeups = 0;
+	_inputPending = false;
+	_latencySum = 0;
+	_latencyMax = 0;
+	_latencyCount = 0;
+	_poses = 0;
+}
+
+void LoopStatistics::recordWakeup() {
+	_wakeups++;
+}
+
+void LoopStatistics::recordInput(const struct timeval & inputTime) {
+	// Only the first input since the last publish starts the clock:
+	// later ones are folded into the same pose.
+	if (!_inputPending) {
+		_lastInput = inputTime;
+		_inputPending = true;
+	}
+}
+
+void LoopStatistics::recordPublish(const struct timeval & publishTime) {
+	_poses++;
+	if (!_inputPending) {
+		// A keep-alive report with no new input behind it.
+		return;
+	}
+	_inputPending = false;
+	const double latency = vrpn_TimevalDuration(publishTime, _lastInput);
+	if (latency < 0) {
+		return;
+	}
+	_latencySum += latency;
+	_latencyCount++;
+	if (latency > _latencyMax) {
+		_latencyMax = latency;
+	}
+}
+
+bool LoopStatistics::update(const struct timeval & now) {
+	if (!_started) {
+		_windowStart = now;
+		_allocationsAtStart = allocations::total();
+		_started = true;
+		return false;
+	}
+	const double elapsed = vrpn_TimevalDuration(now, _windowStart);
+	if (elapsed < _interval) {
+		return false;
+	}
+
+	_wakeupsPerSecond = _wakeups / elapsed;
+	_meanLatency = _latencyCount ? (_latencySum / _latencyCount) : 0;
+	_maxLatency = _latencyMax;
+	const unsigned long allocs = allocations::total();
+	_allocationsPerPose = _poses ? double(allocs - _allocationsAtStart) / _poses : 0;
+
+	_windowStart = now;
+	_allocationsAtStart = allocs;
+	_poses = 0;
+	_wakeups = 0;
+	_latencySum = 0;
+	_latencyMax = 0;
+	_latencyCount = 0;
+	return true;
+}
+
+std::ostream & operator<<(std::ostream & s, const LoopStatistics & rhs) {
+	s << std::fixed << std::setprecision(1) <<
+		rhs.getWakeupsPerSecond() << " wakeups/sec, input-to-publish latency " <<
+		std::setprecision(3) <<
+		rhs.getMeanLatency() * 1000.0 << " ms mean, " <<
+		rhs.getMaxLatency() * 1000.0 << " ms max";
+	if (allocations::counted()) {
+		s << ", " << std::setprecision(2) <<
+			rhs.getAllocationsPerPose() << " heap allocations/pose";
+	}
+	return s;
+}
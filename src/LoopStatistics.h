@@ -0,0 +1,100 @@
+/** @file	LoopStatistics.h
+	@brief	header for main loop wakeup and latency accounting
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _LOOPSTATISTICS_H
+#define _LOOPSTATISTICS_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+
+// Standard includes
+#include <iostream>
+
+/// @brief Counts main loop wakeups and measures the time from a Wiimote
+/// report arriving to the resulting pose being published.
+class LoopStatistics {
+	public:
+		LoopStatistics(const double interval = 10.0);
+
+		void reset();
+
+		void recordWakeup();
+		void recordInput(const struct timeval & inputTime);
+		void recordPublish(const struct timeval & publishTime);
+
+		/// @brief Closes the current window if the interval has elapsed.
+		/// @returns true if new summary values are available.
+		bool update(const struct timeval & now);
+
+		/// @name Summary of the most recently closed window
+		/// @{
+		double getWakeupsPerSecond() const;
+		double getMeanLatency() const;
+		double getMaxLatency() const;
+		/// @brief Only meaningful in builds with COUNT_HEAP_ALLOCATIONS
+		double getAllocationsPerPose() const;
+		/// @}
+
+	protected:
+		double _interval;
+		struct timeval _windowStart;
+		bool _started;
+
+		unsigned long _wakeups;
+
+		bool _inputPending;
+		struct timeval _lastInput;
+		double _latencySum;
+		double _latencyMax;
+		unsigned long _latencyCount;
+
+		unsigned long _poses;
+		unsigned long _allocationsAtStart;
+
+		double _wakeupsPerSecond;
+		double _meanLatency;
+		double _maxLatency;
+		double _allocationsPerPose;
+};
+
+std::ostream & operator<<(std::ostream & s, const LoopStatistics & rhs);
+
+// -- inline implementations -- //
+
+inline double LoopStatistics::getWakeupsPerSecond() const {
+	return _wakeupsPerSecond;
+}
+
+inline double LoopStatistics::getMeanLatency() const {
+	return _meanLatency;
+}
+
+inline double LoopStatistics::getMaxLatency() const {
+	return _maxLatency;
+}
+
+inline double LoopStatistics::getAllocationsPerPose() const {
+	return _allocationsPerPose;
+}
+
+#endif // _LOOPSTATISTICS_H
@@ -0,0 +1,69 @@
+/**	@file	MonotonicClock.cpp
+	@brief	Implementation of the monotonic clock
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "MonotonicClock.h"
+
+// Library/third-party includes
+#ifdef _WIN32
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#elif defined(__APPLE__)
+#	include <mach/mach_time.h>
+#else
+#	include <time.h>
+#endif
+
+// Standard includes
+// - none
+
+namespace monotonic {
+	static const double s_launch = seconds();
+
+	double seconds() {
+#ifdef _WIN32
+		static double period = 0;
+		if (period == 0) {
+			LARGE_INTEGER freq;
+			QueryPerformanceFrequency(&freq);
+			period = 1.0 / double(freq.QuadPart);
+		}
+		LARGE_INTEGER count;
+		QueryPerformanceCounter(&count);
+		return double(count.QuadPart) * period;
+#elif defined(__APPLE__)
+		static double period = 0;
+		if (period == 0) {
+			mach_timebase_info_data_t info;
+			mach_timebase_info(&info);
+			period = 1e-9 * double(info.numer) / double(info.denom);
+		}
+		return double(mach_absolute_time()) * period;
+#else
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return double(ts.tv_sec) + ts.tv_nsec * 1e-9;
+#endif
+	}
+
+	double sinceLaunch() {
+		return seconds() - s_launch;
+	}
+} // end of monotonic namespace
@@ -0,0 +1,50 @@
+/** @file	MonotonicClock.h
+	@brief	header for a clock that never jumps with wall-clock adjustments
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _MONOTONICCLOCK_H
+#define _MONOTONICCLOCK_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+namespace monotonic {
+
+/// @addtogroup FreeFunctions Free Functions
+/// @{
+
+	/// @brief Seconds since an arbitrary fixed point - only differences
+	/// between two calls are meaningful.
+	double seconds();
+
+	/// @brief Seconds since this process started (strictly, since static
+	/// initialization of this library).
+	double sinceLaunch();
+
+/// @}
+
+} // end of monotonic namespace
+
+#endif // _MONOTONICCLOCK_H
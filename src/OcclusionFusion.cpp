@@ -0,0 +1,141 @@
+/**	@file	OcclusionFusion.cpp
+	@brief	Implementation of coasting through LED occlusion and rating pose confidence
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "OcclusionFusion.h"
+#include "WiimoteSource.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+#include <algorithm>
+
+/// @name Tuning, in seconds and g
+/// @{
+static const double COAST_DECAY = 0.1;			// Velocity time constant while coasting
+static const double GRAVITY_TIME_CONSTANT = 1.0;	// Complementary filter on the accelerometer
+static const double DISTURBANCE_RECOVERY = 0.5;	// How long a bump keeps confidence down
+static const double DISTURBED_ACCEL = 0.2;		// Departure from gravity that means no trust
+static const double MAX_ACCEL_STEP = 0.1;		// Longer gaps in reports don't count as settling
+/// @}
+
+OcclusionFusion::OcclusionFusion() :
+		_coastTime(0.25),
+		_pointsNeeded(2) {
+	reset();
+}
+
+void OcclusionFusion::reset() {
+	_fix = false;
+	_haveFix = false;
+	_lastFix = 0;
+	_haveGravity = false;
+	_gravity[0] = _gravity[1] = 0;
+	_gravity[2] = 1;
+	_lastAccel = 0;
+	_disturbance = 0;
+}
+
+void OcclusionFusion::setCoastTime(const double seconds) {
+	_coastTime = seconds > 0 ? seconds : 0;
+}
+
+void OcclusionFusion::setPointsNeeded(const int points) {
+	_pointsNeeded = points;
+}
+
+void OcclusionFusion::frameArrived(const double time, const double channels[], const int numChannels) {
+	// Unseen points are reported as -1
+	int points = 0;
+	for (int i = 0; i < WiimoteSource::IR_POINTS; ++i) {
+		const int x = WiimoteSource::CHANNEL_IR + 3 * i;
+		if (x < numChannels && channels[x] >= 0) {
+			points++;
+		}
+	}
+	_fix = (points >= _pointsNeeded);
+
+	if (numChannels < WiimoteSource::CHANNEL_ACCEL + 3) {
+		return;
+	}
+	const double * accel = channels + WiimoteSource::CHANNEL_ACCEL;
+	if (!_haveGravity) {
+		std::copy(accel, accel + 3, _gravity);
+		_haveGravity = true;
+		_lastAccel = time;
+		return;
+	}
+	const double dt = std::min(std::max(time - _lastAccel, 0.0), MAX_ACCEL_STEP);
+	_lastAccel = time;
+
+	// Gravity follows the slow part; what is left is the camera moving
+	const double alpha = dt / (GRAVITY_TIME_CONSTANT + dt);
+	double deviation = 0;
+	for (int i = 0; i < 3; ++i) {
+		_gravity[i] += alpha * (accel[i] - _gravity[i]);
+		const double d = accel[i] - _gravity[i];
+		deviation += d * d;
+	}
+	deviation = std::sqrt(deviation);
+
+	// Rise at once, recover slowly
+	_disturbance = std::max(deviation, _disturbance * std::exp(-dt / DISTURBANCE_RECOVERY));
+}
+
+void OcclusionFusion::fixUsed(const double time) {
+	_haveFix = true;
+	_lastFix = time;
+}
+
+void OcclusionFusion::fixFailed() {
+	_fix = false;
+}
+
+bool OcclusionFusion::coastTarget(const double time, double & target) const {
+	if (!_haveFix) {
+		return false;
+	}
+	// Integral of a velocity decaying from the last fix, over at most the
+	// coast time: the target stops moving when the coast is over.
+	const double coasted = std::min(std::max(time - _lastFix, 0.0), _coastTime);
+	target = _lastFix + COAST_DECAY * (1.0 - std::exp(-coasted / COAST_DECAY));
+	return true;
+}
+
+double OcclusionFusion::sinceFix(const double time) const {
+	if (!_haveFix) {
+		return -1;
+	}
+	return std::max(time - _lastFix, 0.0);
+}
+
+double OcclusionFusion::getConfidence(const double time) const {
+	if (!_haveFix) {
+		return 0;
+	}
+	const double steadiness = std::max(0.0, 1.0 - _disturbance / DISTURBED_ACCEL);
+	if (_fix) {
+		return steadiness;
+	}
+	if (_coastTime <= 0) {
+		return 0;
+	}
+	return steadiness * std::max(0.0, 1.0 - sinceFix(time) / _coastTime);
+}
@@ -0,0 +1,117 @@
+/** @file	OcclusionFusion.h
+	@brief	header for coasting through LED occlusion and rating pose confidence
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _OCCLUSIONFUSION_H
+#define _OCCLUSIONFUSION_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+/// @brief Decides how far to carry the pose on while the LEDs are out of
+/// sight, and how much to trust the pose being published.
+///
+/// Through an occlusion the pose keeps moving the way it was, its velocity
+/// dying away so a long gap settles instead of running off, until the
+/// coast time is up; then it holds. Confidence falls from 1 at the last
+/// IR fix to 0 at the end of the coast.
+///
+/// The Wiimote's accelerometer rides on the camera, not the head, and the
+/// base tracker already uses its slow average to level the camera frame.
+/// Here it is tracked the same way, by a complementary filter, and any
+/// acceleration away from that gravity estimate - the camera being bumped
+/// or moved, when the leveling is wrong - scales confidence down until it
+/// settles.
+class OcclusionFusion {
+	public:
+		OcclusionFusion();
+
+		/// @brief Forget fixes and the gravity estimate.
+		void reset();
+
+		/// @brief Longest occlusion (seconds) to extrapolate through;
+		/// 0 holds the last fixed pose straight away.
+		void setCoastTime(const double seconds);
+		double getCoastTime() const;
+
+		/// @brief How many IR points make a fix: 2 for the LED bar, 3 for
+		/// a constellation.
+		void setPointsNeeded(const int points);
+
+		/// @brief Take in a Wiimote report stamped time (seconds): which
+		/// IR points it saw, and the accelerometer.
+		void frameArrived(const double time, const double channels[], const int numChannels);
+
+		/// @brief Whether the newest frame saw enough points to solve.
+		bool hasFix() const;
+
+		/// @brief Note that the pose solved from the frame at time was used.
+		void fixUsed(const double time);
+
+		/// @brief Note that no pose could be solved from the newest frame.
+		void fixFailed();
+
+		/// @brief The time, on the same clock, to extrapolate the fixed
+		/// poses to for a pose wanted at time.
+		/// @returns false if there has been no fix to coast from.
+		bool coastTarget(const double time, double & target) const;
+
+		/// @brief Seconds from the last fix to time, or negative if none.
+		double sinceFix(const double time) const;
+
+		/// @brief 0 (nothing to go on) to 1 (a fresh fix, camera steady)
+		double getConfidence(const double time) const;
+
+	protected:
+		double _coastTime;
+
+		/// @name IR fixes
+		/// @{
+		int _pointsNeeded;
+		bool _fix;
+		bool _haveFix;
+		double _lastFix;
+		/// @}
+
+		/// @name Camera steadiness, from the accelerometer (g)
+		/// @{
+		bool _haveGravity;
+		double _gravity[3];
+		double _lastAccel;
+		double _disturbance;
+		/// @}
+};
+
+// -- inline implementations -- //
+
+inline double OcclusionFusion::getCoastTime() const {
+	return _coastTime;
+}
+
+inline bool OcclusionFusion::hasFix() const {
+	return _fix;
+}
+
+#endif // _OCCLUSIONFUSION_H
@@ -0,0 +1,363 @@
+/**	@file	PnPSolver.cpp
+	@brief	Implementation of the 6-DOF pose solver for three or four LEDs
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "PnPSolver.h"
+#include "QuaternionMath.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+#include <algorithm>
+
+/// @name Solver tuning, in normalized units and meters
+/// @{
+static const double MAX_ERROR = 0.005;		// RMS fit to accept: several pixels
+static const double MAX_TURN = 0.5;			// Radians a three-LED solve may turn from the previous pose
+static const double MIN_DEPTH = 0.05;		// LEDs closer than this to the camera aren't a fit
+static const double CONVERGED_STEP = 1e-6;	// Step size that ends the iterations
+static const double DAMPING = 1e-6;			// Levenberg-Marquardt style, relative to the diagonal
+/// @}
+
+/// @brief Solve the 6x6 system A x = b in place by Gaussian elimination
+/// with partial pivoting; b is replaced by x.
+static bool solve6(double A[6][6], double b[6]) {
+	for (int col = 0; col < 6; ++col) {
+		int pivot = col;
+		for (int row = col + 1; row < 6; ++row) {
+			if (std::fabs(A[row][col]) > std::fabs(A[pivot][col])) {
+				pivot = row;
+			}
+		}
+		if (std::fabs(A[pivot][col]) < 1e-300) {
+			return false;
+		}
+		if (pivot != col) {
+			for (int k = col; k < 6; ++k) {
+				std::swap(A[col][k], A[pivot][k]);
+			}
+			std::swap(b[col], b[pivot]);
+		}
+		for (int row = col + 1; row < 6; ++row) {
+			const double f = A[row][col] / A[col][col];
+			for (int k = col; k < 6; ++k) {
+				A[row][k] -= f * A[col][k];
+			}
+			b[row] -= f * b[col];
+		}
+	}
+	for (int row = 5; row >= 0; --row) {
+		double sum = b[row];
+		for (int k = row + 1; k < 6; ++k) {
+			sum -= A[row][k] * b[k];
+		}
+		b[row] = sum / A[row][row];
+	}
+	return true;
+}
+
+/// @brief Step matched to the next way of giving each of n blobs a
+/// different one of m LEDs, counting up from all zeros.
+/// @returns false when there are no more.
+static bool nextMatching(int matched[], const int n, const int m) {
+	for (;;) {
+		int i = n - 1;
+		while (i >= 0 && ++matched[i] == m) {
+			matched[i] = 0;
+			--i;
+		}
+		if (i < 0) {
+			return false;
+		}
+		bool distinct = true;
+		for (int a = 0; a < n && distinct; ++a) {
+			for (int b = a + 1; b < n; ++b) {
+				if (matched[a] == matched[b]) {
+					distinct = false;
+					break;
+				}
+			}
+		}
+		if (distinct) {
+			return true;
+		}
+	}
+}
+
+/// @brief The first matching: blob i to LED i
+static void firstMatching(int matched[], const int n) {
+	for (int i = 0; i < n; ++i) {
+		matched[i] = i;
+	}
+}
+
+PnPSolver::PnPSolver() :
+		_constellation(),
+		_iterations(0),
+		_error(0),
+		_cold(false) {
+	reset();
+}
+
+void PnPSolver::setConstellation(const LedConstellation & constellation) {
+	_constellation = constellation;
+	reset();
+}
+
+void PnPSolver::reset() {
+	_seeded = false;
+	_pos[0] = _pos[1] = _pos[2] = 0;
+	_quat[0] = _quat[1] = _quat[2] = 0;
+	_quat[3] = 1;
+}
+
+bool PnPSolver::solve(const double points[][2], const int numPoints,
+		double pos[3], double quat[4]) {
+	_iterations = 0;
+	_cold = false;
+	if (numPoints < LedConstellation::MIN_LEDS || numPoints > _constellation.count) {
+		return false;
+	}
+
+	// Three blobs give as many equations as unknowns: every branch fits
+	// exactly, so the fit only shows the refinement converged, and which
+	// pose to believe comes from where the head was.
+	const bool minimal = numPoints == LedConstellation::MIN_LEDS;
+	bool solved = false;
+	if (_seeded) {
+		int matched[LedConstellation::MAX_LEDS];
+		double p[3];
+		double q[4];
+		std::copy(_pos, _pos + 3, p);
+		std::copy(_quat, _quat + 4, q);
+		if (matchToPose(points, numPoints, p, q, matched)) {
+			_error = refine(points, numPoints, matched, p, q, MAX_ITERATIONS, _iterations);
+			if (_error <= MAX_ERROR && (!minimal || quatmath::angleBetween(q, _quat) <= MAX_TURN)) {
+				std::copy(p, p + 3, _pos);
+				std::copy(q, q + 4, _quat);
+				solved = true;
+			}
+		}
+	}
+	if (!solved) {
+		_cold = true;
+		solved = solveCold(points, numPoints);
+	}
+
+	_seeded = solved;
+	if (!solved) {
+		return false;
+	}
+	std::copy(_pos, _pos + 3, pos);
+	std::copy(_quat, _quat + 4, quat);
+	return true;
+}
+
+bool PnPSolver::matchToPose(const double points[][2], const int numPoints,
+		const double pos[3], const double quat[4], int matched[]) const {
+	// Where each LED should appear
+	double expected[LedConstellation::MAX_LEDS][2];
+	for (int led = 0; led < _constellation.count; ++led) {
+		double p[3];
+		quatmath::rotate(p, quat, _constellation.leds[led]);
+		const double z = p[2] + pos[2];
+		if (z < MIN_DEPTH) {
+			return false;
+		}
+		expected[led][0] = (p[0] + pos[0]) / z;
+		expected[led][1] = (p[1] + pos[1]) / z;
+	}
+
+	int trial[LedConstellation::MAX_LEDS];
+	firstMatching(trial, numPoints);
+	double best = -1;
+	do {
+		double cost = 0;
+		for (int i = 0; i < numPoints; ++i) {
+			const double dx = points[i][0] - expected[trial[i]][0];
+			const double dy = points[i][1] - expected[trial[i]][1];
+			cost += dx * dx + dy * dy;
+		}
+		if (best < 0 || cost < best) {
+			best = cost;
+			std::copy(trial, trial + numPoints, matched);
+		}
+	} while (nextMatching(trial, numPoints, _constellation.count));
+	return true;
+}
+
+bool PnPSolver::solveCold(const double points[][2], const int numPoints) {
+	// Distance from the apparent size: widest pair of blobs against the
+	// widest pair of LEDs
+	double seen = 0;
+	double centroid[2] = {0, 0};
+	for (int a = 0; a < numPoints; ++a) {
+		centroid[0] += points[a][0] / numPoints;
+		centroid[1] += points[a][1] / numPoints;
+		for (int b = a + 1; b < numPoints; ++b) {
+			const double dx = points[a][0] - points[b][0];
+			const double dy = points[a][1] - points[b][1];
+			seen = std::max(seen, std::sqrt(dx * dx + dy * dy));
+		}
+	}
+	double size = 0;
+	for (int a = 0; a < _constellation.count; ++a) {
+		for (int b = a + 1; b < _constellation.count; ++b) {
+			const double dx = _constellation.leds[a][0] - _constellation.leds[b][0];
+			const double dy = _constellation.leds[a][1] - _constellation.leds[b][1];
+			size = std::max(size, std::sqrt(dx * dx + dy * dy));
+		}
+	}
+	if (seen <= 0 || size <= 0) {
+		return false;
+	}
+	const double distance = size / seen;
+
+	// With three blobs, keep the fit nearest the previous pose if there
+	// is one, else nearest facing the camera as the size estimate has it
+	const bool minimal = numPoints == LedConstellation::MIN_LEDS;
+	const bool seeded = _seeded;
+	double reference[4] = {0, 0, 0, 1};
+	if (seeded) {
+		std::copy(_quat, _quat + 4, reference);
+	}
+	double closest = 0;
+
+	int matched[LedConstellation::MAX_LEDS];
+	firstMatching(matched, numPoints);
+	bool found = false;
+	do {
+		// Facing the camera, with the matched LEDs centered on the blobs
+		double ledCentroid[3] = {0, 0, 0};
+		for (int i = 0; i < numPoints; ++i) {
+			for (int k = 0; k < 3; ++k) {
+				ledCentroid[k] += _constellation.leds[matched[i]][k] / numPoints;
+			}
+		}
+		double p[3] = {
+			centroid[0] * distance - ledCentroid[0],
+			centroid[1] * distance - ledCentroid[1],
+			distance - ledCentroid[2]
+		};
+		double q[4] = {0, 0, 0, 1};
+		int iterations;
+		const double error = refine(points, numPoints, matched, p, q, MAX_COLD_ITERATIONS, iterations);
+		_iterations += iterations;
+		const double turn = quatmath::angleBetween(q, reference);
+		const bool better = !found || (minimal ? turn < closest : error < _error);
+		const bool plausible = !minimal || !seeded || turn <= MAX_TURN;
+		if (error <= MAX_ERROR && better && plausible) {
+			found = true;
+			closest = turn;
+			_error = error;
+			std::copy(p, p + 3, _pos);
+			std::copy(q, q + 4, _quat);
+		}
+	} while (nextMatching(matched, numPoints, _constellation.count));
+	return found;
+}
+
+double PnPSolver::refine(const double points[][2], const int numPoints, const int matched[],
+		double pos[3], double quat[4], const int maxIterations, int & iterations) const {
+	iterations = 0;
+	bool converged = false;
+	for (;;) {
+		// Normal equations for the rotation increment (applied on the
+		// camera side) and the translation
+		double JtJ[6][6];
+		double Jtr[6];
+		for (int a = 0; a < 6; ++a) {
+			Jtr[a] = 0;
+			for (int b = 0; b < 6; ++b) {
+				JtJ[a][b] = 0;
+			}
+		}
+		double sumSquares = 0;
+		for (int i = 0; i < numPoints; ++i) {
+			double r[3];
+			quatmath::rotate(r, quat, _constellation.leds[matched[i]]);
+			const double z = r[2] + pos[2];
+			if (z < MIN_DEPTH) {
+				// Behind the camera: no fit to be had from here
+				return HUGE_VAL;
+			}
+			const double invZ = 1.0 / z;
+			const double x = (r[0] + pos[0]) * invZ;
+			const double y = (r[1] + pos[1]) * invZ;
+			const double ex = x - points[i][0];
+			const double ey = y - points[i][1];
+			sumSquares += ex * ex + ey * ey;
+
+			// d(projection)/d(rotation, translation); a rotation w moves
+			// the LED by w x r
+			const double Jx[6] = {
+				-x * invZ * r[1],
+				invZ * (r[2] + x * r[0]),
+				-invZ * r[1],
+				invZ,
+				0,
+				-x * invZ
+			};
+			const double Jy[6] = {
+				-invZ * (r[2] + y * r[1]),
+				y * invZ * r[0],
+				invZ * r[0],
+				0,
+				invZ,
+				-y * invZ
+			};
+			for (int a = 0; a < 6; ++a) {
+				Jtr[a] -= Jx[a] * ex + Jy[a] * ey;
+				for (int b = a; b < 6; ++b) {
+					JtJ[a][b] += Jx[a] * Jx[b] + Jy[a] * Jy[b];
+				}
+			}
+		}
+		const double error = std::sqrt(sumSquares / numPoints);
+		if (converged || iterations >= maxIterations) {
+			return error;
+		}
+
+		for (int a = 0; a < 6; ++a) {
+			JtJ[a][a] *= 1.0 + DAMPING;
+			for (int b = 0; b < a; ++b) {
+				JtJ[a][b] = JtJ[b][a];
+			}
+		}
+		if (!solve6(JtJ, Jtr)) {
+			return error;
+		}
+		iterations++;
+
+		double turn[4];
+		quatmath::fromRotationVector(turn, Jtr);
+		quatmath::multiply(quat, turn, quat);
+		const double norm = std::sqrt(quatmath::dot(quat, quat));
+		double step = 0;
+		for (int k = 0; k < 4; ++k) {
+			quat[k] /= norm;
+		}
+		for (int k = 0; k < 3; ++k) {
+			pos[k] += Jtr[3 + k];
+			step += Jtr[k] * Jtr[k] + Jtr[3 + k] * Jtr[3 + k];
+		}
+		converged = (step < CONVERGED_STEP * CONVERGED_STEP);
+	}
+}
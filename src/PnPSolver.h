@@ -0,0 +1,127 @@
+/** @file	PnPSolver.h
+	@brief	header for the 6-DOF pose solver for three or four LEDs
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _PNPSOLVER_H
+#define _PNPSOLVER_H
+
+// Internal Includes
+#include "LedConstellation.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+/// @brief Perspective-n-point: finds the head pose (head frame in the
+/// camera frame, see LedConstellation) whose LEDs project onto the blobs
+/// the camera saw.
+///
+/// Gauss-Newton on the reprojection error in normalized coordinates,
+/// over a rotation increment and the translation. Each solve starts from
+/// the previous frame's pose, and matches blobs to LEDs by where that
+/// pose puts them, so a tracking solve takes a couple of iterations. With
+/// no usable previous pose (the first frame, or after a failed solve),
+/// every matching of blobs to LEDs is tried from a head facing the
+/// camera, and the best fit kept. No allocation.
+///
+/// Three blobs fit every branch of the solution exactly, so there the
+/// fit only shows convergence: the pose kept is the one turned least from
+/// the previous pose, which it may not stray far from, or when starting
+/// cold from facing the camera.
+class PnPSolver {
+	public:
+		enum {
+			/// Iteration cap when starting from the previous pose
+			MAX_ITERATIONS = 10,
+			/// Iteration cap per matching, starting cold
+			MAX_COLD_ITERATIONS = 30
+		};
+
+		PnPSolver();
+
+		/// @brief Set the LEDs to solve for, forgetting the previous pose.
+		void setConstellation(const LedConstellation & constellation);
+		const LedConstellation & getConstellation() const;
+
+		/// @brief Forget the previous pose - the next solve starts cold.
+		void reset();
+
+		/// @brief Solve from the blobs seen, in normalized camera
+		/// coordinates (IrCamera.h), in any order.
+		/// @returns false, leaving the outputs alone, with fewer than 3
+		/// blobs, more blobs than LEDs, or no good fit.
+		bool solve(const double points[][2], const int numPoints,
+			double pos[3], double quat[4]);
+
+		/// @name About the last solve
+		/// @{
+		int getIterations() const;
+		/// RMS reprojection error, in normalized units (about radians)
+		double getError() const;
+		bool wasCold() const;
+		/// @}
+
+	protected:
+		/// @brief Refine pos and quat in place, blob i being LED matched[i].
+		/// @returns the RMS reprojection error.
+		double refine(const double points[][2], const int numPoints, const int matched[],
+			double pos[3], double quat[4], const int maxIterations, int & iterations) const;
+
+		/// @brief Match blobs to the LEDs nearest where pose puts them.
+		bool matchToPose(const double points[][2], const int numPoints,
+			const double pos[3], const double quat[4], int matched[]) const;
+
+		/// @brief Try every matching from a head facing the camera.
+		bool solveCold(const double points[][2], const int numPoints);
+
+		LedConstellation _constellation;
+
+		/// @name The previous solved pose
+		/// @{
+		bool _seeded;
+		double _pos[3];
+		double _quat[4];
+		/// @}
+
+		int _iterations;
+		double _error;
+		bool _cold;
+};
+
+// -- inline implementations -- //
+
+inline const LedConstellation & PnPSolver::getConstellation() const {
+	return _constellation;
+}
+
+inline int PnPSolver::getIterations() const {
+	return _iterations;
+}
+
+inline double PnPSolver::getError() const {
+	return _error;
+}
+
+inline bool PnPSolver::wasCold() const {
+	return _cold;
+}
+
+#endif // _PNPSOLVER_H
@@ -0,0 +1,404 @@
+/**	@file	PoseConnection.cpp
+	@brief	Implementation of the VRPN server connection that can keep slow clients current
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "PoseConnection.h"
+#include "MonotonicClock.h"
+#include "EventLoop.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#	include <netinet/in.h>
+#	include <netinet/tcp.h>
+#	include <poll.h>
+#	include <sys/ioctl.h>
+#	include <sys/socket.h>
+#	ifdef __linux__
+#		include <linux/sockios.h>
+#	endif
+#else
+typedef int socklen_t;
+#endif
+
+const unsigned long PoseConnection::BEHIND_BYTES = 4096;
+
+/// @brief Bytes the kernel holds for s that the client has yet to take,
+/// where the platform can tell, and whether s would take more now.
+static unsigned long unsentBytes(const SOCKET s, bool & writable) {
+	// poll, not select: a descriptor past FD_SETSIZE can't go in an fd_set
+#ifdef _WIN32
+	WSAPOLLFD fd;
+	fd.fd = s;
+	fd.events = POLLOUT;
+	fd.revents = 0;
+	writable = WSAPoll(&fd, 1, 0) > 0 && (fd.revents & POLLOUT);
+#else
+	struct pollfd fd;
+	fd.fd = s;
+	fd.events = POLLOUT;
+	fd.revents = 0;
+	writable = poll(&fd, 1, 0) > 0 && (fd.revents & POLLOUT);
+#endif
+
+	int bytes = 0;
+#if defined(SIOCOUTQ)
+	if (ioctl(s, SIOCOUTQ, &bytes) != 0) {
+		bytes = 0;
+	}
+#elif defined(SO_NWRITE)
+	socklen_t size = sizeof(bytes);
+	if (getsockopt(s, SOL_SOCKET, SO_NWRITE, &bytes, &size) != 0) {
+		bytes = 0;
+	}
+#endif
+	return bytes > 0 ? (unsigned long)(bytes) : 0;
+}
+
+PoseConnection::PoseConnection(const unsigned short listenPort) :
+		vrpn_Connection_IP(listenPort),
+		_latestValue(false),
+		_numSenders(0),
+		_noDelay(false),
+		_socketBuffer(0),
+		_socketOptionsChanged(false) {
+	// The same ids vrpn_Tracker registers for its reports
+	_trackerTypes[0] = register_message_type("vrpn_Tracker Pos_Quat");
+	_trackerTypes[1] = register_message_type("vrpn_Tracker Velocity");
+	_trackerTypes[2] = register_message_type("vrpn_Tracker Acceleration");
+	for (int i = 0; i < MAX_CLIENTS; ++i) {
+		_clients[i].socket = INVALID_SOCKET;
+		_clients[i].udpSocket = INVALID_SOCKET;
+		_clients[i].defaultNoDelay = 0;
+		_clients[i].optionsApplied = false;
+		_clients[i].behind = false;
+		_clients[i].waiting = false;
+		_clients[i].waitingSince = 0;
+		_clients[i].numHeld = 0;
+		_clients[i].heldSince = 0;
+		for (int h = 0; h < MAX_HELD; ++h) {
+			_clients[i].held[h].used = false;
+		}
+	}
+}
+
+void PoseConnection::setLatestValue(const bool latest) {
+	_latestValue = latest;
+	if (!latest) {
+		// Nothing may stay held once we stop looking after it
+		for (int i = 0; i < MAX_CLIENTS; ++i) {
+			release(i);
+		}
+	}
+}
+
+bool PoseConnection::setTransport(const char * sender, const TransportParameters & params) {
+	const vrpn_int32 id = register_sender(sender);
+	int i = 0;
+	while (i < _numSenders && _senders[i].sender != id) {
+		++i;
+	}
+	if (params == TransportParameters()) {
+		if (i < _numSenders) {
+			_senders[i] = _senders[--_numSenders];
+		}
+	} else {
+		if (i == _numSenders) {
+			if (_numSenders == MAX_SENDERS) {
+				return false;
+			}
+			_numSenders++;
+		}
+		_senders[i].sender = id;
+		_senders[i].mode = params.mode;
+		_senders[i].socketBuffer = params.socketBuffer;
+	}
+
+	_noDelay = false;
+	_socketBuffer = 0;
+	for (int s = 0; s < _numSenders; ++s) {
+		_noDelay = _noDelay || _senders[s].mode == TRANSPORT_UNRELIABLE;
+		if (_senders[s].socketBuffer > _socketBuffer) {
+			_socketBuffer = _senders[s].socketBuffer;
+		}
+	}
+	_socketOptionsChanged = true;
+	return true;
+}
+
+void PoseConnection::addDescriptors(EventLoop & loop) const {
+	// New clients knock on these
+	if (listen_tcp_sock != INVALID_SOCKET) {
+		loop.addDescriptor(int(listen_tcp_sock));
+	}
+	if (listen_udp_sock != INVALID_SOCKET) {
+		loop.addDescriptor(int(listen_udp_sock));
+	}
+	for (int i = 0; i < vrpn_MAX_ENDPOINTS; ++i) {
+		const vrpn_Endpoint_IP * endpoint = d_endpoints[i];
+		if (!endpoint) {
+			continue;
+		}
+		if (endpoint->d_tcpSocket != INVALID_SOCKET) {
+			loop.addDescriptor(int(endpoint->d_tcpSocket));
+		}
+		if (endpoint->d_udpInboundSocket != INVALID_SOCKET) {
+			loop.addDescriptor(int(endpoint->d_udpInboundSocket));
+		}
+	}
+}
+
+int PoseConnection::mainloop(const struct timeval * timeout) {
+	updateClients();
+	const int ret = vrpn_Connection_IP::mainloop(timeout);
+	recordSends();
+	return ret;
+}
+
+int PoseConnection::pack_message(vrpn_uint32 len, struct timeval time,
+		vrpn_int32 type, vrpn_int32 sender, const char * buffer,
+		vrpn_uint32 class_of_service) {
+	class_of_service = serviceFor(sender, class_of_service);
+	const double now = monotonic::seconds();
+	if (!_latestValue || !canSupersede(type, len, class_of_service)) {
+		const int ret = vrpn_Connection_IP::pack_message(len, time, type, sender,
+			buffer, class_of_service);
+		for (int i = 0; i < MAX_CLIENTS; ++i) {
+			if (_clients[i].socket != INVALID_SOCKET) {
+				waitFrom(i, now);
+				_delivery[i].delivered++;
+			}
+		}
+		return ret;
+	}
+
+	// Same as the base class, but client by client
+	int ret = 0;
+	for (int i = 0; i < vrpn_MAX_ENDPOINTS; ++i) {
+		vrpn_Endpoint_IP * endpoint = d_endpoints[i];
+		if (!endpoint || endpoint->d_tcpSocket == INVALID_SOCKET) {
+			continue;
+		}
+		if (i < MAX_CLIENTS && _clients[i].socket == endpoint->d_tcpSocket) {
+			if (_clients[i].behind) {
+				hold(i, len, time, type, sender, buffer, class_of_service);
+				continue;
+			}
+			waitFrom(i, now);
+			_delivery[i].delivered++;
+		}
+		if (endpoint->pack_message(len, time, type, sender, buffer, class_of_service)) {
+			ret = -1;
+		}
+	}
+	// In-process remotes get every report
+	if (do_callbacks_for(type, sender, time, len, buffer)) {
+		ret = -1;
+	}
+	return ret;
+}
+
+void PoseConnection::updateClients() {
+	for (int i = 0; i < MAX_CLIENTS; ++i) {
+		ClientState & c = _clients[i];
+		const SOCKET s = d_endpoints[i] ? d_endpoints[i]->d_tcpSocket : INVALID_SOCKET;
+		const SOCKET udp = d_endpoints[i] ? d_endpoints[i]->d_udpOutboundSocket : INVALID_SOCKET;
+		if (s != c.socket) {
+			// A client left, or a new one took its slot
+			c.socket = s;
+			c.behind = false;
+			c.waiting = false;
+			c.numHeld = 0;
+			for (int h = 0; h < MAX_HELD; ++h) {
+				c.held[h].used = false;
+			}
+			_delivery[i].reset();
+			_delivery[i].connected = (s != INVALID_SOCKET);
+			c.defaultNoDelay = 0;
+			if (s != INVALID_SOCKET) {
+				// Whatever VRPN chose, to go back to if Nagle is wanted again
+				socklen_t size = sizeof(c.defaultNoDelay);
+				getsockopt(s, IPPROTO_TCP, TCP_NODELAY, (char *)&c.defaultNoDelay, &size);
+			}
+			c.udpSocket = INVALID_SOCKET;
+			c.optionsApplied = false;
+		}
+		if (s != INVALID_SOCKET && (udp != c.udpSocket || !c.optionsApplied || _socketOptionsChanged)) {
+			c.udpSocket = udp;
+			applySocketOptions(c, s);
+			c.optionsApplied = true;
+		}
+		if (s == INVALID_SOCKET) {
+			continue;
+		}
+		bool writable = false;
+		_delivery[i].queueDepth = unsentBytes(s, writable);
+		c.behind = !writable || _delivery[i].queueDepth > BEHIND_BYTES;
+		if (!c.behind) {
+			release(i);
+		}
+	}
+	_socketOptionsChanged = false;
+}
+
+void PoseConnection::recordSends() {
+	const double now = monotonic::seconds();
+	for (int i = 0; i < MAX_CLIENTS; ++i) {
+		ClientState & c = _clients[i];
+		if (c.waiting) {
+			_delivery[i].sendLatency.record(now - c.waitingSince);
+			c.waiting = false;
+		}
+	}
+}
+
+vrpn_uint32 PoseConnection::serviceFor(const vrpn_int32 sender, const vrpn_uint32 classOfService) const {
+	if (sender < 0) {
+		// System messages go as VRPN sends them
+		return classOfService;
+	}
+	for (int i = 0; i < _numSenders; ++i) {
+		if (_senders[i].sender != sender) {
+			continue;
+		}
+		switch (_senders[i].mode) {
+			case TRANSPORT_RELIABLE:
+				return vrpn_CONNECTION_RELIABLE;
+			case TRANSPORT_UNRELIABLE:
+				return vrpn_CONNECTION_LOW_LATENCY;
+			case TRANSPORT_DEFAULT:
+				break;
+		}
+		break;
+	}
+	return classOfService;
+}
+
+void PoseConnection::applySocketOptions(const ClientState & c, const SOCKET tcp) const {
+	const int noDelay = _noDelay ? 1 : c.defaultNoDelay;
+	if (setsockopt(tcp, IPPROTO_TCP, TCP_NODELAY, (const char *)&noDelay, sizeof(noDelay)) != 0) {
+		std::cerr << "PoseConnection: could not set Nagle's algorithm" << std::endl;
+	}
+	if (_socketBuffer > 0) {
+		const int bytes = _socketBuffer * 1024;
+		if (setsockopt(tcp, SOL_SOCKET, SO_SNDBUF, (const char *)&bytes, sizeof(bytes)) != 0 ||
+				(c.udpSocket != INVALID_SOCKET &&
+				 setsockopt(c.udpSocket, SOL_SOCKET, SO_SNDBUF, (const char *)&bytes, sizeof(bytes)) != 0)) {
+			std::cerr << "PoseConnection: could not set socket buffer size" << std::endl;
+		}
+	}
+}
+
+bool PoseConnection::canSupersede(const vrpn_int32 type, const vrpn_uint32 len,
+		const vrpn_uint32 classOfService) const {
+	// System messages and anything sent reliably must all arrive
+	return type >= 0 && len <= HELD_SIZE &&
+		(classOfService & vrpn_CONNECTION_LOW_LATENCY) &&
+		!(classOfService & vrpn_CONNECTION_RELIABLE);
+}
+
+vrpn_int32 PoseConnection::sensorOf(const vrpn_int32 type, const char * buffer) const {
+	for (int i = 0; i < 3; ++i) {
+		if (type == _trackerTypes[i]) {
+			// Leads the report, in network order: fine for comparing
+			vrpn_int32 sensor;
+			std::memcpy(&sensor, buffer, sizeof(sensor));
+			return sensor;
+		}
+	}
+	return -1;
+}
+
+void PoseConnection::hold(const int client, vrpn_uint32 len, struct timeval time,
+		vrpn_int32 type, vrpn_int32 sender, const char * buffer,
+		vrpn_uint32 classOfService) {
+	ClientState & c = _clients[client];
+	const vrpn_int32 sensor = len >= sizeof(vrpn_int32) ? sensorOf(type, buffer) : -1;
+	HeldReport * slot = NULL;
+	HeldReport * unused = NULL;
+	for (int h = 0; h < MAX_HELD; ++h) {
+		HeldReport & held = c.held[h];
+		if (!held.used) {
+			if (!unused) {
+				unused = &held;
+			}
+		} else if (held.type == type && held.sender == sender && held.sensor == sensor) {
+			slot = &held;
+			break;
+		}
+	}
+
+	if (slot) {
+		_delivery[client].superseded++;
+	} else if (unused) {
+		slot = unused;
+		if (c.numHeld == 0) {
+			c.heldSince = monotonic::seconds();
+		}
+		c.numHeld++;
+	} else {
+		// More kinds of report than we hold: queue it as usual
+		d_endpoints[client]->pack_message(len, time, type, sender, buffer, classOfService);
+		waitFrom(client, monotonic::seconds());
+		_delivery[client].delivered++;
+		return;
+	}
+	slot->used = true;
+	slot->type = type;
+	slot->sender = sender;
+	slot->sensor = sensor;
+	slot->time = time;
+	slot->classOfService = classOfService;
+	slot->len = len;
+	std::memcpy(slot->buffer, buffer, len);
+}
+
+void PoseConnection::release(const int client) {
+	ClientState & c = _clients[client];
+	if (c.numHeld == 0) {
+		return;
+	}
+	vrpn_Endpoint_IP * endpoint = d_endpoints[client];
+	for (int h = 0; h < MAX_HELD; ++h) {
+		HeldReport & held = c.held[h];
+		if (!held.used) {
+			continue;
+		}
+		if (endpoint && endpoint->d_tcpSocket == c.socket) {
+			endpoint->pack_message(held.len, held.time, held.type, held.sender,
+				held.buffer, held.classOfService);
+			_delivery[client].delivered++;
+		}
+		held.used = false;
+	}
+	waitFrom(client, c.heldSince);
+	c.numHeld = 0;
+}
+
+void PoseConnection::waitFrom(const int client, const double since) {
+	ClientState & c = _clients[client];
+	if (!c.waiting || since < c.waitingSince) {
+		c.waitingSince = since;
+		c.waiting = true;
+	}
+}
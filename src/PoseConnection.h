@@ -0,0 +1,211 @@
+/** @file	PoseConnection.h
+	@brief	header for a VRPN server connection that can keep slow clients current
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _POSECONNECTION_H
+#define _POSECONNECTION_H
+
+// Internal Includes
+#include "StageMetrics.h"
+
+// Library/third-party includes
+#include <vrpn_Connection.h>
+
+// Standard includes
+// - none
+
+class EventLoop;
+
+/// @brief Which VRPN channel a tracker's reports are sent on
+enum PoseTransport {
+	/// As the device sends them: low-latency (UDP, where the client
+	/// opened it) for VRPN's own tracker and analog reports
+	TRANSPORT_DEFAULT,
+	/// Every report on the reliable (TCP) channel, in order
+	TRANSPORT_RELIABLE,
+	/// Every report on the low-latency channel, and Nagle's algorithm
+	/// off on the reliable one
+	TRANSPORT_UNRELIABLE
+};
+
+/// @brief How a tracker's reports reach clients
+struct TransportParameters {
+	TransportParameters() :
+			mode(TRANSPORT_DEFAULT),
+			socketBuffer(0) {}
+
+	bool operator==(const TransportParameters & other) const {
+		return mode == other.mode && socketBuffer == other.socketBuffer;
+	}
+	bool operator!=(const TransportParameters & other) const {
+		return !(*this == other);
+	}
+
+	PoseTransport mode;
+	/// Kernel send buffer for each client socket, in kilobytes - 0 to
+	/// leave the system's
+	int socketBuffer;
+};
+
+/// @brief The tracker's VRPN server connection, with per-client delivery
+/// accounting and an optional latest-value mode for slow clients.
+///
+/// Normally every report is queued for every client, so one that stalls
+/// drains a backlog of stale poses once it recovers - and, once its
+/// socket fills, holds up the whole server. In latest-value mode, a
+/// client whose socket has more than BEHIND_BYTES unsent is passed over:
+/// its newest low-latency report from each sender (and tracker sensor)
+/// is held, replacing any held before, and sent once the client catches
+/// up. Reliable messages are always queued, and clients keep up or fall
+/// behind independently of one another.
+///
+/// Reports already in a client's own receive buffer can't be recalled,
+/// so a stalled client may still see that much stale data.
+///
+/// Each tracker's transport is set by sender name. Socket options apply
+/// to all clients: Nagle is off while any tracker asks for the unreliable
+/// transport (and as VRPN left it otherwise), and send buffers are the
+/// largest any tracker asks for.
+class PoseConnection : public vrpn_Connection_IP {
+	public:
+		enum {
+			/// Clients accounted for, in order of connection slot - any
+			/// beyond are served as usual
+			MAX_CLIENTS = StageMetrics::CLIENTS,
+			/// Distinct reports held per client
+			MAX_HELD = 8,
+			/// Largest report that can be held
+			HELD_SIZE = 256,
+			/// Senders with their own transport - one per station
+			MAX_SENDERS = 16
+		};
+		/// Unsent bytes past which a client counts as behind: a few
+		/// dozen poses
+		static const unsigned long BEHIND_BYTES;
+
+		PoseConnection(const unsigned short listenPort);
+
+		void setLatestValue(const bool latest);
+		bool usingLatestValue() const;
+
+		/// @brief Send the reports of sender (a tracker name, shared by
+		/// its confidence device) as params says - default parameters
+		/// forget the sender. @returns false if there is no room.
+		bool setTransport(const char * sender, const TransportParameters & params);
+
+		/// @brief Register every socket a client's request or report
+		/// could arrive on, so input wakes the loop.
+		void addDescriptors(EventLoop & loop) const;
+
+		/// @brief Delivery to the client in connection slot i - only
+		/// meaningful while getClient(i).connected.
+		const ClientDelivery & getClient(const int i) const;
+
+		/// @name vrpn_Connection overrides
+		/// @{
+		virtual int mainloop(const struct timeval * timeout = NULL);
+		virtual int pack_message(vrpn_uint32 len, struct timeval time,
+			vrpn_int32 type, vrpn_int32 sender, const char * buffer,
+			vrpn_uint32 class_of_service);
+		/// @}
+
+	protected:
+		struct HeldReport {
+			bool used;
+			vrpn_int32 type;
+			vrpn_int32 sender;
+			vrpn_int32 sensor;
+			struct timeval time;
+			vrpn_uint32 classOfService;
+			vrpn_uint32 len;
+			char buffer[HELD_SIZE];
+		};
+
+		struct SenderTransport {
+			vrpn_int32 sender;
+			PoseTransport mode;
+			int socketBuffer;
+		};
+
+		struct ClientState {
+			SOCKET socket;
+			/// Created once the client describes its UDP port
+			SOCKET udpSocket;
+			/// TCP_NODELAY as the client connected
+			int defaultNoDelay;
+			/// Whether socket options have been set since it connected
+			bool optionsApplied;
+			bool behind;
+			/// Whether packed reports are waiting to be sent, and since when
+			bool waiting;
+			double waitingSince;
+			/// Reports held back, and since when
+			int numHeld;
+			double heldSince;
+			HeldReport held[MAX_HELD];
+		};
+
+		/// @brief Notice clients arriving and leaving, and which are behind
+		void updateClients();
+		/// @brief Account for reports sent by the last pass
+		void recordSends();
+
+		/// @brief Class of service for a message, after its sender's
+		/// transport has had its say
+		vrpn_uint32 serviceFor(const vrpn_int32 sender, const vrpn_uint32 classOfService) const;
+		void applySocketOptions(const ClientState & c, const SOCKET tcp) const;
+
+		bool canSupersede(const vrpn_int32 type, const vrpn_uint32 len,
+			const vrpn_uint32 classOfService) const;
+		/// @brief Tracker reports are superseded per sensor, others per
+		/// sender and type
+		vrpn_int32 sensorOf(const vrpn_int32 type, const char * buffer) const;
+
+		void hold(const int client, vrpn_uint32 len, struct timeval time,
+			vrpn_int32 type, vrpn_int32 sender, const char * buffer,
+			vrpn_uint32 classOfService);
+		/// @brief Pack a caught-up client's held reports
+		void release(const int client);
+		void waitFrom(const int client, const double since);
+
+		bool _latestValue;
+		vrpn_int32 _trackerTypes[3];
+
+		SenderTransport _senders[MAX_SENDERS];
+		int _numSenders;
+		/// Socket options, from all senders' transports
+		bool _noDelay;
+		int _socketBuffer;
+		bool _socketOptionsChanged;
+
+		ClientState _clients[MAX_CLIENTS];
+		ClientDelivery _delivery[MAX_CLIENTS];
+};
+
+// -- inline implementations -- //
+
+inline bool PoseConnection::usingLatestValue() const {
+	return _latestValue;
+}
+
+inline const ClientDelivery & PoseConnection::getClient(const int i) const {
+	return _delivery[i];
+}
+
+#endif // _POSECONNECTION_H
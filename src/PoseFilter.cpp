@@ -0,0 +1,114 @@
+/**	@file	PoseFilter.cpp
+	@brief	Implementation of adaptive (One Euro) smoothing of head poses
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "PoseFilter.h"
+#include "QuaternionMath.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+
+/// @brief Smoothing factor of a first-order low-pass at cutoff (Hz) for a
+/// sample interval of dt (s).
+static inline double lowPassAlpha(const double cutoff, const double dt) {
+	const double tau = 1.0 / (2.0 * 3.14159265358979323846 * cutoff);
+	return 1.0 / (1.0 + tau / dt);
+}
+
+PoseFilter::PoseFilter() :
+		_params(),
+		_initialized(false),
+		_lastTime(0),
+		_speed(0),
+		_angularSpeed(0) {
+}
+
+void PoseFilter::setParameters(const FilterParameters & params) {
+	if (params.enabled() && !_params.enabled()) {
+		// Don't resume from a stale pose
+		reset();
+	}
+	_params = params;
+}
+
+void PoseFilter::reset() {
+	_initialized = false;
+	_speed = 0;
+	_angularSpeed = 0;
+}
+
+void PoseFilter::filter(const double time, double pos[3], double quat[4]) {
+	const double dt = time - _lastTime;
+	if (!_initialized || dt <= 0 || dt > 1.0) {
+		// First sample, or after a gap long enough that there is no
+		// motion estimate worth keeping: pass it through.
+		for (int i = 0; i < 3; ++i) {
+			_pos[i] = pos[i];
+		}
+		for (int i = 0; i < 4; ++i) {
+			_quat[i] = quat[i];
+		}
+		_speed = 0;
+		_angularSpeed = 0;
+		_lastTime = time;
+		_initialized = true;
+		return;
+	}
+	_lastTime = time;
+
+	const double derivativeAlpha = lowPassAlpha(_params.derivativeCutoff, dt);
+
+	// Position
+	double dx[3];
+	double distSquared = 0;
+	for (int i = 0; i < 3; ++i) {
+		dx[i] = pos[i] - _pos[i];
+		distSquared += dx[i] * dx[i];
+	}
+	_speed += derivativeAlpha * (std::sqrt(distSquared) / dt - _speed);
+	const double posAlpha = lowPassAlpha(_params.minCutoff + _params.positionBeta * _speed, dt);
+	for (int i = 0; i < 3; ++i) {
+		_pos[i] += posAlpha * dx[i];
+		pos[i] = _pos[i];
+	}
+
+	// Orientation
+	const double angle = quatmath::angleBetween(_quat, quat);
+	_angularSpeed += derivativeAlpha * (angle / dt - _angularSpeed);
+	const double quatAlpha = lowPassAlpha(_params.minCutoff + _params.orientationBeta * _angularSpeed, dt);
+	quatmath::slerp(_quat, _quat, quat, quatAlpha);
+	for (int i = 0; i < 4; ++i) {
+		quat[i] = _quat[i];
+	}
+}
+
+bool PoseFilter::last(double pos[3], double quat[4]) const {
+	if (!_initialized) {
+		return false;
+	}
+	for (int i = 0; i < 3; ++i) {
+		pos[i] = _pos[i];
+	}
+	for (int i = 0; i < 4; ++i) {
+		quat[i] = _quat[i];
+	}
+	return true;
+}
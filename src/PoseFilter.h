@@ -0,0 +1,97 @@
+/** @file	PoseFilter.h
+	@brief	header for adaptive (One Euro) smoothing of head poses
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _POSEFILTER_H
+#define _POSEFILTER_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+/// @brief Tuning for PoseFilter, as stored in the configuration.
+struct FilterParameters {
+	FilterParameters(const double minCutoff_ = 0,
+		const double derivativeCutoff_ = 1.0,
+		const double positionBeta_ = 10.0,
+		const double orientationBeta_ = 2.0) :
+			minCutoff(minCutoff_),
+			derivativeCutoff(derivativeCutoff_),
+			positionBeta(positionBeta_),
+			orientationBeta(orientationBeta_) {}
+
+	bool enabled() const {
+		return minCutoff > 0;
+	}
+
+	/// Cutoff (Hz) when holding still - lower is smoother; 0 disables
+	double minCutoff;
+	/// Cutoff (Hz) for the speed estimate itself
+	double derivativeCutoff;
+	/// Extra cutoff (Hz) per m/s of head speed - higher is less laggy
+	double positionBeta;
+	/// Extra cutoff (Hz) per rad/s of head rotation
+	double orientationBeta;
+};
+
+/// @brief One Euro filter for a pose: a low-pass filter whose cutoff rises
+/// with the speed of motion, so a still head is steady and a moving one
+/// isn't lagged. Position uses the speed of the whole vector, so all axes
+/// share one cutoff; orientation is filtered by slerp, driven by angular
+/// speed. No allocation, a few hundred nanoseconds per sample.
+class PoseFilter {
+	public:
+		PoseFilter();
+
+		void setParameters(const FilterParameters & params);
+		const FilterParameters & getParameters() const;
+
+		/// @brief Forget the signal history - the next sample passes through.
+		void reset();
+
+		/// @brief Filter a sample taken at time (seconds), in place.
+		void filter(const double time, double pos[3], double quat[4]);
+
+		/// @brief Copy out the latest filtered pose.
+		/// @returns false if there is none yet.
+		bool last(double pos[3], double quat[4]) const;
+
+	protected:
+		FilterParameters _params;
+		bool _initialized;
+		double _lastTime;
+		double _pos[3];
+		double _quat[4];
+		/// Low-passed speeds, m/s and rad/s
+		double _speed;
+		double _angularSpeed;
+};
+
+// -- inline implementations -- //
+
+inline const FilterParameters & PoseFilter::getParameters() const {
+	return _params;
+}
+
+#endif // _POSEFILTER_H
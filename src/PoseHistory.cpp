@@ -0,0 +1,140 @@
+/**	@file	PoseHistory.cpp
+	@brief	Implementation of the time-indexed ring of recent poses
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "PoseHistory.h"
+#include "AtomicOps.h"
+#include "QuaternionMath.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+static const unsigned long MASK = PoseHistory::CAPACITY - 1;
+
+PoseHistory::PoseHistory() :
+		_sequence(0),
+		_count(0) {
+}
+
+void PoseHistory::clear() {
+	const long sequence = _sequence;
+	_sequence = sequence + 1;
+	atomic::barrier();
+	_count = 0;
+	atomic::barrier();
+	_sequence = sequence + 2;
+}
+
+void PoseHistory::push(const double time, const double pos[3], const double quat[4]) {
+	const unsigned long count = _count;
+	if (count > 0 && time <= _time[(count - 1) & MASK]) {
+		return;
+	}
+	const long sequence = _sequence;
+	_sequence = sequence + 1;
+	atomic::barrier();
+	const unsigned long slot = count & MASK;
+	_time[slot] = time;
+	for (int i = 0; i < 3; ++i) {
+		_pos[i][slot] = pos[i];
+	}
+	for (int i = 0; i < 4; ++i) {
+		_quat[i][slot] = quat[i];
+	}
+	_count = count + 1;
+	atomic::barrier();
+	_sequence = sequence + 2;
+}
+
+unsigned long PoseHistory::search(unsigned long first, unsigned long last,
+		const double time) const {
+	// Invariant: _time at first <= time, and at anything past last > time
+	while (first < last) {
+		const unsigned long mid = first + (last - first + 1) / 2;
+		if (_time[mid & MASK] <= time) {
+			first = mid;
+		} else {
+			last = mid - 1;
+		}
+	}
+	return first;
+}
+
+bool PoseHistory::poseAt(const double time, double pos[3], double quat[4]) const {
+	for (;;) {
+		const long before = atomic::load(&_sequence);
+		if (before & 1) {
+			continue;
+		}
+		const unsigned long count = _count;
+		const unsigned long held = count < CAPACITY ? count : (unsigned long)(CAPACITY);
+		bool found = false;
+		if (held > 0 && time >= _time[(count - held) & MASK] &&
+				time <= _time[(count - 1) & MASK]) {
+			const unsigned long a = search(count - held, count - 1, time) & MASK;
+			if (_time[a] == time || ((a + 1) & MASK) == (count & MASK)) {
+				for (int i = 0; i < 3; ++i) {
+					pos[i] = _pos[i][a];
+				}
+				for (int i = 0; i < 4; ++i) {
+					quat[i] = _quat[i][a];
+				}
+			} else {
+				const unsigned long b = (a + 1) & MASK;
+				const double t = (time - _time[a]) / (_time[b] - _time[a]);
+				for (int i = 0; i < 3; ++i) {
+					pos[i] = _pos[i][a] + t * (_pos[i][b] - _pos[i][a]);
+				}
+				double qa[4];
+				double qb[4];
+				for (int i = 0; i < 4; ++i) {
+					qa[i] = _quat[i][a];
+					qb[i] = _quat[i][b];
+				}
+				quatmath::slerp(quat, qa, qb, t);
+			}
+			found = true;
+		}
+		atomic::barrier();
+		if (_sequence == before) {
+			return found;
+		}
+	}
+}
+
+bool PoseHistory::span(double & oldest, double & newest) const {
+	for (;;) {
+		const long before = atomic::load(&_sequence);
+		if (before & 1) {
+			continue;
+		}
+		const unsigned long count = _count;
+		const unsigned long held = count < CAPACITY ? count : (unsigned long)(CAPACITY);
+		if (held > 0) {
+			oldest = _time[(count - held) & MASK];
+			newest = _time[(count - 1) & MASK];
+		}
+		atomic::barrier();
+		if (_sequence == before) {
+			return held > 0;
+		}
+	}
+}
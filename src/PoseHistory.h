@@ -0,0 +1,88 @@
+/** @file	PoseHistory.h
+	@brief	header for a time-indexed ring of recent poses
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _POSEHISTORY_H
+#define _POSEHISTORY_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+/// @brief The last CAPACITY poses a tracker published, by report time,
+/// for answering "where was the head at time t" - e.g. at a renderer's
+/// predicted scan-out time rather than whenever the last pose came in.
+///
+/// Stored structure-of-arrays: a query binary searches the time stamps
+/// alone, then touches the two poses either side of t, interpolating
+/// position linearly and orientation by slerp.
+///
+/// One thread pushes; any number may query at the same time. Queries
+/// are seqlock-guarded like sharedpose::read(), so the writer never
+/// waits and a query overlapping a push simply retries.
+class PoseHistory {
+	public:
+		enum {
+			/// A power of two; 2.5 seconds at 100 Hz
+			CAPACITY = 256
+		};
+
+		PoseHistory();
+
+		/// @name Writer side
+		/// @{
+		void clear();
+		/// @brief Append a pose, time in seconds since the epoch - one
+		/// no newer than the last is ignored.
+		void push(const double time, const double pos[3], const double quat[4]);
+		/// @}
+
+		/// @name Reader side - safe from any thread
+		/// @{
+		/// @brief Pose at time, interpolated between the poses either
+		/// side of it.
+		/// @returns false if time is outside the span held.
+		bool poseAt(const double time, double pos[3], double quat[4]) const;
+
+		/// @brief Time span held: false if empty.
+		bool span(double & oldest, double & newest) const;
+		/// @}
+
+	protected:
+		/// @brief Logical index of the last pose at or before time, the
+		/// caller having checked that first holds one
+		unsigned long search(unsigned long first, unsigned long last,
+			const double time) const;
+
+		/// Seqlock count: odd during a push
+		volatile long _sequence;
+		/// Poses pushed since the last clear; the newest is at
+		/// (_count - 1) % CAPACITY
+		volatile long _count;
+		double _time[CAPACITY];
+		double _pos[3][CAPACITY];
+		double _quat[4][CAPACITY];
+};
+
+#endif // _POSEHISTORY_H
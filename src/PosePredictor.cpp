@@ -0,0 +1,148 @@
+/**	@file	PosePredictor.cpp
+	@brief	Implementation of head pose extrapolation
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "PosePredictor.h"
+#include "QuaternionMath.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+
+PosePredictor::PosePredictor() :
+		_model(PREDICT_CONSTANT_VELOCITY) {
+	reset();
+}
+
+void PosePredictor::reset() {
+	_newest = 0;
+	_count = 0;
+}
+
+void PosePredictor::setModel(PredictionModel model) {
+	_model = model;
+}
+
+const PosePredictor::Sample & PosePredictor::sampleAgo(unsigned int n) const {
+	return _samples[(_newest + WINDOW - n) % WINDOW];
+}
+
+void PosePredictor::addSample(const double time, const double pos[3], const double quat[4]) {
+	if (_count > 0 && time <= sampleAgo(0).time) {
+		// Same frame reported again - nothing new to fit
+		return;
+	}
+	_newest = (_newest + 1) % WINDOW;
+	Sample & s = _samples[_newest];
+	s.time = time;
+	for (int i = 0; i < 3; ++i) {
+		s.pos[i] = pos[i];
+	}
+	for (int i = 0; i < 4; ++i) {
+		s.quat[i] = quat[i];
+	}
+	if (_count < WINDOW) {
+		_count++;
+	}
+}
+
+bool PosePredictor::predict(const double time, double pos[3], double quat[4]) const {
+	const unsigned int needed = (_model == PREDICT_CONSTANT_ACCELERATION) ? 3 : 2;
+	if (_count < needed) {
+		return false;
+	}
+	const Sample & newest = sampleAgo(0);
+	const Sample & oldest = sampleAgo(_count - 1);
+	const double span = newest.time - oldest.time;
+	if (span <= 0) {
+		return false;
+	}
+
+	// Times relative to the newest sample, so h is "how far ahead"
+	const double h = time - newest.time;
+
+	// Least-squares polynomial fit, per axis: normal equations from the
+	// power sums of t (S0..S4) and of t^k * p (T0..T2).
+	double S[5] = {0, 0, 0, 0, 0};
+	for (unsigned int n = 0; n < _count; ++n) {
+		const double t = sampleAgo(n).time - newest.time;
+		double tk = 1;
+		for (int k = 0; k < 5; ++k) {
+			S[k] += tk;
+			tk *= t;
+		}
+	}
+	for (int axis = 0; axis < 3; ++axis) {
+		double T[3] = {0, 0, 0};
+		for (unsigned int n = 0; n < _count; ++n) {
+			const Sample & s = sampleAgo(n);
+			const double t = s.time - newest.time;
+			T[0] += s.pos[axis];
+			T[1] += t * s.pos[axis];
+			T[2] += t * t * s.pos[axis];
+		}
+
+		if (_model == PREDICT_CONSTANT_ACCELERATION) {
+			// | S0 S1 S2 | |a|   |T0|
+			// | S1 S2 S3 | |b| = |T1|
+			// | S2 S3 S4 | |c|   |T2|
+			const double det = S[0] * (S[2] * S[4] - S[3] * S[3]) -
+				S[1] * (S[1] * S[4] - S[3] * S[2]) +
+				S[2] * (S[1] * S[3] - S[2] * S[2]);
+			if (std::fabs(det) < 1e-30) {
+				return false;
+			}
+			const double a = (T[0] * (S[2] * S[4] - S[3] * S[3]) -
+				S[1] * (T[1] * S[4] - S[3] * T[2]) +
+				S[2] * (T[1] * S[3] - S[2] * T[2])) / det;
+			const double b = (S[0] * (T[1] * S[4] - S[3] * T[2]) -
+				T[0] * (S[1] * S[4] - S[3] * S[2]) +
+				S[2] * (S[1] * T[2] - T[1] * S[2])) / det;
+			const double c = (S[0] * (S[2] * T[2] - T[1] * S[3]) -
+				S[1] * (S[1] * T[2] - T[1] * S[2]) +
+				T[0] * (S[1] * S[3] - S[2] * S[2])) / det;
+			pos[axis] = a + b * h + c * h * h;
+		} else {
+			const double det = S[0] * S[2] - S[1] * S[1];
+			if (std::fabs(det) < 1e-30) {
+				return false;
+			}
+			const double a = (T[0] * S[2] - S[1] * T[1]) / det;
+			const double b = (S[0] * T[1] - S[1] * T[0]) / det;
+			pos[axis] = a + b * h;
+		}
+	}
+
+	// Orientation: mean angular velocity across the window, applied to the
+	// newest orientation.
+	double inverseOldest[4];
+	double delta[4];
+	double omega[3];
+	quatmath::conjugate(inverseOldest, oldest.quat);
+	quatmath::multiply(delta, newest.quat, inverseOldest);
+	quatmath::toRotationVector(omega, delta);
+	for (int i = 0; i < 3; ++i) {
+		omega[i] *= h / span;
+	}
+	double ahead[4];
+	quatmath::fromRotationVector(ahead, omega);
+	quatmath::multiply(quat, ahead, newest.quat);
+	return true;
+}
@@ -0,0 +1,85 @@
+/** @file	PosePredictor.h
+	@brief	header for extrapolating head poses to compensate latency
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _POSEPREDICTOR_H
+#define _POSEPREDICTOR_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+enum PredictionModel {
+	PREDICT_CONSTANT_VELOCITY,
+	PREDICT_CONSTANT_ACCELERATION
+};
+
+/// @brief Extrapolates a pose ahead in time from the last few solved poses.
+///
+/// Position is a least-squares fit over the window - a line for constant
+/// velocity, a parabola for constant acceleration - so single-frame noise
+/// is not amplified the way a two-sample difference would. Orientation
+/// uses the mean angular velocity across the window in either model.
+class PosePredictor {
+	public:
+		enum {
+			WINDOW = 5
+		};
+
+		PosePredictor();
+
+		void reset();
+		void setModel(PredictionModel model);
+		PredictionModel getModel() const;
+
+		/// @brief Add a pose solved from a new frame, at time (seconds).
+		void addSample(const double time, const double pos[3], const double quat[4]);
+
+		/// @brief Extrapolate to time (seconds, same clock as addSample).
+		/// @returns false, leaving outputs alone, until enough samples.
+		bool predict(const double time, double pos[3], double quat[4]) const;
+
+	protected:
+		struct Sample {
+			double time;
+			double pos[3];
+			double quat[4];
+		};
+
+		const Sample & sampleAgo(unsigned int n) const;
+
+		PredictionModel _model;
+		Sample _samples[WINDOW];
+		/// Index of the newest sample
+		unsigned int _newest;
+		unsigned int _count;
+};
+
+// -- inline implementations -- //
+
+inline PredictionModel PosePredictor::getModel() const {
+	return _model;
+}
+
+#endif // _POSEPREDICTOR_H
@@ -0,0 +1,144 @@
+/** @file	QuaternionMath.h
+	@brief	header for the few quaternion operations the pose filters need
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _QUATERNIONMATH_H
+#define _QUATERNIONMATH_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+
+/// @brief Unit quaternion helpers, (x, y, z, w) as VRPN sends them.
+namespace quatmath {
+
+/// @addtogroup FreeFunctions Free Functions
+/// @{
+
+	inline void multiply(double dest[4], const double a[4], const double b[4]) {
+		const double x = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1];
+		const double y = a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0];
+		const double z = a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3];
+		const double w = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2];
+		dest[0] = x;
+		dest[1] = y;
+		dest[2] = z;
+		dest[3] = w;
+	}
+
+	inline void conjugate(double dest[4], const double q[4]) {
+		dest[0] = -q[0];
+		dest[1] = -q[1];
+		dest[2] = -q[2];
+		dest[3] = q[3];
+	}
+
+	/// @brief Rotate vector v by unit quaternion q. dest may alias v.
+	inline void rotate(double dest[3], const double q[4], const double v[3]) {
+		// t = 2 (q.xyz x v); v' = v + w t + q.xyz x t
+		const double tx = 2.0 * (q[1] * v[2] - q[2] * v[1]);
+		const double ty = 2.0 * (q[2] * v[0] - q[0] * v[2]);
+		const double tz = 2.0 * (q[0] * v[1] - q[1] * v[0]);
+		const double x = v[0] + q[3] * tx + q[1] * tz - q[2] * ty;
+		const double y = v[1] + q[3] * ty + q[2] * tx - q[0] * tz;
+		const double z = v[2] + q[3] * tz + q[0] * ty - q[1] * tx;
+		dest[0] = x;
+		dest[1] = y;
+		dest[2] = z;
+	}
+
+	inline double dot(const double a[4], const double b[4]) {
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+	}
+
+	/// @brief Rotation vector (axis times angle, the short way round)
+	inline void toRotationVector(double dest[3], const double q[4]) {
+		const double sign = q[3] < 0 ? -1.0 : 1.0;
+		const double sinHalf = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]);
+		if (sinHalf < 1e-12) {
+			dest[0] = dest[1] = dest[2] = 0;
+			return;
+		}
+		const double angle = 2.0 * std::atan2(sinHalf, sign * q[3]);
+		for (int i = 0; i < 3; ++i) {
+			dest[i] = sign * q[i] / sinHalf * angle;
+		}
+	}
+
+	inline void fromRotationVector(double dest[4], const double v[3]) {
+		const double angle = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		if (angle < 1e-12) {
+			dest[0] = dest[1] = dest[2] = 0;
+			dest[3] = 1;
+			return;
+		}
+		const double s = std::sin(angle / 2.0) / angle;
+		dest[0] = v[0] * s;
+		dest[1] = v[1] * s;
+		dest[2] = v[2] * s;
+		dest[3] = std::cos(angle / 2.0);
+	}
+
+	/// @brief Angle in radians between two orientations
+	inline double angleBetween(const double a[4], const double b[4]) {
+		const double d = std::fabs(dot(a, b));
+		return d >= 1.0 ? 0.0 : 2.0 * std::acos(d);
+	}
+
+	/// @brief Spherical interpolation, t = 0 giving a and t = 1 giving b.
+	/// dest may alias a or b.
+	inline void slerp(double dest[4], const double a[4], const double b[4], const double t) {
+		double cosOmega = dot(a, b);
+		// Take the short way round
+		const double sign = cosOmega < 0 ? -1.0 : 1.0;
+		cosOmega *= sign;
+		double wa;
+		double wb;
+		if (cosOmega > 0.9995) {
+			// Nearly parallel: linear interpolation is accurate and stable
+			wa = 1.0 - t;
+			wb = t;
+		} else {
+			const double omega = std::acos(cosOmega);
+			const double sinOmega = std::sin(omega);
+			wa = std::sin((1.0 - t) * omega) / sinOmega;
+			wb = std::sin(t * omega) / sinOmega;
+		}
+		wb *= sign;
+		double norm = 0;
+		for (int i = 0; i < 4; ++i) {
+			dest[i] = wa * a[i] + wb * b[i];
+			norm += dest[i] * dest[i];
+		}
+		norm = std::sqrt(norm);
+		for (int i = 0; i < 4; ++i) {
+			dest[i] /= norm;
+		}
+	}
+
+/// @}
+
+} // end of quatmath namespace
+
+#endif // _QUATERNIONMATH_H
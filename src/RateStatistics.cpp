@@ -0,0 +1,112 @@
+/**	@file	RateStatistics.cpp
+	@brief	Implementation of sliding-window report rate and jitter statistics
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "RateStatistics.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+
+const double RateStatistics::DROP_THRESHOLD = 1.5;
+
+RateStatistics::RateStatistics() {
+	reset();
+}
+
+void RateStatistics::reset() {
+	_haveArrival = false;
+	_lastArrival = 0;
+	_next = 0;
+	_sum = 0;
+	_sumSquares = 0;
+	_minHead = _minTail = 0;
+	_maxHead = _maxTail = 0;
+	_dropped = 0;
+}
+
+void RateStatistics::recordArrival(const double time) {
+	if (!_haveArrival) {
+		_lastArrival = time;
+		_haveArrival = true;
+		return;
+	}
+	const double gap = time - _lastArrival;
+	_lastArrival = time;
+	if (gap < 0) {
+		// Should not happen with a monotonic clock - but don't poison the sums
+		return;
+	}
+
+	const unsigned long count = getSampleCount();
+	if (count > 0) {
+		const double mean = _sum / count;
+		if (mean > 0 && gap >= DROP_THRESHOLD * mean) {
+			_dropped += static_cast<unsigned long>(gap / mean + 0.5) - 1;
+		}
+	}
+
+	const unsigned long seq = _next;
+	if (seq >= WINDOW) {
+		// Slide: the oldest gap leaves the window
+		const unsigned long expired = seq - WINDOW;
+		const double old = gapAt(expired);
+		_sum -= old;
+		_sumSquares -= old * old;
+		if (_minHead != _minTail && _minQueue[_minHead % WINDOW] == expired) {
+			_minHead++;
+		}
+		if (_maxHead != _maxTail && _maxQueue[_maxHead % WINDOW] == expired) {
+			_maxHead++;
+		}
+	}
+
+	_gaps[seq % WINDOW] = gap;
+	_sum += gap;
+	_sumSquares += gap * gap;
+	_next++;
+
+	while (_minHead != _minTail && gapAt(_minQueue[(_minTail - 1) % WINDOW]) >= gap) {
+		_minTail--;
+	}
+	_minQueue[_minTail % WINDOW] = seq;
+	_minTail++;
+
+	while (_maxHead != _maxTail && gapAt(_maxQueue[(_maxTail - 1) % WINDOW]) <= gap) {
+		_maxTail--;
+	}
+	_maxQueue[_maxTail % WINDOW] = seq;
+	_maxTail++;
+}
+
+double RateStatistics::getMeanRate() const {
+	return _sum > 0 ? getSampleCount() / _sum : 0;
+}
+
+double RateStatistics::getGapStdDev() const {
+	const unsigned long count = getSampleCount();
+	if (count < 2) {
+		return 0;
+	}
+	const double mean = _sum / count;
+	const double variance = _sumSquares / count - mean * mean;
+	// Rounding in the running sums can leave a tiny negative
+	return variance > 0 ? std::sqrt(variance) : 0;
+}
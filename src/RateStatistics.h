@@ -0,0 +1,116 @@
+/** @file	RateStatistics.h
+	@brief	header for sliding-window report rate and jitter statistics
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _RATESTATISTICS_H
+#define _RATESTATISTICS_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+/// @brief Tracks the gaps between the last WINDOW report arrivals:
+/// mean rate, gap standard deviation, min/max gap, and frames dropped
+/// since reset(). Each arrival costs O(1) (amortized, for min/max) and
+/// never allocates.
+class RateStatistics {
+	public:
+		enum {
+			WINDOW = 128
+		};
+
+		RateStatistics();
+
+		void reset();
+
+		/// @brief Add a report arriving at time (seconds, monotonic clock).
+		void recordArrival(const double time);
+
+		/// @name Summary of the current window
+		/// @{
+		/// @brief Number of gaps currently in the window
+		unsigned long getSampleCount() const;
+		/// @brief Reports per second, from the mean gap
+		double getMeanRate() const;
+		/// @brief Standard deviation of the gap, in seconds
+		double getGapStdDev() const;
+		double getMinGap() const;
+		double getMaxGap() const;
+		/// @}
+
+		/// @brief Frames missed since reset(), judging by gaps at least
+		/// DROP_THRESHOLD times the mean.
+		unsigned long getDroppedFrames() const;
+
+		static const double DROP_THRESHOLD;
+
+	protected:
+		double gapAt(unsigned long seq) const;
+
+		bool _haveArrival;
+		double _lastArrival;
+
+		/// Ring buffer of gaps, indexed by sequence number % WINDOW
+		double _gaps[WINDOW];
+		/// Sequence number of the next gap
+		unsigned long _next;
+		double _sum;
+		double _sumSquares;
+
+		/// @name Monotonic deques of sequence numbers for min/max
+		/// @{
+		unsigned long _minQueue[WINDOW];
+		unsigned long _minHead;
+		unsigned long _minTail;
+		unsigned long _maxQueue[WINDOW];
+		unsigned long _maxHead;
+		unsigned long _maxTail;
+		/// @}
+
+		unsigned long _dropped;
+};
+
+// -- inline implementations -- //
+
+inline unsigned long RateStatistics::getSampleCount() const {
+	return _next < WINDOW ? _next : static_cast<unsigned long>(WINDOW);
+}
+
+inline double RateStatistics::getMinGap() const {
+	return _minHead == _minTail ? 0 : gapAt(_minQueue[_minHead % WINDOW]);
+}
+
+inline double RateStatistics::getMaxGap() const {
+	return _maxHead == _maxTail ? 0 : gapAt(_maxQueue[_maxHead % WINDOW]);
+}
+
+inline unsigned long RateStatistics::getDroppedFrames() const {
+	return _dropped;
+}
+
+inline double RateStatistics::gapAt(unsigned long seq) const {
+	return _gaps[seq % WINDOW];
+}
+
+#endif // _RATESTATISTICS_H
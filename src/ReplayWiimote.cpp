@@ -0,0 +1,188 @@
+/**	@file	ReplayWiimote.cpp
+	@brief	Implementation of replaying a recorded IR log as a Wiimote
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "ReplayWiimote.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstring>
+#include <iostream>
+
+/// Records read from the file at a time
+static const std::size_t READ_RECORDS = 4096;
+
+static inline struct timeval recordTime(const irlog::Record & r) {
+	struct timeval t;
+	t.tv_sec = r.seconds;
+	t.tv_usec = r.microseconds;
+	return t;
+}
+
+static inline double fromPixel(const vrpn_uint16 value) {
+	return (value == irlog::NO_POINT) ? -1.0 : double(value);
+}
+
+ReplayWiimote::ReplayWiimote(const char * name,
+		vrpn_Connection * c,
+		const std::string & filename,
+		const int station,
+		const double speed) :
+		vrpn_Analog(name, c),
+		_observer(NULL),
+		_station(station),
+		_speed(speed),
+		_file(filename.c_str(), std::ios::in | std::ios::binary),
+		_unread(0),
+		_buffer(READ_RECORDS),
+		_bufferUsed(0),
+		_bufferPos(0),
+		_next(NULL),
+		_valid(false),
+		_finished(true),
+		_started(false),
+		_sent(0) {
+	num_channel = CHANNEL_COUNT;
+	for (int i = 0; i < CHANNEL_COUNT; ++i) {
+		channel[i] = last[i] = -1;
+	}
+
+	irlog::Header header;
+	if (!_file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+		std::cerr << "Could not read IR log " << filename << std::endl;
+		return;
+	}
+	if (std::strncmp(header.magic, irlog::magic(), sizeof(header.magic)) != 0 ||
+			header.version != irlog::VERSION ||
+			header.recordSize != irlog::RECORD_SIZE ||
+			header.headerSize < sizeof(header)) {
+		std::cerr << filename << " is not a version " << irlog::VERSION <<
+			" IR log recorded on this kind of machine" << std::endl;
+		return;
+	}
+	_file.seekg(header.headerSize);
+	_unread = header.frames;
+	_valid = true;
+	_finished = !advance();
+	if (_finished) {
+		std::cerr << "IR log " << filename << " has no reports from station " << station << std::endl;
+	}
+}
+
+bool ReplayWiimote::advance() {
+	while (true) {
+		while (_bufferPos < _bufferUsed) {
+			const irlog::Record & r = _buffer[_bufferPos++];
+			if (r.station == _station) {
+				_next = &r;
+				return true;
+			}
+		}
+		if (_unread == 0) {
+			break;
+		}
+		const std::size_t want = (_unread < READ_RECORDS) ? std::size_t(_unread) : READ_RECORDS;
+		_file.read(reinterpret_cast<char *>(&_buffer[0]), std::streamsize(want * irlog::RECORD_SIZE));
+		_bufferUsed = std::size_t(_file.gcount()) / irlog::RECORD_SIZE;
+		_bufferPos = 0;
+		if (_bufferUsed == 0) {
+			// Shorter than its header says: a recording cut short
+			break;
+		}
+		_unread -= _bufferUsed;
+	}
+	_next = NULL;
+	return false;
+}
+
+void ReplayWiimote::mainloop() {
+	server_mainloop();
+	if (_finished) {
+		return;
+	}
+
+	struct timeval now;
+	vrpn_gettimeofday(&now, NULL);
+	if (!_started) {
+		_firstRecorded = recordTime(*_next);
+		_startedAt = now;
+		_started = true;
+	}
+	if (untilNextReport(now) > 0) {
+		return;
+	}
+
+	// One report per pass, so the tracker sees every frame on its own
+	const irlog::Record & r = *_next;
+	channel[CHANNEL_BATTERY] = r.battery;
+	for (int i = 0; i < 3; ++i) {
+		channel[CHANNEL_ACCEL + i] = r.accel[i];
+	}
+	for (int p = 0; p < IR_POINTS; ++p) {
+		for (int i = 0; i < 3; ++i) {
+			channel[CHANNEL_IR + 3 * p + i] = fromPixel(r.ir[p][i]);
+		}
+	}
+	// As fast as possible, the recorded spacing is kept but moved onto
+	// the start of the replay, which the tracker's clock began before:
+	// the recorded dates themselves would be ages out of its range.
+	const struct timeval stamp = (_speed > 0) ? now :
+		vrpn_TimevalSum(_startedAt, vrpn_TimevalDiff(recordTime(r), _firstRecorded));
+	report(vrpn_CONNECTION_LOW_LATENCY, stamp);
+	_sent++;
+
+	_finished = !advance();
+	if (_finished) {
+		std::cout << "Replay of station " << _station << " finished after " <<
+			_sent << " reports" << std::endl;
+	}
+}
+
+void ReplayWiimote::setObserver(TrackerObserver * observer) {
+	_observer = observer;
+}
+
+bool ReplayWiimote::isConnected() const {
+	return _valid;
+}
+
+double ReplayWiimote::untilNextReport(const struct timeval & now) const {
+	if (_finished) {
+		return -1;
+	}
+	if (_speed <= 0 || !_started) {
+		return 0;
+	}
+	const double recorded = vrpn_TimevalDuration(recordTime(*_next), _firstRecorded);
+	const double played = vrpn_TimevalDuration(now, _startedAt);
+	const double until = recorded / _speed - played;
+	return (until > 0) ? until : 0;
+}
+
+bool ReplayWiimote::isFinished() const {
+	return _finished;
+}
+
+vrpn_int32 ReplayWiimote::encode_to(char * buf) {
+	if (_observer) {
+		_observer->wiimoteReported(timestamp, channel, num_channel);
+	}
+	return vrpn_Analog::encode_to(buf);
+}
@@ -0,0 +1,113 @@
+/** @file	ReplayWiimote.h
+	@brief	header for a Wiimote stand-in replaying a recorded IR log
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _REPLAYWIIMOTE_H
+#define _REPLAYWIIMOTE_H
+
+// Internal Includes
+#include "IrLog.h"
+#include "TrackerObserver.h"
+#include "WiimoteSource.h"
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+#include <vrpn_Analog.h>
+
+// Standard includes
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// @brief Serves the reports one station recorded in an irlog file (see
+/// FrameRecorder) in the vrpn_WiiMote channel layout, in place of the
+/// Wiimote - to reproduce a session without the hardware.
+///
+/// Plays back at the recorded pace scaled by a speed factor, stamping
+/// reports with the time they are sent; or, with a speed of 0, one
+/// report per mainloop as fast as the loop goes, stamped with the
+/// recorded times rebased onto the start of the replay, so that every
+/// run sees the same frame spacing. Those stamps run ahead of the wall
+/// clock, which a fixed publication rate and prediction still follow:
+/// only adaptive publication reproduces the same poses each run.
+class ReplayWiimote : public vrpn_Analog, public WiimoteSource {
+	public:
+		/// @param speed Multiple of the recorded pace, or 0 for as fast
+		/// as possible
+		ReplayWiimote(const char * name,
+			vrpn_Connection * c,
+			const std::string & filename,
+			const int station,
+			const double speed = 1.0);
+
+		/// @name WiimoteSource interface
+		/// @{
+		virtual void mainloop();
+		virtual void setObserver(TrackerObserver * observer);
+		/// @brief Whether the log could be opened and read
+		virtual bool isConnected() const;
+		virtual double untilNextReport(const struct timeval & now) const;
+		virtual bool isFinished() const;
+		/// @}
+
+		unsigned long getReportsSent() const;
+
+	protected:
+		/// @brief Move _next to this station's next record, reading more
+		/// of the file as needed. @returns false at the end of the log.
+		bool advance();
+
+		/// @brief Called by vrpn_Analog for every analog report it sends.
+		virtual vrpn_int32 encode_to(char * buf);
+
+		TrackerObserver * _observer;
+		const int _station;
+		const double _speed;
+
+		/// @name Log reading
+		/// @{
+		std::ifstream _file;
+		/// Records in the file not yet read into _buffer
+		unsigned long _unread;
+		std::vector<irlog::Record> _buffer;
+		std::size_t _bufferUsed;
+		std::size_t _bufferPos;
+		/// This station's next record, if not _finished
+		const irlog::Record * _next;
+		bool _valid;
+		bool _finished;
+		/// @}
+
+		/// @name Replay clock
+		/// @{
+		bool _started;
+		struct timeval _firstRecorded;
+		struct timeval _startedAt;
+		/// @}
+
+		unsigned long _sent;
+};
+
+// -- inline implementations -- //
+
+inline unsigned long ReplayWiimote::getReportsSent() const {
+	return _sent;
+}
+
+#endif // _REPLAYWIIMOTE_H
@@ -0,0 +1,107 @@
+/** @file	ReportText.h
+	@brief	header for formatting tracker reports into fixed-size buffers
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _REPORTTEXT_H
+#define _REPORTTEXT_H
+
+// Internal Includes
+#include "TrackingSystem.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstdio>
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#	define REPORT_SNPRINTF _snprintf
+#else
+#	define REPORT_SNPRINTF snprintf
+#endif
+
+/// @brief Display strings for a TrackerReport, formatted without touching
+/// the heap - only call format() when the text is actually about to be shown.
+struct ReportText {
+	enum {
+		LENGTH = 64,
+		SUMMARY_LENGTH = 128
+	};
+
+	char rate[LENGTH];
+	char gaps[LENGTH];
+	char poseAge[LENGTH];
+	char pos[LENGTH];
+	char rot[LENGTH];
+	char battery[LENGTH];
+	/// One line for a list of stations
+	char summary[SUMMARY_LENGTH];
+
+	ReportText() {
+		rate[0] = gaps[0] = poseAge[0] = pos[0] = rot[0] = battery[0] = '\0';
+		summary[0] = '\0';
+	}
+
+	void format(const TrackerReport & r, const char * noPoseMessage) {
+		if (r.hasPose) {
+			REPORT_SNPRINTF(rate, LENGTH, "%.1f Hz (gap std. dev. %.2f ms)",
+				r.rate, r.gapStdDev * 1000.0);
+			REPORT_SNPRINTF(gaps, LENGTH, "%.2f / %.2f ms, %lu dropped",
+				r.minGap * 1000.0, r.maxGap * 1000.0, r.droppedFrames);
+			REPORT_SNPRINTF(poseAge, LENGTH, "%.1f ms since IR frame, %.0f%% confidence",
+				r.poseAge * 1000.0, r.confidence * 100.0);
+			REPORT_SNPRINTF(pos, LENGTH, "(%.4f, %.4f, %.4f)",
+				r.pos[0], r.pos[1], r.pos[2]);
+			REPORT_SNPRINTF(rot, LENGTH, "(%.3f, %.3f, %.3f, %.3f)",
+				r.quat[0], r.quat[1], r.quat[2], r.quat[3]);
+		} else {
+			REPORT_SNPRINTF(rate, LENGTH, " ");
+			REPORT_SNPRINTF(gaps, LENGTH, " ");
+			REPORT_SNPRINTF(poseAge, LENGTH, " ");
+			REPORT_SNPRINTF(pos, LENGTH, "%s", noPoseMessage);
+			REPORT_SNPRINTF(rot, LENGTH, "%s", noPoseMessage);
+		}
+		rate[LENGTH - 1] = gaps[LENGTH - 1] = poseAge[LENGTH - 1] = '\0';
+		pos[LENGTH - 1] = rot[LENGTH - 1] = '\0';
+
+		if (r.battery >= 0) {
+			REPORT_SNPRINTF(battery, LENGTH, "%.1f%%", r.battery * 100.0);
+		} else {
+			REPORT_SNPRINTF(battery, LENGTH, " ");
+		}
+		battery[LENGTH - 1] = '\0';
+	}
+
+	void formatSummary(const TrackerReport & r, const char * trackerName) {
+		if (!r.wiimoteConnected) {
+			REPORT_SNPRINTF(summary, SUMMARY_LENGTH, "%s\tNo Wiimote", trackerName);
+		} else if (!r.hasPose) {
+			REPORT_SNPRINTF(summary, SUMMARY_LENGTH, "%s\tNo pose yet", trackerName);
+		} else if (r.battery >= 0) {
+			REPORT_SNPRINTF(summary, SUMMARY_LENGTH, "%s\t%.1f Hz\t%lu dropped\t%.0f%% battery",
+				trackerName, r.rate, r.droppedFrames, r.battery * 100.0);
+		} else {
+			REPORT_SNPRINTF(summary, SUMMARY_LENGTH, "%s\t%.1f Hz\t%lu dropped",
+				trackerName, r.rate, r.droppedFrames);
+		}
+		summary[SUMMARY_LENGTH - 1] = '\0';
+	}
+};
+
+#endif // _REPORTTEXT_H
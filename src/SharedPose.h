@@ -0,0 +1,192 @@
+/** @file	SharedPose.h
+	@brief	header for the layout of the shared-memory pose segment
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _SHAREDPOSE_H
+#define _SHAREDPOSE_H
+
+// Internal Includes
+#include "AtomicOps.h"
+#include "QuaternionMath.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <string>
+
+/// @brief Layout of the shared-memory segment a tracker publishes its
+/// poses into for clients on the same host, and the seqlock protocol
+/// guarding it. Header-only, needing nothing but AtomicOps.h and
+/// QuaternionMath.h, so clients can include it (with SharedPoseReader.h)
+/// without linking anything.
+///
+/// One writer: it makes sequence odd, writes the next history slot and
+/// advances published, then makes sequence even again. A reader copies
+/// what it wants between two reads of sequence, and retries unless both
+/// saw the same even value - up to MAX_READ_ATTEMPTS times, after which
+/// it gives up and reports no pose, so a writer that died mid-write
+/// can't hang its readers.
+namespace sharedpose {
+	enum {
+		VERSION = 1,
+		/// Poses kept, newest last
+		HISTORY = 32,
+		/// Tries at a consistent copy before a read gives up: far more
+		/// than a live writer, taking well under a microsecond per pose,
+		/// ever costs
+		MAX_READ_ATTEMPTS = 100000
+	};
+
+	struct Pose {
+		/// VRPN report time: seconds and microseconds since the epoch
+		double time;
+		/// Meters, in the tracker's frame
+		double pos[3];
+		/// (x, y, z, w), as VRPN sends them
+		double quat[4];
+		/// 0 to 1, as on the tracker's confidence analog
+		double confidence;
+	};
+
+	struct Segment {
+		/// "WIIHTSHM" without a NUL; written last, once the rest is valid
+		char magic[8];
+		unsigned int version;
+		unsigned int history;
+		/// Seqlock count: odd while the writer is in the middle of a pose
+		volatile unsigned int sequence;
+		/// Poses published so far; the newest is in
+		/// poses[(published - 1) % HISTORY]
+		volatile unsigned int published;
+		Pose poses[HISTORY];
+	};
+
+	inline const char * magic() {
+		return "WIIHTSHM";
+	}
+
+	/// @brief Name of the segment serving trackerName, as shm_open() or
+	/// OpenFileMapping() takes it
+	inline std::string segmentName(const std::string & trackerName) {
+#ifdef _WIN32
+		return "Local\\wiimoteheadtracker." + trackerName;
+#else
+		return "/wiimoteheadtracker." + trackerName;
+#endif
+	}
+
+/// @addtogroup FreeFunctions Free Functions
+/// @{
+
+	/// @brief Append a pose to the history (the one writer only).
+	inline void write(Segment & segment, const Pose & pose) {
+		const unsigned int sequence = segment.sequence;
+		segment.sequence = sequence + 1;
+		atomic::barrier();
+		const unsigned int published = segment.published;
+		segment.poses[published % HISTORY] = pose;
+		segment.published = published + 1;
+		atomic::barrier();
+		segment.sequence = sequence + 2;
+	}
+
+	/// @brief Copy out up to max of the newest poses, oldest first.
+	/// @returns how many were copied - 0 if none have been published, or
+	/// the writer is stuck mid-write.
+	inline unsigned int read(const Segment & segment, Pose poses[], const unsigned int max) {
+		for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+			const unsigned int before = segment.sequence;
+			atomic::barrier();
+			if (before & 1) {
+				// Mid-write: it takes well under a microsecond
+				continue;
+			}
+			const unsigned int published = segment.published;
+			unsigned int count = published < max ? published : max;
+			if (count > HISTORY) {
+				count = HISTORY;
+			}
+			for (unsigned int i = 0; i < count; ++i) {
+				poses[i] = segment.poses[(published - count + i) % HISTORY];
+			}
+			atomic::barrier();
+			if (segment.sequence == before) {
+				return count;
+			}
+		}
+		return 0;
+	}
+
+	/// @brief The pose at time (seconds since the epoch), interpolated
+	/// between the published poses either side of it - position and
+	/// confidence linearly, orientation by slerp - as PoseHistory does.
+	/// @returns false if time is outside the history held, or the writer
+	/// is stuck mid-write.
+	inline bool poseAt(const Segment & segment, const double time, Pose & pose) {
+		for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+			const unsigned int before = segment.sequence;
+			atomic::barrier();
+			if (before & 1) {
+				continue;
+			}
+			const unsigned int published = segment.published;
+			const unsigned int held = published < HISTORY ? published : (unsigned int)(HISTORY);
+			bool found = false;
+			if (held > 0 && time >= segment.poses[(published - held) % HISTORY].time &&
+					time <= segment.poses[(published - 1) % HISTORY].time) {
+				// Binary search for the last pose at or before time
+				unsigned int first = published - held;
+				unsigned int last = published - 1;
+				while (first < last) {
+					const unsigned int mid = first + (last - first + 1) / 2;
+					if (segment.poses[mid % HISTORY].time <= time) {
+						first = mid;
+					} else {
+						last = mid - 1;
+					}
+				}
+				const Pose & a = segment.poses[first % HISTORY];
+				if (a.time == time || first == published - 1) {
+					pose = a;
+				} else {
+					const Pose & b = segment.poses[(first + 1) % HISTORY];
+					const double t = (time - a.time) / (b.time - a.time);
+					for (int i = 0; i < 3; ++i) {
+						pose.pos[i] = a.pos[i] + t * (b.pos[i] - a.pos[i]);
+					}
+					quatmath::slerp(pose.quat, a.quat, b.quat, t);
+					pose.confidence = a.confidence + t * (b.confidence - a.confidence);
+				}
+				pose.time = time;
+				found = true;
+			}
+			atomic::barrier();
+			if (segment.sequence == before) {
+				return found;
+			}
+		}
+		return false;
+	}
+
+/// @}
+
+} // end of sharedpose namespace
+
+#endif // _SHAREDPOSE_H
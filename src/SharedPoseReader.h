@@ -0,0 +1,180 @@
+/** @file	SharedPoseReader.h
+	@brief	header-only client for poses published in shared memory
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _SHAREDPOSEREADER_H
+#define _SHAREDPOSEREADER_H
+
+// Internal Includes
+#include "SharedPose.h"
+
+// Library/third-party includes
+#ifdef _WIN32
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#else
+#	include <sys/types.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+// Standard includes
+#include <cstring>
+#include <string>
+
+/// @brief Reads the poses a tracker on this host publishes in shared
+/// memory - a client's alternative to a vrpn_Tracker_Remote.
+///
+/// Opening maps the segment; after that, reading is a few loads and a
+/// copy, with no system call, so a new pose is visible as soon as the
+/// tracker has written it. Poll latest() as often as the application
+/// wants a pose:
+/// @code
+/// SharedPoseReader reader;
+/// if (reader.open("Tracker0")) {
+/// 	sharedpose::Pose pose;
+/// 	if (reader.latest(pose)) { ... }
+/// }
+/// @endcode
+/// Link with -lrt on older Linux systems, for shm_open().
+class SharedPoseReader {
+	public:
+		SharedPoseReader() :
+				_segment(NULL)
+#ifdef _WIN32
+				, _mapping(NULL)
+#endif
+				{}
+
+		~SharedPoseReader() {
+			close();
+		}
+
+		/// @brief Map the segment of the tracker named trackerName.
+		/// @returns false if it isn't serving shared memory (yet).
+		bool open(const std::string & trackerName) {
+			close();
+			const std::string name = sharedpose::segmentName(trackerName);
+			void * view = NULL;
+#ifdef _WIN32
+			_mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+			if (!_mapping) {
+				return false;
+			}
+			view = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, sizeof(sharedpose::Segment));
+			if (!view) {
+				close();
+				return false;
+			}
+#else
+			const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+			if (fd < 0) {
+				return false;
+			}
+			struct stat info;
+			if (fstat(fd, &info) != 0 || info.st_size < off_t(sizeof(sharedpose::Segment))) {
+				// Still being created
+				::close(fd);
+				return false;
+			}
+			view = mmap(NULL, sizeof(sharedpose::Segment), PROT_READ, MAP_SHARED, fd, 0);
+			::close(fd);
+			if (view == MAP_FAILED) {
+				return false;
+			}
+#endif
+			_segment = static_cast<const sharedpose::Segment *>(view);
+			atomic::barrier();
+			if (std::memcmp(_segment->magic, sharedpose::magic(), sizeof(_segment->magic)) != 0 ||
+					_segment->version != sharedpose::VERSION ||
+					_segment->history != sharedpose::HISTORY) {
+				close();
+				return false;
+			}
+			return true;
+		}
+
+		void close() {
+			if (_segment) {
+#ifdef _WIN32
+				UnmapViewOfFile(_segment);
+#else
+				munmap(const_cast<sharedpose::Segment *>(_segment), sizeof(sharedpose::Segment));
+#endif
+				_segment = NULL;
+			}
+#ifdef _WIN32
+			if (_mapping) {
+				CloseHandle(_mapping);
+				_mapping = NULL;
+			}
+#endif
+		}
+
+		bool isOpen() const {
+			return _segment != NULL;
+		}
+
+		/// @brief Copy out the newest pose.
+		/// @returns false if none has been published, or the tracker
+		/// died while writing one - see isStalled().
+		bool latest(sharedpose::Pose & pose) const {
+			return _segment && sharedpose::read(*_segment, &pose, 1) == 1;
+		}
+
+		/// @brief Copy out up to max of the newest poses (at most
+		/// sharedpose::HISTORY), oldest first.
+		/// @returns how many were copied.
+		unsigned int history(sharedpose::Pose poses[], const unsigned int max) const {
+			return _segment ? sharedpose::read(*_segment, poses, max) : 0;
+		}
+
+		/// @brief The pose at time, in seconds since the epoch (e.g. the
+		/// display's predicted scan-out), interpolated from the history.
+		/// @returns false if time is outside the history held: before
+		/// the oldest pose, or after the newest.
+		bool poseAt(const double time, sharedpose::Pose & pose) const {
+			return _segment && sharedpose::poseAt(*_segment, time, pose);
+		}
+
+		/// @brief Poses published so far - changes when there is a new one.
+		unsigned int published() const {
+			return _segment ? _segment->published : 0;
+		}
+
+		/// @brief Whether the tracker is in the middle of writing a pose.
+		/// A live one is for well under a microsecond at a time; one that
+		/// stays so across reads that fail has died mid-write, and the
+		/// segment should be closed and opened again once it restarts.
+		bool isStalled() const {
+			return _segment && (_segment->sequence & 1);
+		}
+
+	protected:
+		const sharedpose::Segment * _segment;
+#ifdef _WIN32
+		HANDLE _mapping;
+#endif
+};
+
+#endif // _SHAREDPOSEREADER_H
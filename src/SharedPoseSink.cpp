@@ -0,0 +1,137 @@
+/**	@file	SharedPoseSink.cpp
+	@brief	Implementation of publishing poses in shared memory
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "SharedPoseSink.h"
+
+// Library/third-party includes
+#ifdef _WIN32
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#else
+#	include <sys/types.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+// Standard includes
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+SharedPoseSink::SharedPoseSink() :
+		_segment(NULL)
+#ifdef _WIN32
+		, _mapping(NULL)
+#endif
+		{}
+
+SharedPoseSink::~SharedPoseSink() {
+	close();
+}
+
+bool SharedPoseSink::open(const std::string & trackerName) {
+	close();
+	const std::string name = sharedpose::segmentName(trackerName);
+	void * view = NULL;
+#ifdef _WIN32
+	_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+		0, sizeof(sharedpose::Segment), name.c_str());
+	if (!_mapping) {
+		std::cerr << "Could not create shared memory " << name << std::endl;
+		return false;
+	}
+	view = MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, sizeof(sharedpose::Segment));
+	if (!view) {
+		std::cerr << "Could not map shared memory " << name << std::endl;
+		CloseHandle(_mapping);
+		_mapping = NULL;
+		return false;
+	}
+#else
+	// Readers may be holding a segment left by a tracker that crashed:
+	// start a new one, which they pick up when they reopen
+	shm_unlink(name.c_str());
+	const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0) {
+		std::cerr << "Could not create shared memory " << name << std::endl;
+		return false;
+	}
+	if (ftruncate(fd, sizeof(sharedpose::Segment)) != 0) {
+		std::cerr << "Could not size shared memory " << name << std::endl;
+		::close(fd);
+		shm_unlink(name.c_str());
+		return false;
+	}
+	view = mmap(NULL, sizeof(sharedpose::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED) {
+		std::cerr << "Could not map shared memory " << name << std::endl;
+		shm_unlink(name.c_str());
+		return false;
+	}
+#endif
+	_segment = static_cast<sharedpose::Segment *>(view);
+	std::memset(_segment, 0, sizeof(sharedpose::Segment));
+	_segment->version = sharedpose::VERSION;
+	_segment->history = sharedpose::HISTORY;
+	// Readers check the magic: it goes in once the rest is valid
+	atomic::barrier();
+	std::memcpy(_segment->magic, sharedpose::magic(), sizeof(_segment->magic));
+	_trackerName = trackerName;
+	_name = name;
+	return true;
+}
+
+void SharedPoseSink::close() {
+	if (!_segment) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(_segment);
+	CloseHandle(_mapping);
+	_mapping = NULL;
+#else
+	munmap(_segment, sizeof(sharedpose::Segment));
+	shm_unlink(_name.c_str());
+#endif
+	_segment = NULL;
+	_trackerName.clear();
+	_name.clear();
+}
+
+void SharedPoseSink::publish(const struct timeval & time, const double pos[3],
+		const double quat[4], const double confidence) {
+	if (!_segment) {
+		return;
+	}
+	sharedpose::Pose pose;
+	pose.time = time.tv_sec + time.tv_usec / 1000000.0;
+	for (int i = 0; i < 3; ++i) {
+		pose.pos[i] = pos[i];
+	}
+	for (int i = 0; i < 4; ++i) {
+		pose.quat[i] = quat[i];
+	}
+	pose.confidence = confidence;
+	sharedpose::write(*_segment, pose);
+}
@@ -0,0 +1,73 @@
+/** @file	SharedPoseSink.h
+	@brief	header for publishing poses in shared memory
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _SHAREDPOSESINK_H
+#define _SHAREDPOSESINK_H
+
+// Internal Includes
+#include "SharedPose.h"
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+
+// Standard includes
+#include <string>
+
+/// @brief Writes each pose a tracker publishes into a shared-memory
+/// segment named for the tracker, for SharedPoseReader clients on the
+/// same host - alongside, not instead of, its VRPN output.
+///
+/// The segment is created (or taken over from a tracker that didn't shut
+/// down cleanly) by open() and removed by close(); publishing is a
+/// seqlock-guarded copy, with no system call.
+class SharedPoseSink {
+	public:
+		SharedPoseSink();
+		~SharedPoseSink();
+
+		/// @brief Create the segment for trackerName, closing any other.
+		bool open(const std::string & trackerName);
+		void close();
+		bool isOpen() const;
+		const std::string & getTrackerName() const;
+
+		void publish(const struct timeval & time, const double pos[3],
+			const double quat[4], const double confidence);
+
+	protected:
+		std::string _trackerName;
+		std::string _name;
+		sharedpose::Segment * _segment;
+#ifdef _WIN32
+		void * _mapping;
+#endif
+};
+
+// -- inline implementations -- //
+
+inline bool SharedPoseSink::isOpen() const {
+	return _segment != NULL;
+}
+
+inline const std::string & SharedPoseSink::getTrackerName() const {
+	return _trackerName;
+}
+
+#endif // _SHAREDPOSESINK_H
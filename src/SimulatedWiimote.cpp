@@ -0,0 +1,179 @@
+/**	@file	SimulatedWiimote.cpp
+	@brief	Implementation of a stand-in Wiimote generating IR points from a simulated head
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "SimulatedWiimote.h"
+#include "IrCamera.h"
+#include "QuaternionMath.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstddef>
+#include <cmath>
+
+static const double BLOB_SIZE = 3.0;
+
+static const double TWO_PI = 2.0 * 3.14159265358979323846;
+
+static double clampFrameRate(const float rate) {
+	if (rate <= 0) {
+		return SimulationParameters().frameRate;
+	}
+	return (rate > SimulationParameters::MAX_FRAME_RATE) ? double(SimulationParameters::MAX_FRAME_RATE) : rate;
+}
+
+SimulatedWiimote::SimulatedWiimote(const char * name,
+		vrpn_Connection * c,
+		const LedConstellation & leds,
+		const SimulationParameters & params,
+		double phase) :
+		vrpn_Analog(name, c),
+		_observer(NULL),
+		_leds(leds),
+		_period(1.0 / clampFrameRate(params.frameRate)),
+		_noise(params.noise > 0 ? params.noise : 0),
+		_dropout(params.dropout > 0 ? params.dropout : 0),
+		_trajectory(phase),
+		// Any fixed function of the phase will do - it differs per station
+		_seed(12345UL + (unsigned long)(phase * 1000.0)) {
+	num_channel = CHANNEL_COUNT;
+	for (int i = 0; i < CHANNEL_COUNT; ++i) {
+		channel[i] = last[i] = -1;
+	}
+	if (!params.trajectoryFile.empty()) {
+		_trajectory.load(params.trajectoryFile);
+	}
+	vrpn_gettimeofday(&_start, NULL);
+	_nextFrame = _start;
+}
+
+void SimulatedWiimote::mainloop() {
+	server_mainloop();
+
+	struct timeval now;
+	vrpn_gettimeofday(&now, NULL);
+	if (vrpn_TimevalDuration(now, _nextFrame) < 0) {
+		return;
+	}
+	generate(vrpn_TimevalDuration(now, _start));
+	report(vrpn_CONNECTION_LOW_LATENCY, now);
+
+	// Keep the frame clock steady, but don't burst to catch up a stall
+	_nextFrame = vrpn_TimevalSum(_nextFrame, vrpn_MsecsTimeval(_period * 1000.0));
+	if (vrpn_TimevalDuration(now, _nextFrame) > 0) {
+		_nextFrame = vrpn_TimevalSum(now, vrpn_MsecsTimeval(_period * 1000.0));
+	}
+}
+
+void SimulatedWiimote::setObserver(TrackerObserver * observer) {
+	_observer = observer;
+}
+
+bool SimulatedWiimote::isConnected() const {
+	return true;
+}
+
+double SimulatedWiimote::untilNextReport(const struct timeval & now) const {
+	const double until = vrpn_TimevalDuration(_nextFrame, now);
+	return (until > 0) ? until : 0;
+}
+
+double SimulatedWiimote::uniform() {
+	// 32-bit linear congruential generator; (0, 1]
+	_seed = (_seed * 1664525UL + 1013904223UL) & 0xFFFFFFFFUL;
+	return (double(_seed) + 1.0) / 4294967296.0;
+}
+
+double SimulatedWiimote::gaussian() {
+	// Box-Muller: one of the pair is plenty at these rates
+	const double r = std::sqrt(-2.0 * std::log(uniform()));
+	return r * std::cos(TWO_PI * uniform());
+}
+
+void SimulatedWiimote::generate(const double t) {
+	double head[3];
+	double yaw;
+	double roll;
+	unsigned int hidden;
+	_trajectory.sample(t, head, yaw, roll, hidden);
+
+	// Roll about the camera axis, then yaw about the vertical
+	const double yawVector[3] = {0, -yaw, 0};
+	const double rollVector[3] = {0, 0, roll};
+	double turn[4];
+	double rolled[4];
+	quatmath::fromRotationVector(turn, yawVector);
+	quatmath::fromRotationVector(rolled, rollVector);
+	quatmath::multiply(turn, turn, rolled);
+
+	channel[CHANNEL_BATTERY] = 1.0;
+	// Resting flat: gravity straight down the z axis
+	channel[CHANNEL_ACCEL] = 0;
+	channel[CHANNEL_ACCEL + 1] = 0;
+	channel[CHANNEL_ACCEL + 2] = 1.0;
+
+	// The camera reports points in the order it finds them, so a lost
+	// one leaves no gap
+	int seen = 0;
+	for (int led = 0; led < _leds.count && seen < IR_POINTS; ++led) {
+		if (_dropout > 0 && uniform() <= _dropout) {
+			continue;
+		}
+		if (hidden & (1u << led)) {
+			continue;
+		}
+		double p[3];
+		quatmath::rotate(p, turn, _leds.leds[led]);
+		for (int i = 0; i < 3; ++i) {
+			p[i] += head[i];
+		}
+		if (p[2] <= 0) {
+			continue;
+		}
+		double u;
+		double v;
+		ircamera::project(p, u, v);
+		if (_noise > 0) {
+			u += _noise * gaussian();
+			v += _noise * gaussian();
+		}
+		// Whole pixels, and nothing outside the sensor
+		u = std::floor(u + 0.5);
+		v = std::floor(v + 0.5);
+		if (u < 0 || u >= ircamera::SENSOR_WIDTH || v < 0 || v >= ircamera::SENSOR_HEIGHT) {
+			continue;
+		}
+		vrpn_float64 * blob = channel + CHANNEL_IR + 3 * seen;
+		blob[0] = u;
+		blob[1] = v;
+		blob[2] = BLOB_SIZE;
+		seen++;
+	}
+	for (int i = CHANNEL_IR + 3 * seen; i < CHANNEL_COUNT; ++i) {
+		channel[i] = -1;
+	}
+}
+
+vrpn_int32 SimulatedWiimote::encode_to(char * buf) {
+	if (_observer) {
+		_observer->wiimoteReported(timestamp, channel, num_channel);
+	}
+	return vrpn_Analog::encode_to(buf);
+}
@@ -0,0 +1,108 @@
+/** @file	SimulatedWiimote.h
+	@brief	header for a stand-in Wiimote generating IR points from a simulated head
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _SIMULATEDWIIMOTE_H
+#define _SIMULATEDWIIMOTE_H
+
+// Internal Includes
+#include "HeadTrajectory.h"
+#include "LedConstellation.h"
+#include "TrackerObserver.h"
+#include "WiimoteSource.h"
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+#include <vrpn_Analog.h>
+
+// Standard includes
+#include <string>
+
+/// @brief How simulated Wiimotes behave, beyond the LEDs they see
+struct SimulationParameters {
+	enum {
+		/// Highest frame rate accepted, in Hz
+		MAX_FRAME_RATE = 1000
+	};
+
+	SimulationParameters() :
+			frameRate(100),
+			noise(0),
+			dropout(0),
+			trajectoryFile() {}
+
+	/// IR frames per second, up to MAX_FRAME_RATE
+	float frameRate;
+	/// Standard deviation of the camera's blob position error, in pixels
+	float noise;
+	/// Chance of each LED going unseen in a frame, 0 to 1
+	float dropout;
+	/// Keyframe script for HeadTrajectory, or empty for the built-in sway
+	std::string trajectoryFile;
+};
+
+/// @brief Serves the vrpn_WiiMote channel layout with the IR points a
+/// camera would see of head-mounted LEDs moving in front of it -
+/// so a pipeline can run with no Wiimote or Bluetooth adapter.
+///
+/// Each instance is given a different phase and noise seed, so several
+/// in one process report distinguishable poses, and a run is the same
+/// every time.
+class SimulatedWiimote : public vrpn_Analog, public WiimoteSource {
+	public:
+		SimulatedWiimote(const char * name,
+			vrpn_Connection * c,
+			const LedConstellation & leds,
+			const SimulationParameters & params = SimulationParameters(),
+			double phase = 0);
+
+		/// @name WiimoteSource interface
+		/// @{
+		virtual void mainloop();
+		virtual void setObserver(TrackerObserver * observer);
+		virtual bool isConnected() const;
+		virtual double untilNextReport(const struct timeval & now) const;
+		/// @}
+
+	protected:
+		/// @brief Fill in the channels for the head pose at time t (seconds)
+		void generate(const double t);
+
+		/// @name Camera noise: a small generator of our own, so runs
+		/// repeat and stations don't share state
+		/// @{
+		double uniform();
+		double gaussian();
+		/// @}
+
+		/// @brief Called by vrpn_Analog for every analog report it sends.
+		virtual vrpn_int32 encode_to(char * buf);
+
+		TrackerObserver * _observer;
+		const LedConstellation _leds;
+		const double _period;
+		const double _noise;
+		const double _dropout;
+		HeadTrajectory _trajectory;
+		unsigned long _seed;
+		struct timeval _start;
+		struct timeval _nextFrame;
+};
+
+#endif // _SIMULATEDWIIMOTE_H
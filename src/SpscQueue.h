@@ -0,0 +1,74 @@
+/** @file	SpscQueue.h
+	@brief	header for a bounded lock-free single-producer/single-consumer queue
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _SPSCQUEUE_H
+#define _SPSCQUEUE_H
+
+// Internal Includes
+#include "AtomicOps.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+/// @brief Fixed-capacity FIFO between exactly one producer thread and
+/// exactly one consumer thread. Neither push() nor pop() ever blocks.
+///
+/// CAPACITY must be a power of two.
+template<class T, unsigned long CAPACITY>
+class SpscQueue {
+	public:
+		SpscQueue() :
+				_head(0),
+				_tail(0) {}
+
+		/// @brief Producer side.
+		/// @returns false (and drops the value) if the queue is full
+		bool push(const T & value) {
+			const long tail = _tail;
+			if (static_cast<unsigned long>(tail - atomic::load(&_head)) >= CAPACITY) {
+				return false;
+			}
+			_slots[tail & (CAPACITY - 1)] = value;
+			atomic::store(&_tail, tail + 1);
+			return true;
+		}
+
+		/// @brief Consumer side.
+		/// @returns false if there was nothing to pop
+		bool pop(T & value) {
+			const long head = _head;
+			if (head == atomic::load(&_tail)) {
+				return false;
+			}
+			value = _slots[head & (CAPACITY - 1)];
+			atomic::store(&_head, head + 1);
+			return true;
+		}
+
+	protected:
+		T _slots[CAPACITY];
+		volatile long _head;
+		volatile long _tail;
+};
+
+#endif // _SPSCQUEUE_H
@@ -0,0 +1,110 @@
+/**	@file	StageMetrics.cpp
+	@brief	Implementation of writing per-stage latency metrics
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "StageMetrics.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+ClientDelivery::ClientDelivery() :
+		connected(false),
+		queueDepth(0),
+		delivered(0),
+		superseded(0) {
+}
+
+void ClientDelivery::reset() {
+	connected = false;
+	queueDepth = 0;
+	delivered = 0;
+	superseded = 0;
+	sendLatency.reset();
+}
+
+namespace metrics {
+
+	const char * stageName(const MetricStage stage) {
+		switch (stage) {
+			case STAGE_WIIMOTE:	return "wiimote";
+			case STAGE_SOLVE:	return "solve";
+			case STAGE_ENCODE:	return "encode";
+			case STAGE_SEND:	return "send";
+			case STAGE_GUI:		return "gui";
+			case STAGE_DISPLAY:	return "display";
+			case STAGE_COUNT:	break;
+		}
+		return "unknown";
+	}
+
+	bool writeFile(const std::string & filename, const StageMetrics & m) {
+		const std::string temp = filename + ".tmp";
+		{
+			std::ofstream out(temp.c_str());
+			if (!out.is_open()) {
+				return false;
+			}
+			out << "# Wii Remote head tracker stage latencies, in seconds," << std::endl <<
+				"# cumulative over " << std::fixed << std::setprecision(0) << m.uptime << " s" << std::endl <<
+				"# stage count mean p50 p90 p99 p99.9 max" << std::endl;
+			out << std::scientific << std::setprecision(3);
+			for (int s = 0; s < STAGE_COUNT; ++s) {
+				const LatencyHistogram & h = m.stages[s];
+				out << stageName(MetricStage(s)) << " " << h.getCount() << " " <<
+					h.getMean() << " " << h.getPercentile(0.5) << " " <<
+					h.getPercentile(0.9) << " " << h.getPercentile(0.99) << " " <<
+					h.getPercentile(0.999) << " " << h.getMax() << std::endl;
+			}
+			out << "# stage bucket-upper-bound count, for non-empty buckets" << std::endl;
+			for (int s = 0; s < STAGE_COUNT; ++s) {
+				const LatencyHistogram & h = m.stages[s];
+				for (int b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+					if (h.getBucketCount(b)) {
+						out << stageName(MetricStage(s)) << "_bucket " <<
+							LatencyHistogram::getBucketUpperBound(b) << " " <<
+							h.getBucketCount(b) << std::endl;
+					}
+				}
+			}
+			out << "# client slot queued-bytes messages superseded send-p50 send-p99 send-max" << std::endl;
+			for (int c = 0; c < StageMetrics::CLIENTS; ++c) {
+				const ClientDelivery & d = m.clients[c];
+				if (!d.connected) {
+					continue;
+				}
+				out << "client " << c << " " << d.queueDepth << " " << d.delivered << " " <<
+					d.superseded << " " << d.sendLatency.getPercentile(0.5) << " " <<
+					d.sendLatency.getPercentile(0.99) << " " << d.sendLatency.getMax() << std::endl;
+			}
+			if (!out.good()) {
+				return false;
+			}
+		}
+#ifdef _WIN32
+		// rename() won't replace an existing file here
+		std::remove(filename.c_str());
+#endif
+		return std::rename(temp.c_str(), filename.c_str()) == 0;
+	}
+
+} // end of metrics namespace
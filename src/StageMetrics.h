@@ -0,0 +1,105 @@
+/** @file	StageMetrics.h
+	@brief	header for per-stage latency histograms of the tracking path
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _STAGEMETRICS_H
+#define _STAGEMETRICS_H
+
+// Internal Includes
+#include "LatencyHistogram.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <string>
+
+/// @brief Steps on the way from a Wiimote report to a displayed pose
+enum MetricStage {
+	/// Servicing the Wiimote device, for passes that brought a report
+	STAGE_WIIMOTE,
+	/// From a report's arrival to its pose being published
+	STAGE_SOLVE,
+	/// Post-processing and packing a published pose
+	STAGE_ENCODE,
+	/// Servicing the connection, for passes with poses to send
+	STAGE_SEND,
+	/// From a report being handed to the front end to it being shown
+	STAGE_GUI,
+	/// Age at each display deadline of the newest frame behind the pose
+	/// sent for it, when synced to a display
+	STAGE_DISPLAY,
+	STAGE_COUNT
+};
+
+/// @brief How messages are getting to one client of the server
+/// connection, since it connected.
+struct ClientDelivery {
+	ClientDelivery();
+
+	void reset();
+
+	bool connected;
+	/// Bytes handed to its socket that the client hasn't taken yet, as
+	/// of the last pass
+	unsigned long queueDepth;
+	/// Messages packed for it
+	unsigned long delivered;
+	/// Reports replaced by a newer one before they could be sent
+	unsigned long superseded;
+	/// For each send: how long its oldest message waited, from being
+	/// packed (or held back) to being handed to the socket
+	LatencyHistogram sendLatency;
+};
+
+/// @brief A histogram per stage, cumulative since the tracking system was
+/// created - all stations together - and the delivery to each client.
+struct StageMetrics {
+	enum {
+		/// Clients accounted for, by connection slot
+		CLIENTS = 8
+	};
+
+	StageMetrics() :
+			uptime(0) {}
+
+	LatencyHistogram stages[STAGE_COUNT];
+	ClientDelivery clients[CLIENTS];
+	/// Seconds covered
+	double uptime;
+};
+
+namespace metrics {
+
+/// @addtogroup FreeFunctions Free Functions
+/// @{
+
+	/// @brief Short lower-case name of a stage, as used in metrics files
+	const char * stageName(const MetricStage stage);
+
+	/// @brief Replace filename with a text summary of m, for a monitoring
+	/// agent to pick up: written beside it, then renamed over it, so a
+	/// reader never sees half a file.
+	bool writeFile(const std::string & filename, const StageMetrics & m);
+
+/// @}
+
+} // end of metrics namespace
+
+#endif // _STAGEMETRICS_H
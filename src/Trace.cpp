@@ -0,0 +1,207 @@
+/**	@file	Trace.cpp
+	@brief	Implementation of opt-in event tracing to Chrome trace JSON
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "Trace.h"
+#include "AtomicOps.h"
+#include "MonotonicClock.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#if defined(_MSC_VER)
+#	define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#	define TRACE_THREAD_LOCAL __thread
+#endif
+
+namespace trace {
+	bool g_enabled = false;
+
+	namespace {
+		struct Event {
+			const char * name;
+			/// Microseconds, monotonic
+			double time;
+			char phase;
+		};
+
+		/// @brief One thread's events: only that thread writes, and it
+		/// publishes its count after each event for the dumper to read.
+		struct Ring {
+			Event * events;
+			volatile long written;
+			const char * threadName;
+			/// Whether a live thread records here
+			volatile long owned;
+		};
+
+		Ring g_rings[MAX_THREADS];
+		unsigned long g_capacity = 0;
+
+		TRACE_THREAD_LOCAL Ring * t_ring = NULL;
+		/// Set once this thread has found there's no slot left
+		TRACE_THREAD_LOCAL bool t_noSlot = false;
+
+		Ring * ringForThisThread() {
+			if (t_ring || t_noSlot) {
+				return t_ring;
+			}
+			// Slots come back as threads exit, so a thread started
+			// over and over (tracking, recording) doesn't use them up
+			for (int slot = 0; slot < MAX_THREADS; ++slot) {
+				if (atomic::exchange(&g_rings[slot].owned, 1) == 0) {
+					t_ring = &g_rings[slot];
+					return t_ring;
+				}
+			}
+			t_noSlot = true;
+			return NULL;
+		}
+
+		void record(const char * name, const char phase) {
+			Ring * ring = ringForThisThread();
+			if (!ring) {
+				return;
+			}
+			const long n = ring->written;
+			Event & e = ring->events[(unsigned long)(n) & (g_capacity - 1)];
+			e.name = name;
+			e.time = monotonic::seconds() * 1.0e6;
+			e.phase = phase;
+			atomic::store(&ring->written, n + 1);
+		}
+
+		void writeString(std::ostream & out, const char * s) {
+			out << '"';
+			for (; *s; ++s) {
+				if (*s == '"' || *s == '\\') {
+					out << '\\';
+				}
+				out << *s;
+			}
+			out << '"';
+		}
+	} // end of anonymous namespace
+
+	bool start(unsigned long capacity) {
+		if (!g_capacity) {
+			unsigned long rounded = 1;
+			while (rounded < capacity) {
+				rounded <<= 1;
+			}
+			for (int i = 0; i < MAX_THREADS; ++i) {
+				g_rings[i].events = new (std::nothrow) Event[rounded];
+				if (!g_rings[i].events) {
+					std::cerr << "Not enough memory for tracing" << std::endl;
+					return false;
+				}
+				g_rings[i].written = 0;
+				g_rings[i].threadName = NULL;
+				g_rings[i].owned = 0;
+			}
+			g_capacity = rounded;
+		}
+		atomic::barrier();
+		g_enabled = true;
+		return true;
+	}
+
+	void stop() {
+		g_enabled = false;
+		atomic::barrier();
+	}
+
+	void nameThread(const char * name) {
+		if (!g_capacity) {
+			return;
+		}
+		Ring * ring = ringForThisThread();
+		if (ring) {
+			ring->threadName = name;
+		}
+	}
+
+	void threadExiting() {
+		if (t_ring) {
+			atomic::store(&t_ring->owned, 0);
+			t_ring = NULL;
+		}
+		t_noSlot = false;
+	}
+
+	void begin(const char * name) {
+		record(name, 'B');
+	}
+
+	void end(const char * name) {
+		record(name, 'E');
+	}
+
+	bool writeFile(const std::string & filename) {
+		const bool wasEnabled = g_enabled;
+		stop();
+
+		std::ofstream out(filename.c_str());
+		if (!out.is_open()) {
+			std::cerr << "Could not write trace " << filename << std::endl;
+			g_enabled = wasEnabled;
+			return false;
+		}
+		out << "{\"traceEvents\":[" << std::endl;
+		bool first = true;
+		for (long t = 0; t < MAX_THREADS && g_capacity; ++t) {
+			const Ring & ring = g_rings[t];
+			if (ring.threadName) {
+				out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" <<
+					t << ",\"args\":{\"name\":";
+				writeString(out, ring.threadName);
+				out << "}}";
+				first = false;
+			}
+			const long written = atomic::load(&ring.written);
+			const long oldest = (written > long(g_capacity)) ? written - long(g_capacity) : 0;
+			out << std::fixed << std::setprecision(3);
+			for (long i = oldest; i < written; ++i) {
+				const Event & e = ring.events[(unsigned long)(i) & (g_capacity - 1)];
+				out << (first ? "" : ",\n") << "{\"name\":";
+				writeString(out, e.name);
+				out << ",\"ph\":\"" << e.phase << "\",\"ts\":" << e.time <<
+					",\"pid\":1,\"tid\":" << t << "}";
+				first = false;
+			}
+		}
+		out << std::endl << "]}" << std::endl;
+		const bool ok = out.good();
+		out.close();
+		if (ok) {
+			std::cout << "Wrote trace " << filename << std::endl;
+		}
+
+		g_enabled = wasEnabled;
+		return ok;
+	}
+
+} // end of trace namespace
@@ -0,0 +1,110 @@
+/** @file	Trace.h
+	@brief	header for opt-in event tracing to Chrome trace JSON
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _TRACE_H
+#define _TRACE_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <string>
+
+/// @brief Opt-in recording of begin/end events, per thread, for viewing
+/// in chrome://tracing or Perfetto.
+///
+/// Each thread that records gets its own ring buffer, allocated up front
+/// by start(), so recording an event takes no lock and no allocation -
+/// once full, the oldest events are overwritten. While tracing is off, a
+/// TraceScope costs one well-predicted branch.
+namespace trace {
+	enum {
+		/// Events each thread's ring holds: a power of two
+		DEFAULT_CAPACITY = 16384,
+		/// Threads that can record at once
+		MAX_THREADS = 8
+	};
+
+	/// Whether events are being recorded - read on every TraceScope
+	extern bool g_enabled;
+
+/// @addtogroup FreeFunctions Free Functions
+/// @{
+
+	inline bool enabled() {
+		return g_enabled;
+	}
+
+	/// @brief Allocate the rings (the first time) and start recording.
+	/// @param capacity Events per thread, rounded up to a power of two
+	bool start(unsigned long capacity = DEFAULT_CAPACITY);
+	/// @brief Stop recording, keeping what has been recorded.
+	void stop();
+
+	/// @brief Write everything recorded so far as Chrome trace JSON.
+	/// Recording is paused while writing, then resumes if it was on.
+	bool writeFile(const std::string & filename);
+
+	/// @brief Label the calling thread in the trace - a string literal.
+	void nameThread(const char * name);
+	/// @brief Give the calling thread's ring to the next thread to record
+	/// - call at the end of a thread that may be started again. Its
+	/// events stay in the trace, on the same row as its successor's.
+	void threadExiting();
+
+	/// @name Event recording - name must be a string literal, or
+	/// otherwise outlive the trace. Prefer TraceScope.
+	/// @{
+	void begin(const char * name);
+	void end(const char * name);
+	/// @}
+
+/// @}
+
+} // end of trace namespace
+
+/// @brief Records a begin event for its scope's start and an end event
+/// for its end, if tracing is on when it is created.
+class TraceScope {
+	public:
+		explicit TraceScope(const char * name) :
+				_name(trace::g_enabled ? name : 0) {
+			if (_name) {
+				trace::begin(_name);
+			}
+		}
+
+		~TraceScope() {
+			if (_name) {
+				trace::end(_name);
+			}
+		}
+
+	private:
+		TraceScope(const TraceScope &);
+		TraceScope & operator=(const TraceScope &);
+
+		const char * _name;
+};
+
+#endif // _TRACE_H
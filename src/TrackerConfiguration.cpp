@@ -27,9 +27,17 @@
 #include <cassert>
 #include <stdexcept>
 #include <algorithm>
+#include <sstream>
 
 static const std::string CONFIG_FIRST_LINE("WIIMOTETRACKERCONFIG");
 static const std::string CONFIG_SECOND_LINE("DONOTEDITBYHAND");
+static const std::string CONFIG_ADAPTIVE("ADAPTIVE");
+static const std::string CONFIG_FIXED("FIXED");
+static const std::string CONFIG_VELOCITY("VELOCITY");
+static const std::string CONFIG_ACCELERATION("ACCELERATION");
+static const std::string CONFIG_TRANSPORT_DEFAULT("DEFAULT");
+static const std::string CONFIG_TRANSPORT_RELIABLE("RELIABLE");
+static const std::string CONFIG_TRANSPORT_UNRELIABLE("UNRELIABLE");
 
 struct InvalidLEDDistance : public std::invalid_argument {
 	InvalidLEDDistance() : std::invalid_argument("LED distance must be positive and less than 1 meter") {}
@@ -39,13 +47,62 @@ struct InvalidTrackerName : public std::invalid_argument {
 	InvalidTrackerName() : std::invalid_argument("Tracker name must be alphanumeric with no spaces") {}
 };
 
+struct InvalidPublishRate : public std::invalid_argument {
+	InvalidPublishRate() : std::invalid_argument("Publication rate must be between 1 and 1000 Hz") {}
+};
+
+struct InvalidPredictionHorizon : public std::invalid_argument {
+	InvalidPredictionHorizon() : std::invalid_argument("Prediction horizon must be between 0 and 200 milliseconds") {}
+};
+
+struct InvalidCoastTime : public std::invalid_argument {
+	InvalidCoastTime() : std::invalid_argument("Coast time must be between 0 and 2000 milliseconds") {}
+};
+
+struct InvalidConstellation : public std::invalid_argument {
+	InvalidConstellation() : std::invalid_argument("LED constellation must be empty, or three or four LEDs not all in a line") {}
+};
+
+struct InvalidTransport : public std::invalid_argument {
+	InvalidTransport() : std::invalid_argument("Socket buffer size must be between 0 and 16384 kilobytes") {}
+};
+
+struct InvalidDisplaySync : public std::invalid_argument {
+	InvalidDisplaySync() : std::invalid_argument("Display period must be 0 or between 2 and 1000 milliseconds, and its phase not negative and less than the period") {}
+};
+
+struct InvalidSmoothing : public std::invalid_argument {
+	InvalidSmoothing() : std::invalid_argument("Smoothing cutoffs and speed coefficients must not be negative, and the speed cutoff must be positive") {}
+};
+
 struct NotAConfig : public std::runtime_error {
 	NotAConfig() : std::runtime_error("Not a Wii Remote Head Tracker configuration!") {}
 };
 
-TrackerConfiguration::TrackerConfiguration(const float ledDistance, const std::string & trackerName) :
+TrackerConfiguration::TrackerConfiguration(const float ledDistance,
+		const std::string & trackerName,
+		const float publishRate,
+		const bool adaptivePublish,
+		const float predictionHorizon,
+		const PredictionModel predictionModel,
+		const FilterParameters & smoothing,
+		const float coastTime,
+		const LedConstellation & constellation,
+		const TransportParameters & transport,
+		const float displayPeriod,
+		const float displayPhase) :
 		_ledDistance(ledDistance),
-		_trackerName(trackerName) {
+		_trackerName(trackerName),
+		_publishRate(publishRate),
+		_adaptivePublish(adaptivePublish),
+		_predictionHorizon(predictionHorizon),
+		_predictionModel(predictionModel),
+		_smoothing(smoothing),
+		_coastTime(coastTime),
+		_constellation(constellation),
+		_transport(transport),
+		_displayPeriod(displayPeriod),
+		_displayPhase(displayPhase) {
 	if (_ledDistance <= 0.0 || _ledDistance > 1.0) {
 		throw InvalidLEDDistance();
 	}
@@ -53,6 +110,45 @@ TrackerConfiguration::TrackerConfiguration(const float ledDistance, const std::s
 	if (_trackerName.size() == 0 || _trackerName.find(" ") != std::string::npos) {
 		throw InvalidTrackerName();
 	}
+
+	if (_publishRate < 1.0 || _publishRate > 1000.0) {
+		throw InvalidPublishRate();
+	}
+
+	if (_predictionHorizon < 0.0 || _predictionHorizon > 200.0) {
+		throw InvalidPredictionHorizon();
+	}
+
+	if (_smoothing.minCutoff < 0.0 || _smoothing.derivativeCutoff <= 0.0 ||
+			_smoothing.positionBeta < 0.0 || _smoothing.orientationBeta < 0.0) {
+		throw InvalidSmoothing();
+	}
+
+	if (_coastTime < 0.0 || _coastTime > 2000.0) {
+		throw InvalidCoastTime();
+	}
+
+	if (!_constellation.isValid()) {
+		throw InvalidConstellation();
+	}
+
+	if (_transport.socketBuffer < 0 || _transport.socketBuffer > 16384) {
+		throw InvalidTransport();
+	}
+
+	if ((_displayPeriod != 0 && (_displayPeriod < 2.0 || _displayPeriod > 1000.0)) ||
+			_displayPhase < 0 || (_displayPhase > 0 && _displayPhase >= _displayPeriod)) {
+		throw InvalidDisplaySync();
+	}
+}
+
+/// @brief Read a line, dropping any DOS line ending
+static bool readLine(std::istream & s, std::string & line) {
+	if (!std::getline(s, line)) {
+		return false;
+	}
+	line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
+	return true;
 }
 
 std::ostream & operator<<(std::ostream & s, const TrackerConfiguration & rhs) {
@@ -60,6 +156,29 @@ std::ostream & operator<<(std::ostream & s, const TrackerConfiguration & rhs) {
 	s << CONFIG_SECOND_LINE << std::endl;
 	s << rhs.getLEDDistance() << std::endl;
 	s << rhs.getTrackerName() << std::endl;
+	s << rhs.getPublishRate() << std::endl;
+	s << (rhs.getAdaptivePublish() ? CONFIG_ADAPTIVE : CONFIG_FIXED) << std::endl;
+	s << rhs.getPredictionHorizon() << std::endl;
+	s << (rhs.getPredictionModel() == PREDICT_CONSTANT_ACCELERATION ? CONFIG_ACCELERATION : CONFIG_VELOCITY) << std::endl;
+	const FilterParameters & smoothing = rhs.getSmoothing();
+	s << smoothing.minCutoff << " " << smoothing.derivativeCutoff << " " <<
+		smoothing.positionBeta << " " << smoothing.orientationBeta << std::endl;
+	s << rhs.getCoastTime() << std::endl;
+	s << rhs.getConstellation() << std::endl;
+	const TransportParameters & transport = rhs.getTransport();
+	switch (transport.mode) {
+		case TRANSPORT_RELIABLE:
+			s << CONFIG_TRANSPORT_RELIABLE;
+			break;
+		case TRANSPORT_UNRELIABLE:
+			s << CONFIG_TRANSPORT_UNRELIABLE;
+			break;
+		case TRANSPORT_DEFAULT:
+			s << CONFIG_TRANSPORT_DEFAULT;
+			break;
+	}
+	s << " " << transport.socketBuffer << std::endl;
+	s << rhs.getDisplayPeriod() << " " << rhs.getDisplayPhase() << std::endl;
 	return s;
 }
 std::istream & operator>>(std::istream & s, TrackerConfiguration & rhs) {
@@ -90,6 +209,120 @@ std::istream & operator>>(std::istream & s, TrackerConfiguration & rhs) {
 	std::remove(trackerName.begin(), trackerName.end(), '\n');
 	std::remove(trackerName.begin(), trackerName.end(), '\r');
 
-	rhs = TrackerConfiguration(ledDistance, trackerName);
+	// Older files end early: anything missing keeps its default
+	const TrackerConfiguration defaults;
+	float publishRate = defaults.getPublishRate();
+	bool adaptivePublish = defaults.getAdaptivePublish();
+	float predictionHorizon = defaults.getPredictionHorizon();
+	PredictionModel predictionModel = defaults.getPredictionModel();
+	FilterParameters smoothing = defaults.getSmoothing();
+	float coastTime = defaults.getCoastTime();
+	LedConstellation constellation = defaults.getConstellation();
+	TransportParameters transport = defaults.getTransport();
+	float displayPeriod = defaults.getDisplayPeriod();
+	float displayPhase = defaults.getDisplayPhase();
+
+	if (readLine(s, line) && !line.empty()) {
+		if (!fromString<float>(publishRate, line)) {
+			throw NotAConfig();
+		}
+		readLine(s, line);
+		if (line == CONFIG_ADAPTIVE) {
+			adaptivePublish = true;
+		} else if (line == CONFIG_FIXED) {
+			adaptivePublish = false;
+		} else {
+			throw NotAConfig();
+		}
+	}
+
+	if (readLine(s, line) && !line.empty()) {
+		if (!fromString<float>(predictionHorizon, line)) {
+			throw NotAConfig();
+		}
+		readLine(s, line);
+		if (line == CONFIG_ACCELERATION) {
+			predictionModel = PREDICT_CONSTANT_ACCELERATION;
+		} else if (line == CONFIG_VELOCITY) {
+			predictionModel = PREDICT_CONSTANT_VELOCITY;
+		} else {
+			throw NotAConfig();
+		}
+	}
+
+	if (readLine(s, line) && !line.empty()) {
+		std::istringstream values(line);
+		values >> smoothing.minCutoff >> smoothing.derivativeCutoff >>
+			smoothing.positionBeta >> smoothing.orientationBeta;
+		if (values.fail()) {
+			throw NotAConfig();
+		}
+	}
+
+	if (readLine(s, line) && !line.empty()) {
+		if (!fromString<float>(coastTime, line)) {
+			throw NotAConfig();
+		}
+	}
+
+	if (readLine(s, line) && !line.empty()) {
+		std::istringstream values(line);
+		values >> constellation;
+		if (values.fail()) {
+			throw NotAConfig();
+		}
+	}
+
+	if (readLine(s, line) && !line.empty()) {
+		std::istringstream values(line);
+		std::string mode;
+		values >> mode >> transport.socketBuffer;
+		if (values.fail()) {
+			throw NotAConfig();
+		}
+		if (mode == CONFIG_TRANSPORT_RELIABLE) {
+			transport.mode = TRANSPORT_RELIABLE;
+		} else if (mode == CONFIG_TRANSPORT_UNRELIABLE) {
+			transport.mode = TRANSPORT_UNRELIABLE;
+		} else if (mode == CONFIG_TRANSPORT_DEFAULT) {
+			transport.mode = TRANSPORT_DEFAULT;
+		} else {
+			throw NotAConfig();
+		}
+	}
+
+	if (readLine(s, line) && !line.empty()) {
+		std::istringstream values(line);
+		values >> displayPeriod >> displayPhase;
+		if (values.fail()) {
+			throw NotAConfig();
+		}
+	}
+
+	rhs = TrackerConfiguration(ledDistance, trackerName, publishRate, adaptivePublish,
+		predictionHorizon, predictionModel, smoothing, coastTime, constellation,
+		transport, displayPeriod, displayPhase);
 	return s;
 }
+
+std::string defaultConfigFileName(const int station) {
+	if (station == 0) {
+		return "default.headtrackconfig";
+	}
+	std::ostringstream s;
+	s << "station" << station << ".headtrackconfig";
+	return s.str();
+}
+
+TrackerConfiguration configurationForStation(const TrackerConfiguration & config,
+		const int station) {
+	const std::string & name = config.getTrackerName();
+	std::string::size_type end = name.find_last_not_of("0123456789");
+	std::ostringstream s;
+	s << name.substr(0, end == std::string::npos ? 0 : end + 1) << station;
+	return TrackerConfiguration(config.getLEDDistance(), s.str(),
+		config.getPublishRate(), config.getAdaptivePublish(),
+		config.getPredictionHorizon(), config.getPredictionModel(),
+		config.getSmoothing(), config.getCoastTime(), config.getConstellation(),
+		config.getTransport(), config.getDisplayPeriod(), config.getDisplayPhase());
+}
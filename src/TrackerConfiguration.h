@@ -22,7 +22,10 @@
 #define _TRACKERCONFIGURATION_H
 
 // Internal Includes
-// - none
+#include "PosePredictor.h"
+#include "PoseFilter.h"
+#include "LedConstellation.h"
+#include "PoseConnection.h"
 
 // Library/third-party includes
 // - none
@@ -33,20 +36,87 @@
 
 class TrackerConfiguration {
 	public:
-		TrackerConfiguration(const float ledDistance = .205, const std::string & trackerName = "Tracker0");
+		TrackerConfiguration(const float ledDistance = .205,
+			const std::string & trackerName = "Tracker0",
+			const float publishRate = 60,
+			const bool adaptivePublish = false,
+			const float predictionHorizon = 0,
+			const PredictionModel predictionModel = PREDICT_CONSTANT_VELOCITY,
+			const FilterParameters & smoothing = FilterParameters(),
+			const float coastTime = 250,
+			const LedConstellation & constellation = LedConstellation(),
+			const TransportParameters & transport = TransportParameters(),
+			const float displayPeriod = 0,
+			const float displayPhase = 0);
 
 		const float getLEDDistance() const;
 		const std::string & getTrackerName() const;
 
+		/// @brief Poses per second sent to clients - in adaptive mode,
+		/// only when no new IR frame has arrived to trigger one.
+		const float getPublishRate() const;
+
+		/// @brief Whether each new IR frame is published as soon as it
+		/// arrives, rather than resampled to getPublishRate().
+		const bool getAdaptivePublish() const;
+
+		/// @brief Milliseconds ahead to extrapolate the pose, published as
+		/// sensor 1 - 0 for no prediction.
+		const float getPredictionHorizon() const;
+		const PredictionModel getPredictionModel() const;
+
+		/// @brief Adaptive smoothing of published poses - off unless
+		/// its minimum cutoff is positive.
+		const FilterParameters & getSmoothing() const;
+
+		/// @brief Longest LED occlusion, in milliseconds, to carry the
+		/// pose on through before holding it - 0 to hold at once.
+		const float getCoastTime() const;
+
+		/// @brief Three or four LEDs to solve the full 6-DOF pose from,
+		/// or empty to track the two-LED bar getLEDDistance() apart.
+		const LedConstellation & getConstellation() const;
+
+		/// @brief The VRPN channel poses go to clients on, and socket
+		/// buffer sizes.
+		const TransportParameters & getTransport() const;
+
+		/// @brief Refresh period, in milliseconds, of the display to
+		/// publish for - just before each deadline, instead of at
+		/// getPublishRate() - or 0 to publish on the tracker's own clock.
+		const float getDisplayPeriod() const;
+		/// @brief Milliseconds past each multiple of the display period,
+		/// on the system clock, that its deadlines fall.
+		const float getDisplayPhase() const;
+
 	protected:
 		float _ledDistance;
 		std::string _trackerName;
+		float _publishRate;
+		bool _adaptivePublish;
+		float _predictionHorizon;
+		PredictionModel _predictionModel;
+		FilterParameters _smoothing;
+		float _coastTime;
+		LedConstellation _constellation;
+		TransportParameters _transport;
+		float _displayPeriod;
+		float _displayPhase;
 		//friend std::istream & operator>>(std::istream & s, TrackerConfiguration & rhs);
 };
 
 std::ostream & operator<<(std::ostream & s, const TrackerConfiguration & rhs);
 std::istream & operator>>(std::istream & s, TrackerConfiguration & rhs);
 
+/// @brief Configuration file read at startup for a station (pipeline):
+/// default.headtrackconfig for the first, stationN.headtrackconfig after.
+std::string defaultConfigFileName(const int station);
+
+/// @brief A copy of config for another station, with trailing digits of
+/// the tracker name replaced by the station number - Tracker0, Tracker1...
+TrackerConfiguration configurationForStation(const TrackerConfiguration & config,
+	const int station);
+
 // -- inline implementations -- //
 
 inline const float TrackerConfiguration::getLEDDistance() const {
@@ -57,4 +127,44 @@ inline const std::string & TrackerConfiguration::getTrackerName() const {
 	return _trackerName;
 }
 
+inline const float TrackerConfiguration::getPublishRate() const {
+	return _publishRate;
+}
+
+inline const bool TrackerConfiguration::getAdaptivePublish() const {
+	return _adaptivePublish;
+}
+
+inline const float TrackerConfiguration::getPredictionHorizon() const {
+	return _predictionHorizon;
+}
+
+inline const PredictionModel TrackerConfiguration::getPredictionModel() const {
+	return _predictionModel;
+}
+
+inline const FilterParameters & TrackerConfiguration::getSmoothing() const {
+	return _smoothing;
+}
+
+inline const float TrackerConfiguration::getCoastTime() const {
+	return _coastTime;
+}
+
+inline const LedConstellation & TrackerConfiguration::getConstellation() const {
+	return _constellation;
+}
+
+inline const TransportParameters & TrackerConfiguration::getTransport() const {
+	return _transport;
+}
+
+inline const float TrackerConfiguration::getDisplayPeriod() const {
+	return _displayPeriod;
+}
+
+inline const float TrackerConfiguration::getDisplayPhase() const {
+	return _displayPhase;
+}
+
 #endif // _SYSTEMCOMPONENTS_H
@@ -0,0 +1,49 @@
+/** @file	TrackerObserver.h
+	@brief	header for the in-process tap on tracker pipeline reports
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _TRACKEROBSERVER_H
+#define _TRACKEROBSERVER_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+
+// Standard includes
+// - none
+
+/// @brief Receives reports directly from the server-side devices, on the
+/// thread that mainloops them, just before they are sent to VRPN clients -
+/// no message encode/decode round trip through the connection.
+class TrackerObserver {
+	public:
+		virtual ~TrackerObserver() {}
+
+		/// @brief The head tracker is reporting a pose.
+		virtual void poseReported(const struct timeval & time,
+			const double pos[3], const double quat[4]) = 0;
+
+		/// @brief The Wiimote is reporting its analog channels.
+		virtual void wiimoteReported(const struct timeval & time,
+			const double channels[], int numChannels) = 0;
+};
+
+#endif // _TRACKEROBSERVER_H
@@ -0,0 +1,642 @@
+/**	@file	TrackerPipeline.cpp
+	@brief	Implementation of one Wiimote to head tracker pipeline
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "TrackerPipeline.h"
+#include "TrackingSystem.h"
+#include "MonotonicClock.h"
+#include "Trace.h"
+#include "WiimoteDevice.h"
+#include "SimulatedWiimote.h"
+#include "ReplayWiimote.h"
+#include "HeadTrackerDevice.h"
+
+// Library/third-party includes
+#include <vrpn_Tracker.h>
+#include <vrpn_Analog.h>
+#include <vrpn_Analog_Output.h>
+
+// Standard includes
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+
+#undef VERBOSE
+#undef VERY_VERBOSE
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#	define PIPELINE_SNPRINTF _snprintf
+#else
+#	define PIPELINE_SNPRINTF snprintf
+#endif
+
+/// @name Main loop wait bounds, in seconds
+/// @{
+const double WIIMOTE_SEARCH_WAIT = 0.05;	// Tracker up, no Wiimote reports yet
+const double FRAME_EARLY_WAKE = 0.002;		// Start polling this long before a frame is due
+const double FRAME_POLL_WAIT = 0.001;		// Poll interval while a frame is due
+const double MIN_WIIMOTE_PERIOD = 0.001;
+const double MAX_WIIMOTE_PERIOD = 0.05;
+/// @}
+
+/// @name VRPN callbacks
+/// @{
+static void	VRPN_CALLBACK handle_pos(void* userdata, const vrpn_TRACKERCB t) {
+	static_cast<TrackerPipeline*>(userdata)->poseReported(t.msg_time, t.pos, t.quat);
+}
+
+static void VRPN_CALLBACK handle_wiimote(void* userdata, const vrpn_ANALOGCB a) {
+	static_cast<TrackerPipeline*>(userdata)->wiimoteReported(a.msg_time, a.channel, a.num_channel);
+}
+/// @}
+
+TrackerPipeline::TrackerPipeline(TrackingSystem & system,
+		const int index,
+		const TrackerConfiguration & config,
+		const WiimoteSourceType source,
+		const unsigned wiimoteNumber) :
+		_system(system),
+		_index(index),
+		_sourceType(source),
+		_wiimoteNumber(wiimoteNumber),
+		_activeConfig(config),
+		_connection(NULL),
+		_wiimote(NULL),
+		_tracker(NULL),
+		_clientRunning(false),
+		_client(NULL),
+		_wiimoteClient(NULL),
+		_wiimoteOutClient(NULL),
+		_sharedPoses(),
+		_history(),
+		_report(),
+		_grabBattery(false),
+		_poseRate(),
+		_lastPoseTime(-1),
+		_poseAgeSum(0),
+		_poseAgeCount(0),
+		_posesSinceReport(0),
+		_awaitingFirstPose(false),
+		_startRequestedAt(0),
+		_measuringGap(false),
+		_gapFrom(0),
+		_worstGap(0),
+		_haveWiimoteReport(false),
+		_wiimotePeriod(0.01),
+		_wiimoteReports(0),
+		_inputWakes(false),
+		_sourceFinished(false) {
+	// Station 0 keeps the name a single-Wiimote setup always had
+	PIPELINE_SNPRINTF(_wiimoteName, sizeof(_wiimoteName), "WiiMote%d", index);
+	_wiimoteName[sizeof(_wiimoteName) - 1] = '\0';
+	PIPELINE_SNPRINTF(_wiimoteRemoteName, sizeof(_wiimoteRemoteName), "*%s", _wiimoteName);
+	_wiimoteRemoteName[sizeof(_wiimoteRemoteName) - 1] = '\0';
+}
+
+TrackerPipeline::~TrackerPipeline() {
+	teardownWiimoteDevice();
+}
+
+void TrackerPipeline::beginStartup(const double requestedAt) {
+	if (!_awaitingFirstPose) {
+		_awaitingFirstPose = true;
+		_startRequestedAt = requestedAt;
+	}
+}
+
+bool TrackerPipeline::advanceStartup(PoseConnection * connection) {
+	_connection = connection;
+	if (!_wiimote) {
+		return startWiimoteDevice();
+	} else if (!_tracker) {
+		return startTrackerDevice();
+	} else if (!_clientRunning) {
+		return startClientDevice();
+	}
+	return true;
+}
+
+void TrackerPipeline::stop() {
+	_awaitingFirstPose = false;
+	teardownWiimoteDevice();
+}
+
+void TrackerPipeline::clearReport() {
+	// Remove old from screen when shutting down tracker
+	_haveWiimoteReport = false;
+	_report = TrackerReport();
+	publishReport();
+}
+
+bool TrackerPipeline::isRunning() const {
+#ifdef VERY_VERBOSE
+	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
+#endif
+	return (_connection && _wiimote && _tracker && _clientRunning);
+}
+
+bool TrackerPipeline::isWiimoteConnected() const {
+	return (_wiimote && _wiimote->isConnected());
+}
+
+bool TrackerPipeline::readsBluetooth() const {
+	return isRunning() && _wiimote->readsBluetooth() && _wiimote->isConnected();
+}
+
+void TrackerPipeline::setInputWakes(const bool wakes) {
+	_inputWakes = wakes;
+}
+
+void TrackerPipeline::setProgress(const StartupStage stg) {
+	_system.postEvent(SystemEvent(SystemEvent::EVT_PROGRESS, stg, _index));
+}
+
+bool TrackerPipeline::startWiimoteDevice() {
+#ifdef VERBOSE
+	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
+#endif
+	TraceScope scope("start wiimote");
+
+	teardownWiimoteDevice();
+	if (!_connection) {
+		return false;
+	}
+
+	setProgress(STG_WIIMOTE_STARTING);
+	if (_sourceType == SOURCE_SIMULATED) {
+		// A different phase per station, so their poses differ
+		const LedConstellation & leds = _activeConfig.getConstellation();
+		_wiimote = new SimulatedWiimote(_wiimoteName, _connection,
+			leds.usable() ? leds : LedConstellation::bar(_activeConfig.getLEDDistance()),
+			_system.getSimulation(), 7.3 * _index);
+	} else if (_sourceType == SOURCE_REPLAY) {
+		_wiimote = new ReplayWiimote(_wiimoteName, _connection,
+			_system.getReplayFile(), _index, _system.getReplaySpeed());
+	} else {
+		_wiimote = new WiimoteDevice(_wiimoteName, _connection, _wiimoteNumber, 1, 1, 1);
+	}
+
+	if (!_wiimote) {
+		// error condition creating wiimote
+		setProgress(STG_WIIMOTE_ALLOCATE_FAILED);
+		return false;
+	}
+	if (_sourceType == SOURCE_REPLAY && !_wiimote->isConnected()) {
+		// Missing or unreadable log
+		teardownWiimoteDevice();
+		setProgress(STG_WIIMOTE_CONNECT_FAILED);
+		return false;
+	}
+	_sourceFinished = false;
+/*
+	if (!_wiimote->isConnected()) {
+		setProgress(STG_WIIMOTE_CONNECT_FAILED);
+		return false;
+	}
+*/
+	setProgress(STG_WIIMOTE_RUNNING);
+	return true;
+}
+
+HeadTrackerDevice * TrackerPipeline::createTrackerDevice(const TrackerConfiguration & config) {
+	HeadTrackerDevice * tracker = new HeadTrackerDevice(config.getTrackerName().c_str(),
+			_connection,
+			_wiimoteRemoteName,
+			config.getPublishRate(),
+			config.getAdaptivePublish(),
+			config.getLEDDistance());
+	if (tracker) {
+		tracker->setPrediction(config.getPredictionHorizon() / 1000.0,
+			config.getPredictionModel());
+		tracker->setSmoothing(config.getSmoothing());
+		tracker->setCoastTime(config.getCoastTime() / 1000.0);
+		tracker->setConstellation(config.getConstellation());
+		tracker->setDisplaySync(config.getDisplayPeriod() / 1000.0,
+			config.getDisplayPhase() / 1000.0);
+		tracker->setMetrics(_system.getStageMetrics());
+		setTransport(config);
+	}
+	return tracker;
+}
+
+void TrackerPipeline::setTransport(const TrackerConfiguration & config) {
+	if (!_connection->setTransport(config.getTrackerName().c_str(), config.getTransport())) {
+		std::cerr << "Too many trackers with their own transport - " <<
+			config.getTrackerName() << " keeps the default" << std::endl;
+	}
+}
+
+void TrackerPipeline::clearTransport(const TrackerConfiguration & config) {
+	if (_connection) {
+		_connection->setTransport(config.getTrackerName().c_str(), TransportParameters());
+	}
+}
+
+bool TrackerPipeline::startTrackerDevice() {
+#ifdef VERBOSE
+	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
+#endif
+	TraceScope scope("start tracker");
+	teardownTrackerDevice();
+	if (!_wiimote || !_connection) {
+		return false;
+	}
+	setProgress(STG_TRACKER_STARTING);
+
+	_tracker = createTrackerDevice(_activeConfig);
+	if (!_tracker) {
+		// error condition creating tracker device
+		setProgress(STG_TRACKER_ALLOCATE_FAILED);
+		return false;
+	}
+	if (_system.usingSharedMemory()) {
+		_sharedPoses.open(_activeConfig.getTrackerName());
+	}
+	// New device, new timing: don't carry gaps across a restart
+	_history.clear();
+	_poseRate.reset();
+	_posesSinceReport = 0;
+	_poseAgeSum = 0;
+	_poseAgeCount = 0;
+
+	setProgress(STG_TRACKER_RUNNING);
+	return true;
+}
+
+bool TrackerPipeline::startClientDevice() {
+#ifdef VERBOSE
+	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
+#endif
+	TraceScope scope("start client");
+
+	teardownClientDevice();
+	if (!_wiimote || !_connection || !_tracker) {
+		return false;
+	}
+	setProgress(STG_CLIENT_STARTING);
+
+	if (_system.usingLoopbackClients()) {
+		// Diagnostic path: our own reports, encoded, sent and decoded by
+		// VRPN just as an external client would see them
+		_client = new vrpn_Tracker_Remote(_activeConfig.getTrackerName().c_str(),
+				_connection);
+		_wiimoteClient = new vrpn_Analog_Remote(_wiimoteName,
+				_connection);
+		if (!_client || !_wiimoteClient) {
+			// error condition creating client devices
+			setProgress(STG_CLIENT_ALLOCATE_FAILED);
+			return false;
+		}
+		// Just the solved pose: the predicted sensor is for clients
+		_client->register_change_handler(this, handle_pos, HeadTrackerDevice::RAW_SENSOR);
+		_wiimoteClient->register_change_handler(this, handle_wiimote);
+	} else {
+		_tracker->setObserver(this);
+		_wiimote->setObserver(this);
+	}
+
+	_wiimoteOutClient = new vrpn_Analog_Output_Remote(_wiimoteName,
+			_connection);
+	if (!_wiimoteOutClient) {
+		// error condition creating client devices
+		setProgress(STG_CLIENT_ALLOCATE_FAILED);
+		return false;
+	}
+	_clientRunning = true;
+	_report.supportsSensitivity = (_wiimoteOutClient->getNumChannels() >= 2);
+	publishReport();
+
+	setProgress(STG_CLIENT_RUNNING);
+	return true;
+}
+
+void TrackerPipeline::teardownWiimoteDevice() {
+#ifdef VERBOSE
+	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
+#endif
+	teardownTrackerDevice();
+	if (_wiimote) {
+		delete _wiimote;
+		_wiimote = NULL;
+	}
+}
+
+void TrackerPipeline::teardownTrackerDevice() {
+#ifdef VERBOSE
+	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
+#endif
+	teardownClientDevice();
+	_sharedPoses.close();
+	if (_tracker) {
+		delete _tracker;
+		_tracker = NULL;
+		clearTransport(_activeConfig);
+	}
+}
+
+void TrackerPipeline::teardownClientDevice() {
+#ifdef VERBOSE
+	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
+#endif
+	_clientRunning = false;
+	if (_tracker) {
+		_tracker->setObserver(NULL);
+	}
+	if (_wiimote) {
+		_wiimote->setObserver(NULL);
+	}
+	if (_client) {
+		delete _client;
+		_client = NULL;
+	}
+	if (_wiimoteClient) {
+		delete _wiimoteClient;
+		_wiimoteClient = NULL;
+	}
+	delete _wiimoteOutClient;
+	_wiimoteOutClient = NULL;
+}
+
+bool TrackerPipeline::swapTrackerDevice(const TrackerConfiguration & config) {
+#ifdef VERBOSE
+	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
+#endif
+	// Build the replacement while the old device is still serving
+	HeadTrackerDevice * next = createTrackerDevice(config);
+	if (!next) {
+		std::cerr << "Could not allocate replacement tracker device - keeping the old one" << std::endl;
+		return false;
+	}
+
+	// We are between two mainloop passes here, so the old device has sent
+	// its last report and the new one sends the next.
+	const bool loopback = _system.usingLoopbackClients();
+	if (loopback) {
+		teardownClientDevice();
+	} else {
+		_tracker->setObserver(NULL);
+	}
+	delete _tracker;
+	_tracker = next;
+	if (config.getTrackerName() != _activeConfig.getTrackerName()) {
+		clearTransport(_activeConfig);
+	}
+	_activeConfig = config;
+	if (_sharedPoses.isOpen()) {
+		// Clients find the segment by tracker name
+		_sharedPoses.open(config.getTrackerName());
+	}
+
+	if (loopback) {
+		// Remotes are bound to the tracker name: they have to be rebuilt
+		return startClientDevice();
+	}
+	_tracker->setObserver(this);
+	return true;
+}
+
+bool TrackerPipeline::applyNewConfiguration(const TrackerConfiguration & config) {
+	if (!isRunning()) {
+		// Nothing is serving: the next start (or the one under way)
+		// builds the tracker with the new config instead
+		teardownTrackerDevice();
+		_activeConfig = config;
+		return true;
+	}
+
+	// Measure from the last pose out before the change to the first after
+	_measuringGap = (_lastPoseTime >= 0);
+	_gapFrom = _lastPoseTime;
+
+	if (config.getTrackerName() != _activeConfig.getTrackerName()) {
+		// A new VRPN sender name needs a new device
+		if (!swapTrackerDevice(config)) {
+			_measuringGap = false;
+			return false;
+		}
+	} else {
+		// Nothing to rebuild: clients never see a gap
+		_tracker->setLEDSpacing(config.getLEDDistance());
+		_tracker->setPublication(config.getPublishRate(), config.getAdaptivePublish());
+		_tracker->setPrediction(config.getPredictionHorizon() / 1000.0,
+			config.getPredictionModel());
+		_tracker->setSmoothing(config.getSmoothing());
+		_tracker->setCoastTime(config.getCoastTime() / 1000.0);
+		_tracker->setConstellation(config.getConstellation());
+		_tracker->setDisplaySync(config.getDisplayPeriod() / 1000.0,
+			config.getDisplayPhase() / 1000.0);
+		setTransport(config);
+		_activeConfig = config;
+	}
+	return true;
+}
+
+void TrackerPipeline::setSensitivity(int level) {
+	if (_report.supportsSensitivity && _wiimoteOutClient) {
+		_wiimoteOutClient->request_change_channel_value(1, level);
+	}
+}
+
+void TrackerPipeline::mainloop() {
+	if (isRunning()) {
+		const unsigned long reportsBefore = _wiimoteReports;
+		const double start = monotonic::seconds();
+		{
+			TraceScope scope("wiimote mainloop");
+			_wiimote->mainloop();
+		}
+		if (_wiimoteReports != reportsBefore) {
+			_system.recordStage(STAGE_WIIMOTE, monotonic::seconds() - start);
+		}
+		{
+			TraceScope scope("tracker mainloop");
+			_tracker->mainloop();
+		}
+		if (!_sourceFinished && _wiimote->isFinished()) {
+			_sourceFinished = true;
+			_system.postEvent(SystemEvent(SystemEvent::EVT_SOURCE_FINISHED, STG_STARTUP_COMPLETE, _index));
+		}
+	}
+
+	const bool connected = isWiimoteConnected();
+	if (connected != _report.wiimoteConnected) {
+		_report.wiimoteConnected = connected;
+		if (!connected) {
+			_report.battery = -1;
+		}
+		publishReport();
+	}
+}
+
+double TrackerPipeline::nextWakeDelay(const struct timeval & now) const {
+	// A report wakes the loop by itself if we're waiting on the
+	// Wiimote's socket; otherwise wake for its next frame, learned
+	// from its report phase - or for the next scheduled publication,
+	// if that comes first. A source that knows its own schedule just
+	// tells us.
+	const double publishDue = _tracker->untilDue(now);
+	const double sourceDue = _wiimote->untilNextReport(now);
+	double delay;
+	if (sourceDue >= 0) {
+		delay = sourceDue;
+	} else if (_inputWakes) {
+		delay = publishDue;
+	} else if (!_haveWiimoteReport) {
+		delay = WIIMOTE_SEARCH_WAIT;
+	} else {
+		const double sinceReport = vrpn_TimevalDuration(now, _lastWiimoteReport);
+		const double untilDue = _wiimotePeriod - sinceReport - FRAME_EARLY_WAKE;
+		if (untilDue > 0) {
+			delay = untilDue;
+		} else if (sinceReport < 3 * _wiimotePeriod) {
+			delay = FRAME_POLL_WAIT;
+		} else {
+			// Report stream has stalled - no point spinning for it.
+			delay = publishDue;
+		}
+	}
+	return std::min(delay, publishDue);
+}
+
+bool TrackerPipeline::latestReport(TrackerReport & report) {
+	if (!_reports.update()) {
+		return false;
+	}
+	report = _reports.readBuffer();
+	return true;
+}
+
+void TrackerPipeline::publishReport() {
+	_report.publishedAt = monotonic::seconds();
+	_reports.writeBuffer() = _report;
+	_reports.publish();
+	_system.notify();
+}
+
+void TrackerPipeline::setReport(const double pos[3], const double quat[4]) {
+	std::copy(pos, pos + 3, _report.pos);
+	std::copy(quat, quat + 4, _report.quat);
+	_report.rate = _poseRate.getMeanRate();
+	_report.gapStdDev = _poseRate.getGapStdDev();
+	_report.minGap = _poseRate.getMinGap();
+	_report.maxGap = _poseRate.getMaxGap();
+	_report.droppedFrames = _poseRate.getDroppedFrames();
+	_report.poseAge = _poseAgeCount ? _poseAgeSum / _poseAgeCount : 0;
+	_report.confidence = _tracker ? _tracker->getConfidence() : 0;
+	_poseAgeSum = 0;
+	_poseAgeCount = 0;
+	_report.hasPose = true;
+	_grabBattery = true;
+	publishReport();
+}
+
+void TrackerPipeline::setBattery(const double batLevel) {
+	if (_grabBattery) {
+		_grabBattery = false;
+		_report.battery = batLevel;
+		publishReport();
+	}
+}
+
+void TrackerPipeline::poseReported(const struct timeval & time,
+		const double pos[3], const double quat[4]) {
+	TraceScope scope("handle_pos");
+	if (_sharedPoses.isOpen()) {
+		_sharedPoses.publish(time, pos, quat, _tracker->getConfidence());
+	}
+	_history.push(time.tv_sec + time.tv_usec / 1.0e6, pos, quat);
+	recordPose(pos, quat);
+}
+
+void TrackerPipeline::wiimoteReported(const struct timeval & time,
+		const double channels[], int numChannels) {
+	TraceScope scope("handle_wiimote");
+	_wiimoteReports++;
+	recordWiimoteReport(time, channels, numChannels);
+	_system.recordFrame(_index, time, channels, numChannels);
+	if (numChannels > 0) {
+		setBattery(channels[0]);
+	}
+}
+
+void TrackerPipeline::recordWiimoteReport(const struct timeval & reportTime,
+		const double channels[], int numChannels) {
+	if (_haveWiimoteReport) {
+		// Smooth the observed inter-report period
+		const double period = vrpn_TimevalDuration(reportTime, _lastWiimoteReport);
+		if (period >= MIN_WIIMOTE_PERIOD && period <= MAX_WIIMOTE_PERIOD) {
+			_wiimotePeriod = 0.9 * _wiimotePeriod + 0.1 * period;
+		}
+	}
+	_lastWiimoteReport = reportTime;
+	_haveWiimoteReport = true;
+	if (_tracker) {
+		_tracker->frameArrived(reportTime, channels, numChannels);
+	}
+	_system.recordInput(reportTime);
+}
+
+void TrackerPipeline::recordPose(const double pos[3], const double quat[4]) {
+	struct timeval now;
+	vrpn_gettimeofday(&now, NULL);
+	_system.recordPublish(now);
+
+	const double poseTime = monotonic::seconds();
+	_poseRate.recordArrival(poseTime);
+	checkFirstPose();
+	checkReconfigureGap(poseTime);
+	_lastPoseTime = poseTime;
+
+	if (_haveWiimoteReport) {
+		// How old the newest IR frame was when this pose went out
+		_poseAgeSum += vrpn_TimevalDuration(now, _lastWiimoteReport);
+		_poseAgeCount++;
+	}
+
+	// Statistics see every pose; the front end only every REPORT_STRIDE
+	if (++_posesSinceReport >= REPORT_STRIDE) {
+		_posesSinceReport = 0;
+		setReport(pos, quat);
+	}
+}
+
+void TrackerPipeline::checkFirstPose() {
+	if (!_awaitingFirstPose || !isRunning() || !_haveWiimoteReport) {
+		// Keep-alive poses sent before any Wiimote data don't count
+		return;
+	}
+	_awaitingFirstPose = false;
+	std::cout << _activeConfig.getTrackerName() << ": time to first pose " <<
+		monotonic::seconds() - _startRequestedAt << " s after start request";
+	if (_system.firstPoseEver()) {
+		std::cout << ", " << monotonic::sinceLaunch() << " s after launch";
+	}
+	std::cout << std::endl;
+}
+
+void TrackerPipeline::checkReconfigureGap(const double now) {
+	if (!_measuringGap) {
+		return;
+	}
+	_measuringGap = false;
+	const double gap = now - _gapFrom;
+	_worstGap = std::max(gap, _worstGap);
+	std::cout << _activeConfig.getTrackerName() << ": output gap across reconfiguration " <<
+		gap * 1000.0 << " ms (worst so far " << _worstGap * 1000.0 << " ms)" << std::endl;
+}
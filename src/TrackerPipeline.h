@@ -0,0 +1,251 @@
+/** @file	TrackerPipeline.h
+	@brief	header for one Wiimote to head tracker pipeline of the tracking system
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _TRACKERPIPELINE_H
+#define _TRACKERPIPELINE_H
+
+// Internal Includes
+#include "SystemComponents.h"
+#include "TrackerConfiguration.h"
+#include "TrackerObserver.h"
+#include "TrackerReport.h"
+#include "RateStatistics.h"
+#include "PoseHistory.h"
+#include "SharedPoseSink.h"
+#include "TripleBuffer.h"
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+
+// Standard includes
+// - none
+
+class PoseConnection;
+class vrpn_Tracker_Remote;
+class vrpn_Analog_Remote;
+class vrpn_Analog_Output_Remote;
+class WiimoteSource;
+class HeadTrackerDevice;
+class TrackingSystem;
+
+/// @brief What a pipeline takes its IR points from
+enum WiimoteSourceType {
+	SOURCE_WIIMOTE,
+	SOURCE_SIMULATED,
+	/// A recorded IR log - see TrackingSystem::setReplay()
+	SOURCE_REPLAY
+};
+
+/// @brief One station: a Wiimote (or stand-in) feeding a head tracker
+/// device served under its own name, on the tracking system's shared
+/// connection, with its own configuration, statistics and report.
+///
+/// Only ever touched from the tracking loop's thread, apart from
+/// latestReport().
+class TrackerPipeline : public TrackerObserver {
+	public:
+		/// @param wiimoteNumber Which Wiimote to connect to, for SOURCE_WIIMOTE
+		TrackerPipeline(TrackingSystem & system,
+			const int index,
+			const TrackerConfiguration & config,
+			const WiimoteSourceType source,
+			const unsigned wiimoteNumber);
+		~TrackerPipeline();
+
+		int getIndex() const;
+		WiimoteSourceType getSourceType() const;
+		const TrackerConfiguration & getConfiguration() const;
+
+		/// @name Startup and teardown
+		/// @{
+		/// @brief Begin a start (or restart) of this pipeline.
+		void beginStartup(const double requestedAt);
+		/// @brief Start the next component that isn't running.
+		/// @returns false on failure, already reported as progress.
+		bool advanceStartup(PoseConnection * connection);
+		/// @brief Tear everything down - the connection is going away.
+		void stop();
+		/// @brief Publish an empty report, for a stopped system
+		void clearReport();
+
+		bool isRunning() const;
+
+		void teardownWiimoteDevice();
+		void teardownTrackerDevice();
+		void teardownClientDevice();
+		/// @}
+
+		/// @brief Reconfigure, as in place as possible.
+		bool applyNewConfiguration(const TrackerConfiguration & config);
+		void setSensitivity(int level);
+
+		/// @name Tracking loop
+		/// @{
+		/// @brief Mainloop the devices once, and note connection changes
+		void mainloop();
+		/// @brief How long the loop may block before this pipeline has
+		/// something due
+		double nextWakeDelay(const struct timeval & now) const;
+		/// @brief Whether the Wiimote is connected over a Bluetooth
+		/// socket the loop could wait on
+		bool readsBluetooth() const;
+		/// @brief Tell the pipeline whether its Wiimote's reports wake
+		/// the loop, so it need not poll for them
+		void setInputWakes(const bool wakes);
+		/// @}
+
+		/// @brief Consumer side: call from one front-end thread only.
+		/// @returns true if report was updated with newer values.
+		bool latestReport(TrackerReport & report);
+
+		/// @brief Recent poses by time - query from any thread.
+		const PoseHistory & getHistory() const;
+
+		/// @name TrackerObserver interface, also used by the loopback
+		/// client callbacks
+		/// @{
+		virtual void poseReported(const struct timeval & time,
+			const double pos[3], const double quat[4]);
+		virtual void wiimoteReported(const struct timeval & time,
+			const double channels[], int numChannels);
+		/// @}
+
+	protected:
+		bool startWiimoteDevice();
+		bool startTrackerDevice();
+		bool startClientDevice();
+		/// @brief Replace the running tracker with one built for config,
+		/// between two loop passes, and make config active. The old one
+		/// keeps running if the new one can't be allocated.
+		bool swapTrackerDevice(const TrackerConfiguration & config);
+		HeadTrackerDevice * createTrackerDevice(const TrackerConfiguration & config);
+		/// @brief Have the connection send config's tracker's reports
+		/// as its transport says - or as VRPN would, once cleared.
+		void setTransport(const TrackerConfiguration & config);
+		void clearTransport(const TrackerConfiguration & config);
+
+		bool isWiimoteConnected() const;
+
+		void setProgress(const StartupStage stg);
+		void recordPose(const double pos[3], const double quat[4]);
+		void recordWiimoteReport(const struct timeval & reportTime,
+			const double channels[], int numChannels);
+		void setBattery(const double batLevel);
+		void setReport(const double pos[3], const double quat[4]);
+		void publishReport();
+
+		/// @brief Log time to first pose after a start, if this is it
+		void checkFirstPose();
+
+		/// @brief Log the output gap across a reconfiguration, if one
+		/// is being measured
+		void checkReconfigureGap(const double now);
+
+		TrackingSystem & _system;
+		const int _index;
+		const WiimoteSourceType _sourceType;
+		const unsigned _wiimoteNumber;
+		TrackerConfiguration _activeConfig;
+
+		/// @name VRPN names of our Wiimote source, as a server and as
+		/// seen from the tracker on the same connection
+		/// @{
+		char _wiimoteName[32];
+		char _wiimoteRemoteName[32];
+		/// @}
+
+		/// @name VRPN objects
+		/// @{
+		PoseConnection * _connection;
+		WiimoteSource * _wiimote;
+		HeadTrackerDevice * _tracker;
+		/// Whether the client stage (tap or loopback remotes) is up
+		bool _clientRunning;
+		/// @name Loopback remotes, only with loopback clients
+		/// @{
+		vrpn_Tracker_Remote * _client;
+		vrpn_Analog_Remote * _wiimoteClient;
+		/// @}
+		/// Sensitivity requests are rare enough to go through VRPN
+		vrpn_Analog_Output_Remote * _wiimoteOutClient;
+		/// @}
+
+		/// Same-host output, open while the tracker device is, if enabled
+		SharedPoseSink _sharedPoses;
+		/// Every pose published, for queries by time
+		PoseHistory _history;
+
+		/// @name Report to the front end
+		/// @{
+		TripleBuffer<TrackerReport> _reports;
+		TrackerReport _report;
+		bool _grabBattery;
+		RateStatistics _poseRate;
+		/// Monotonic time of the last pose, or negative if none yet
+		double _lastPoseTime;
+		double _poseAgeSum;
+		int _poseAgeCount;
+		/// Poses since _report was last given a new pose
+		int _posesSinceReport;
+		/// @}
+
+		/// @name Startup and reconfiguration timing
+		/// @{
+		bool _awaitingFirstPose;
+		double _startRequestedAt;
+		bool _measuringGap;
+		double _gapFrom;
+		double _worstGap;
+		/// @}
+
+		/// @name Wiimote frame timing, for scheduling the loop
+		/// @{
+		bool _haveWiimoteReport;
+		struct timeval _lastWiimoteReport;
+		double _wiimotePeriod;
+		/// Reports seen since start, to tell which passes brought one
+		unsigned long _wiimoteReports;
+		/// Whether a report arriving wakes the loop by itself
+		bool _inputWakes;
+		/// @}
+
+		/// Whether the source's end has been announced
+		bool _sourceFinished;
+};
+
+// -- inline implementations -- //
+
+inline int TrackerPipeline::getIndex() const {
+	return _index;
+}
+
+inline WiimoteSourceType TrackerPipeline::getSourceType() const {
+	return _sourceType;
+}
+
+inline const TrackerConfiguration & TrackerPipeline::getConfiguration() const {
+	return _activeConfig;
+}
+
+inline const PoseHistory & TrackerPipeline::getHistory() const {
+	return _history;
+}
+
+#endif // _TRACKERPIPELINE_H
@@ -0,0 +1,85 @@
+/** @file	TrackerReport.h
+	@brief	header for the display values the tracking pipeline hands to front ends
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _TRACKERREPORT_H
+#define _TRACKERREPORT_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+#define REPORT_STRIDE 30
+
+/// @brief Latest values for display, handed over as plain numbers.
+struct TrackerReport {
+	TrackerReport() :
+			hasPose(false),
+			rate(0),
+			gapStdDev(0),
+			minGap(0),
+			maxGap(0),
+			droppedFrames(0),
+			poseAge(0),
+			confidence(0),
+			battery(-1),
+			wiimoteConnected(false),
+			supportsSensitivity(false),
+			publishedAt(0) {
+		pos[0] = pos[1] = pos[2] = 0;
+		quat[0] = quat[1] = quat[2] = 0;
+		quat[3] = 1;
+	}
+
+	bool hasPose;
+	double pos[3];
+	double quat[4];
+
+	/// @name Pose timing over the recent window (gaps in seconds)
+	/// @{
+	double rate;
+	double gapStdDev;
+	double minGap;
+	double maxGap;
+	/// Since the tracker device started
+	unsigned long droppedFrames;
+	/// Mean age of the newest IR frame when each pose was published
+	double poseAge;
+	/// @}
+
+	/// 0 to 1: falls while coasting through LED occlusion, or while the
+	/// camera is being moved
+	double confidence;
+
+	/// Fraction of full charge, or negative if not known
+	double battery;
+	bool wiimoteConnected;
+	bool supportsSensitivity;
+
+	/// Monotonic time this report was handed to the front end
+	double publishedAt;
+};
+
+#endif // _TRACKERREPORT_H
+
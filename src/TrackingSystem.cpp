@@ -0,0 +1,601 @@
+/**	@file	TrackingSystem.cpp
+	@brief	Implementation of the VRPN tracking pipeline
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "TrackingSystem.h"
+#include "MonotonicClock.h"
+#include "PoseConnection.h"
+#include "Trace.h"
+#include "WiimoteDevice.h"
+
+// Library/third-party includes
+#include <vrpn_Configure.h>
+#include <vrpn_Connection.h>
+#include <vrpn_Thread.h>
+
+// Standard includes
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <algorithm>
+
+#undef VERBOSE
+#undef VERY_VERBOSE
+
+
+/// Main loop wait with the tracker stopped: only commands can wake us
+const double IDLE_WAIT = 0.1;
+
+/// Seconds between stage metric snapshots for the front end
+const double METRICS_INTERVAL = 1.0;
+
+/// Seconds between searches for a connected Wiimote's socket not yet found
+const double BLUETOOTH_SEARCH_INTERVAL = 1.0;
+
+static void trackingThread(vrpn_ThreadData & data) {
+	static_cast<TrackingSystem*>(data.pvUD)->runLoop();
+}
+
+TrackingSystem::TrackingSystem() :
+		_connection(NULL),
+		_listenPort(vrpn_DEFAULT_LISTEN_PORT_NO),
+		_numPipelines(0),
+		_numWiimotes(0),
+		_loopbackClients(false),
+		_sharedMemory(false),
+		_latestValue(false),
+		_replayFile(),
+		_replaySpeed(1.0),
+		_simulation(),
+		_notify(NULL),
+		_notifyData(NULL),
+		_starting(false),
+		_firstPoseEver(true),
+		_loop(),
+		_loopStats(),
+		_pollingLoop(false),
+		_bluetoothPipelines(0),
+		_bluetoothSockets(),
+		_bluetoothSearchedAt(0),
+		_recorder(),
+		_metrics(),
+		_metricsOut(),
+		_metricsSince(monotonic::seconds()),
+		_metricsPublishedAt(_metricsSince),
+		_posesPending(false),
+		_thread(NULL),
+		_threadFinished(1),
+		_quitRequested(0) {
+	for (int i = 0; i < MAX_PIPELINES; ++i) {
+		_pipelines[i] = NULL;
+	}
+}
+
+TrackingSystem::~TrackingSystem() {
+	stopThread();
+	teardownConnection();
+	for (int i = 0; i < _numPipelines; ++i) {
+		delete _pipelines[i];
+		_pipelines[i] = NULL;
+	}
+}
+
+int TrackingSystem::addPipeline(const TrackerConfiguration & config,
+		const WiimoteSourceType source) {
+	assert(!_connection);
+	if (_numPipelines >= MAX_PIPELINES) {
+		std::cerr << "Can't add tracker " << config.getTrackerName() <<
+			": already serving the most pipelines, " << MAX_PIPELINES << std::endl;
+		return -1;
+	}
+	for (int i = 0; i < _numPipelines; ++i) {
+		if (_pipelines[i]->getConfiguration().getTrackerName() == config.getTrackerName()) {
+			std::cerr << "Can't add tracker " << config.getTrackerName() <<
+				": another pipeline already uses that name" << std::endl;
+			return -1;
+		}
+	}
+	const unsigned wiimoteNumber = _numWiimotes;
+	if (source == SOURCE_WIIMOTE) {
+		_numWiimotes++;
+	}
+	_pipelines[_numPipelines] = new TrackerPipeline(*this, _numPipelines, config, source, wiimoteNumber);
+	return _numPipelines++;
+}
+
+void TrackingSystem::setNotifyCallback(NotifyCallback cb, void * userdata) {
+	_notify = cb;
+	_notifyData = userdata;
+}
+
+void TrackingSystem::setReplay(const std::string & filename, const double speed) {
+	assert(!_connection);
+	_replayFile = filename;
+	_replaySpeed = (speed > 0) ? speed : 0;
+}
+
+void TrackingSystem::setListenPort(const int port) {
+	_listenPort = port;
+}
+
+void TrackingSystem::setSimulation(const SimulationParameters & params) {
+	assert(!_connection);
+	_simulation = params;
+}
+
+void TrackingSystem::usePollingLoop(bool polling) {
+	_pollingLoop = polling;
+}
+
+void TrackingSystem::useLoopbackClients(bool loopback) {
+	_loopbackClients = loopback;
+}
+
+void TrackingSystem::useSharedMemory(bool shared) {
+	_sharedMemory = shared;
+}
+
+void TrackingSystem::useLatestValue(bool latest) {
+	_latestValue = latest;
+}
+
+bool TrackingSystem::startThread() {
+	if (_thread) {
+		return true;
+	}
+	atomic::store(&_threadFinished, 0);
+	atomic::store(&_quitRequested, 0);
+
+	vrpn_ThreadData td;
+	td.pvUD = this;
+	td.ps = NULL;
+	_thread = new vrpn_Thread(trackingThread, td);
+	if (!_thread->go()) {
+		std::cerr << "Could not start the tracking thread!" << std::endl;
+		delete _thread;
+		_thread = NULL;
+		atomic::store(&_threadFinished, 1);
+		return false;
+	}
+	return true;
+}
+
+void TrackingSystem::stopThread() {
+	if (!_thread) {
+		return;
+	}
+	requestQuit();
+	while (!atomic::load(&_threadFinished)) {
+		vrpn_SleepMsecs(1);
+	}
+	delete _thread;
+	_thread = NULL;
+}
+
+bool TrackingSystem::isThreadRunning() const {
+	return _thread && !atomic::load(&_threadFinished);
+}
+
+void TrackingSystem::requestQuit() {
+	atomic::store(&_quitRequested, 1);
+	_loop.wake();
+}
+
+void TrackingSystem::runLoop() {
+	trace::nameThread("tracking");
+	_loopStats.reset();
+	while (processCommands()) {
+		TraceScope pass("loop pass");
+		advanceStartup();
+		serviceDevices();
+
+		struct timeval now;
+		vrpn_gettimeofday(&now, NULL);
+		_loopStats.recordWakeup();
+		if (_loopStats.update(now)) {
+			std::cout << (_pollingLoop ? "Polling" : "Event-driven") <<
+				" main loop: " << _loopStats << std::endl;
+		}
+		const double mono = monotonic::seconds();
+		if (mono - _metricsPublishedAt >= METRICS_INTERVAL) {
+			_metrics.uptime = mono - _metricsSince;
+			for (int i = 0; i < StageMetrics::CLIENTS; ++i) {
+				if (_connection) {
+					_metrics.clients[i] = _connection->getClient(i);
+				} else {
+					_metrics.clients[i].reset();
+				}
+			}
+			_metricsOut.writeBuffer() = _metrics;
+			_metricsOut.publish();
+			_metricsPublishedAt = mono;
+			notify();
+		}
+
+		TraceScope wait("wait");
+		if (_pollingLoop) {
+			// Sleep for 1ms so we don't eat the CPU
+			vrpn_SleepMsecs(1);
+		} else {
+			registerDescriptors();
+			_loop.wait(nextWakeDelay(now));
+			dropFailedDescriptors();
+		}
+	}
+	teardownConnection();
+	_recorder.close();
+	trace::threadExiting();
+	atomic::store(&_threadFinished, 1);
+}
+
+void TrackingSystem::postCommand(const TrackingCommand & cmd) {
+	TrackingCommand stamped(cmd);
+	stamped.postedAt = monotonic::seconds();
+	if (!_commands.push(stamped)) {
+		std::cerr << "Tracking command queue full - command dropped!" << std::endl;
+	}
+	_loop.wake();
+}
+
+bool TrackingSystem::nextEvent(SystemEvent & evt) {
+	return _events.pop(evt);
+}
+
+bool TrackingSystem::latestReport(const int pipeline, TrackerReport & report) {
+	if (!isValidPipeline(pipeline)) {
+		return false;
+	}
+	return _pipelines[pipeline]->latestReport(report);
+}
+
+bool TrackingSystem::latestMetrics(StageMetrics & metrics) {
+	if (!_metricsOut.update()) {
+		return false;
+	}
+	metrics = _metricsOut.readBuffer();
+	return true;
+}
+
+bool TrackingSystem::poseAt(const int pipeline, const double time, double pos[3],
+		double quat[4]) const {
+	if (!isValidPipeline(pipeline)) {
+		return false;
+	}
+	return _pipelines[pipeline]->getHistory().poseAt(time, pos, quat);
+}
+
+bool TrackingSystem::isValidPipeline(const int pipeline) const {
+	return pipeline >= 0 && pipeline < _numPipelines;
+}
+
+bool TrackingSystem::processCommands() {
+	if (atomic::load(&_quitRequested)) {
+		return false;
+	}
+	TrackingCommand cmd;
+	while (_commands.pop(cmd)) {
+		switch (cmd.type) {
+			case TrackingCommand::CMD_START:
+				startTrackerSystem(cmd.postedAt);
+				break;
+
+			case TrackingCommand::CMD_STOP:
+				stopTrackerSystem();
+				break;
+
+			case TrackingCommand::CMD_TEARDOWN:
+				// Don't bring it straight back up: a reset is torn
+				// down, then started again by a separate CMD_START
+				_starting = false;
+				teardown(cmd.component, cmd.pipeline);
+				break;
+
+			case TrackingCommand::CMD_APPLY_CONFIG:
+				applyNewConfiguration(cmd.pipeline, cmd.config);
+				break;
+
+			case TrackingCommand::CMD_SET_SENSITIVITY:
+				setSensitivity(cmd.pipeline, cmd.level);
+				break;
+
+			case TrackingCommand::CMD_START_RECORDING:
+				// A new file always starts a new log
+				_recorder.open(cmd.path);
+				break;
+
+			case TrackingCommand::CMD_STOP_RECORDING:
+				_recorder.close();
+				break;
+
+			case TrackingCommand::CMD_QUIT:
+				return false;
+		}
+	}
+	return true;
+}
+
+void TrackingSystem::teardown(const TrackerComponent cmp, const int pipeline) {
+	if (cmp == CMP_CONNECTION) {
+		teardownConnection();
+		return;
+	}
+	if (!isValidPipeline(pipeline)) {
+		return;
+	}
+	switch (cmp) {
+		case CMP_CONNECTION:
+			break;
+		case CMP_WIIMOTE:
+			_pipelines[pipeline]->teardownWiimoteDevice();
+			break;
+		case CMP_TRACKER:
+			_pipelines[pipeline]->teardownTrackerDevice();
+			break;
+		case CMP_CLIENT:
+			_pipelines[pipeline]->teardownClientDevice();
+			break;
+	}
+}
+
+void TrackingSystem::serviceDevices() {
+	bool serving = false;
+	for (int i = 0; i < _numPipelines; ++i) {
+		_pipelines[i]->mainloop();
+		serving = serving || _pipelines[i]->isRunning();
+	}
+	// Stations already up keep serving while later ones start
+	if (serving) {
+		TraceScope scope("connection mainloop");
+		const double start = monotonic::seconds();
+		_connection->mainloop();
+		if (_posesPending) {
+			recordStage(STAGE_SEND, monotonic::seconds() - start);
+			_posesPending = false;
+		}
+	}
+}
+
+double TrackingSystem::nextWakeDelay(const struct timeval & now) const {
+	if (isStarting()) {
+		// Next component is ready to start as soon as we've checked commands
+		return 0;
+	}
+	double delay = IDLE_WAIT;
+	for (int i = 0; i < _numPipelines; ++i) {
+		if (_pipelines[i]->isRunning()) {
+			delay = std::min(delay, _pipelines[i]->nextWakeDelay(now));
+		}
+	}
+	return delay;
+}
+
+void TrackingSystem::registerDescriptors() {
+	unsigned long bluetooth = 0;
+	unsigned int wiimotes = 0;
+	for (int i = 0; i < _numPipelines; ++i) {
+		if (_pipelines[i]->readsBluetooth()) {
+			bluetooth |= 1UL << i;
+			wiimotes++;
+		}
+	}
+	const double now = monotonic::seconds();
+	if (bluetooth != _bluetoothPipelines ||
+			(_bluetoothSockets.size() < wiimotes && now - _bluetoothSearchedAt >= BLUETOOTH_SEARCH_INTERVAL)) {
+		// A Wiimote came or went, so its socket did too - or one we
+		// looked for wasn't open yet
+		_bluetoothPipelines = bluetooth;
+		_bluetoothSearchedAt = now;
+		_bluetoothSockets.clear();
+		if (bluetooth && !wiimote::findSockets(_bluetoothSockets)) {
+			_bluetoothSockets.clear();
+		}
+	}
+
+	_loop.clearDescriptors();
+	if (_connection) {
+		_connection->addDescriptors(_loop);
+	}
+	for (unsigned int i = 0; i < _bluetoothSockets.size(); ++i) {
+		_loop.addDescriptor(_bluetoothSockets[i]);
+	}
+	// Unless every connected Wiimote's socket was found, time wakeups
+	// for all of them as before
+	const bool wakes = wiimotes > 0 && _bluetoothSockets.size() >= wiimotes;
+	for (int i = 0; i < _numPipelines; ++i) {
+		_pipelines[i]->setInputWakes(wakes && (bluetooth & (1UL << i)));
+	}
+}
+
+void TrackingSystem::dropFailedDescriptors() {
+	const std::vector<int> & failed = _loop.getFailedDescriptors();
+	for (unsigned int i = 0; i < failed.size(); ++i) {
+		std::vector<int>::iterator it = std::find(_bluetoothSockets.begin(),
+			_bluetoothSockets.end(), failed[i]);
+		if (it != _bluetoothSockets.end()) {
+			// Closed or hung up under wiiuse: search again on the next
+			// pass, which may find its number reused or its replacement
+			_bluetoothSockets.erase(it);
+			_bluetoothSearchedAt = monotonic::seconds() - BLUETOOTH_SEARCH_INTERVAL;
+		}
+	}
+}
+
+void TrackingSystem::postEvent(const SystemEvent & evt) {
+	if (!_events.push(evt)) {
+		std::cerr << "System event queue full - event dropped!" << std::endl;
+	}
+	notify();
+}
+
+void TrackingSystem::setProgress(const StartupStage stg) {
+	postEvent(SystemEvent(SystemEvent::EVT_PROGRESS, stg));
+}
+
+void TrackingSystem::notify() {
+	if (_notify) {
+		_notify(_notifyData);
+	}
+}
+
+void TrackingSystem::recordInput(const struct timeval & inputTime) {
+	_loopStats.recordInput(inputTime);
+}
+
+void TrackingSystem::recordPublish(const struct timeval & publishTime) {
+	_loopStats.recordPublish(publishTime);
+	_posesPending = true;
+}
+
+bool TrackingSystem::firstPoseEver() {
+	const bool first = _firstPoseEver;
+	_firstPoseEver = false;
+	return first;
+}
+
+void TrackingSystem::recordFrame(const int pipeline, const struct timeval & time,
+		const double channels[], const int numChannels) {
+	if (_recorder.isOpen()) {
+		_recorder.record(pipeline, time, channels, numChannels);
+	}
+}
+
+void TrackingSystem::stopTrackerSystem() {
+	postEvent(SystemEvent(SystemEvent::EVT_TRANSITION));
+	_starting = false;
+	teardownConnection();
+	for (int i = 0; i < _numPipelines; ++i) {
+		_pipelines[i]->clearReport();
+	}
+	postEvent(SystemEvent(SystemEvent::EVT_DOWN));
+}
+
+void TrackingSystem::startTrackerSystem(const double requestedAt) {
+	postEvent(SystemEvent(SystemEvent::EVT_TRANSITION));
+	_starting = true;
+	for (int i = 0; i < _numPipelines; ++i) {
+		_pipelines[i]->beginStartup(requestedAt);
+	}
+}
+
+void TrackingSystem::advanceStartup() {
+	if (!_starting) {
+		return;
+	}
+
+	// One component per call, so commands and progress events are
+	// handled between stages instead of after the whole startup.
+	bool ret = true;
+	if (!_connection) {
+		setProgress(STG_NOT_STARTED);
+		ret = startConnection();
+	} else {
+		int i = 0;
+		while (i < _numPipelines && _pipelines[i]->isRunning()) {
+			++i;
+		}
+		if (i == _numPipelines) {
+			_starting = false;
+			postEvent(SystemEvent(SystemEvent::EVT_UP));
+			return;
+		}
+		ret = _pipelines[i]->advanceStartup(_connection);
+	}
+
+	if (!ret) {
+		// Failure stage already reported - wait for the user to retry
+		_starting = false;
+	}
+}
+
+
+bool TrackingSystem::startConnection() {
+#ifdef VERBOSE
+	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
+#endif
+	TraceScope scope("start connection");
+	setProgress(STG_CONNECTION_STARTING);
+
+	_connection = new PoseConnection(_listenPort);
+	if (!_connection->doing_okay()) {
+		// error condition creating connection
+		delete _connection;
+		_connection = NULL;
+		setProgress(STG_CONNECTION_FAILED);
+		return false;
+	}
+	_connection->setLatestValue(_latestValue);
+
+	setProgress(STG_CONNECTION_RUNNING);
+	return true;
+}
+
+void TrackingSystem::teardownConnection() {
+#ifdef VERBOSE
+	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
+#endif
+	// Devices first: they are registered on the connection
+	for (int i = 0; i < _numPipelines; ++i) {
+		_pipelines[i]->stop();
+	}
+	if (_connection) {
+		delete _connection;
+		_connection = NULL;
+	}
+}
+
+bool TrackingSystem::applyNewConfiguration(const int pipeline, const TrackerConfiguration & config) {
+	if (!isValidPipeline(pipeline)) {
+		return false;
+	}
+	for (int i = 0; i < _numPipelines; ++i) {
+		if (i != pipeline && _pipelines[i]->getConfiguration().getTrackerName() == config.getTrackerName()) {
+			std::cerr << "Can't rename tracker to " << config.getTrackerName() <<
+				": another pipeline already uses that name" << std::endl;
+			postEvent(SystemEvent(isSystemRunning() ? SystemEvent::EVT_UP : SystemEvent::EVT_DOWN));
+			return false;
+		}
+	}
+
+	postEvent(SystemEvent(SystemEvent::EVT_TRANSITION));
+	const bool ret = _pipelines[pipeline]->applyNewConfiguration(config);
+	if (!isStarting()) {
+		postEvent(SystemEvent(isSystemRunning() ? SystemEvent::EVT_UP : SystemEvent::EVT_DOWN));
+	}
+	return ret;
+}
+
+bool TrackingSystem::isSystemRunning() const {
+#ifdef VERY_VERBOSE
+	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
+#endif
+	if (!_connection || _numPipelines == 0) {
+		return false;
+	}
+	for (int i = 0; i < _numPipelines; ++i) {
+		if (!_pipelines[i]->isRunning()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void TrackingSystem::setSensitivity(const int pipeline, int level) {
+	if (isValidPipeline(pipeline)) {
+		_pipelines[pipeline]->setSensitivity(level);
+	}
+}
@@ -0,0 +1,391 @@
+/** @file	TrackingSystem.h
+	@brief	header for the VRPN tracking pipeline, independent of any GUI
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _TRACKINGSYSTEM_H
+#define _TRACKINGSYSTEM_H
+
+// Internal Includes
+#include "SystemComponents.h"
+#include "TrackerConfiguration.h"
+#include "TrackerPipeline.h"
+#include "SimulatedWiimote.h"
+#include "TrackerReport.h"
+#include "FrameRecorder.h"
+#include "EventLoop.h"
+#include "LoopStatistics.h"
+#include "SpscQueue.h"
+#include "StageMetrics.h"
+#include "TripleBuffer.h"
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+
+// Standard includes
+#include <string>
+#include <vector>
+
+class PoseConnection;
+class vrpn_Thread;
+
+/// @brief Most pipelines one tracking system serves
+#define MAX_PIPELINES 16
+
+/// @brief Request from a front end to the tracking pipeline.
+struct TrackingCommand {
+	enum Type {
+		CMD_START,
+		CMD_STOP,
+		CMD_TEARDOWN,
+		CMD_APPLY_CONFIG,
+		CMD_SET_SENSITIVITY,
+		CMD_START_RECORDING,
+		CMD_STOP_RECORDING,
+		CMD_QUIT
+	};
+
+	TrackingCommand(Type t = CMD_START) :
+			type(t),
+			component(CMP_CONNECTION),
+			pipeline(0),
+			config(),
+			level(0),
+			path(),
+			postedAt(0) {}
+
+	Type type;
+	/// For CMD_TEARDOWN: the component to tear down (with those after it)
+	TrackerComponent component;
+	/// For CMD_TEARDOWN below the connection, CMD_APPLY_CONFIG and
+	/// CMD_SET_SENSITIVITY: which pipeline
+	int pipeline;
+	/// For CMD_APPLY_CONFIG
+	TrackerConfiguration config;
+	/// For CMD_SET_SENSITIVITY
+	int level;
+	/// For CMD_START_RECORDING: the irlog file to write
+	std::string path;
+	/// Monotonic time stamped by postCommand()
+	double postedAt;
+};
+
+/// @brief Status change reported by the tracking pipeline to a front end.
+struct SystemEvent {
+	enum Type {
+		EVT_PROGRESS,
+		EVT_TRANSITION,
+		EVT_UP,
+		EVT_DOWN,
+		/// A pipeline's source (a replay) has sent its last report
+		EVT_SOURCE_FINISHED
+	};
+
+	SystemEvent(Type t = EVT_PROGRESS, StartupStage stg = STG_NOT_STARTED, int pipe = -1) :
+			type(t),
+			stage(stg),
+			pipeline(pipe) {}
+
+	Type type;
+	StartupStage stage;
+	/// For EVT_PROGRESS: the pipeline starting, or -1 for the connection;
+	/// for EVT_SOURCE_FINISHED: the pipeline whose source finished
+	int pipeline;
+};
+
+/// @brief Owns the VRPN connection and the Wiimote to head tracker
+/// pipelines served on it, and drives them all from its own loop - on a
+/// dedicated thread when started with startThread(), or the caller's
+/// thread via runLoop().
+///
+/// Front ends talk to it only through postCommand(), nextEvent() and
+/// latestReport(), so a slow front end can never delay a pose. Poses and
+/// battery levels are tapped from the server devices in-process.
+class TrackingSystem {
+	public:
+		typedef void (*NotifyCallback)(void * userdata);
+
+		TrackingSystem();
+		~TrackingSystem();
+
+		/// @brief Add a pipeline (station) used from the next start - only
+		/// before the loop is running; use CMD_APPLY_CONFIG afterwards.
+		/// Station i serves its source as "WiiMote<i>"; hardware Wiimotes
+		/// are connected in the order their pipelines were added.
+		/// @returns the new pipeline's index, or -1 if there is no room
+		/// or its tracker name is already taken.
+		int addPipeline(const TrackerConfiguration & config,
+			const WiimoteSourceType source = SOURCE_WIIMOTE);
+		int getPipelineCount() const;
+		/// @brief Configuration a pipeline was added with - front ends
+		/// keep their own copy once the loop is running.
+		const TrackerConfiguration & getConfiguration(const int pipeline) const;
+
+		/// @brief Called from the tracking thread whenever there is a new
+		/// event or report to collect - e.g. to wake up a GUI thread.
+		void setNotifyCallback(NotifyCallback cb, void * userdata);
+
+		/// @brief Use the old fixed 1 ms sleep loop instead of waiting
+		/// for input - kept for comparing the two.
+		void usePollingLoop(bool polling);
+
+		/// @brief Receive our own poses and battery levels through VRPN
+		/// remotes on the server connection, like any other client, rather
+		/// than the in-process tap - for diagnosing the VRPN side. Takes
+		/// effect at the next (re)start of the client stage.
+		void useLoopbackClients(bool loopback);
+		bool usingLoopbackClients() const;
+
+		/// @brief Also publish each tracker's poses in shared memory, for
+		/// SharedPoseReader clients on this host. Takes effect at the next
+		/// (re)start of the tracker stage.
+		void useSharedMemory(bool shared);
+		bool usingSharedMemory() const;
+
+		/// @brief Send clients that fall behind only the newest of each
+		/// report, rather than everything they missed - see
+		/// PoseConnection. Takes effect at the next (re)start of the
+		/// connection.
+		void useLatestValue(bool latest);
+		bool usingLatestValue() const;
+
+		/// @brief IR log the SOURCE_REPLAY pipelines play back, each
+		/// the reports recorded for its own station - call before start.
+		/// @param speed Multiple of the recorded pace, or 0 for as fast
+		/// as possible, stamped with the recorded spacing (reproducible
+		/// only with adaptive publication)
+		void setReplay(const std::string & filename, const double speed);
+		const std::string & getReplayFile() const;
+		double getReplaySpeed() const;
+
+		/// @brief Port the server connection listens on, from its next
+		/// start - the VRPN default unless set.
+		void setListenPort(const int port);
+
+		/// @brief How SOURCE_SIMULATED pipelines behave - call before start.
+		void setSimulation(const SimulationParameters & params);
+		const SimulationParameters & getSimulation() const;
+
+		/// @name Threading
+		/// @{
+		bool startThread();
+		/// @brief Ask the loop to quit and wait for the thread to finish.
+		void stopThread();
+		/// @brief Whether the thread from startThread() is still in its
+		/// loop - false once a quit request or startup failure ends it.
+		bool isThreadRunning() const;
+
+		/// @brief Run the loop on the calling thread until CMD_QUIT.
+		void runLoop();
+
+		/// @brief Make the loop return soon - safe to call from any
+		/// thread, or from a signal handler.
+		void requestQuit();
+		/// @}
+
+		/// @name Front end interface
+		/// @{
+		/// @brief Producer side: call from one front-end thread only.
+		void postCommand(const TrackingCommand & cmd);
+
+		/// @brief Consumer side: call from one front-end thread only.
+		bool nextEvent(SystemEvent & evt);
+
+		/// @brief Consumer side: call from one front-end thread only.
+		/// @returns true if report was updated with newer values.
+		bool latestReport(const int pipeline, TrackerReport & report);
+
+		/// @brief Consumer side: call from one front-end thread only.
+		/// A new snapshot is published every second or so.
+		/// @returns true if metrics was updated with newer values.
+		bool latestMetrics(StageMetrics & metrics);
+
+		/// @brief A pipeline's pose at time, in seconds since the epoch
+		/// (as VRPN report times), interpolated from its last
+		/// PoseHistory::CAPACITY poses - safe from any thread.
+		/// @returns false if time is outside the poses held.
+		bool poseAt(const int pipeline, const double time, double pos[3],
+			double quat[4]) const;
+		/// @}
+
+	protected:
+		/// @name VRPN-related methods
+		/// @{
+		void stopTrackerSystem();
+		/// @brief Begin (or resume) startup - advanceStartup() then
+		/// brings up one component per loop pass.
+		void startTrackerSystem(const double requestedAt);
+		void advanceStartup();
+		bool isStarting() const;
+
+		bool startConnection();
+		void teardownConnection();
+		void teardown(const TrackerComponent cmp, const int pipeline);
+
+		bool applyNewConfiguration(const int pipeline, const TrackerConfiguration & config);
+		void setSensitivity(const int pipeline, int level);
+
+		bool isSystemRunning() const;
+		bool isValidPipeline(const int pipeline) const;
+		/// @}
+
+		/// @brief Execute queued commands. @returns false on CMD_QUIT.
+		bool processCommands();
+
+		/// @brief Mainloop all running devices once
+		void serviceDevices();
+
+		/// @brief How long the loop may block before something is due
+		double nextWakeDelay(const struct timeval & now) const;
+
+		/// @brief Have the loop wait on the connection's sockets and,
+		/// where they can be found, connected Wiimotes'
+		void registerDescriptors();
+
+		/// @brief Forget Wiimote sockets the last wait found dead, and
+		/// search for them again
+		void dropFailedDescriptors();
+
+		/// @name Shared services for the pipelines
+		/// @{
+		void postEvent(const SystemEvent & evt);
+		void setProgress(const StartupStage stg);
+		void notify();
+		void recordInput(const struct timeval & inputTime);
+		void recordPublish(const struct timeval & publishTime);
+		/// @returns true for the first pose since launch only
+		bool firstPoseEver();
+		/// @brief Count a duration against a stage's histogram
+		void recordStage(const MetricStage stage, const double seconds);
+		StageMetrics * getStageMetrics();
+		/// @brief Append a raw Wiimote report to the recording, if any
+		void recordFrame(const int pipeline, const struct timeval & time,
+			const double channels[], const int numChannels);
+		/// @}
+		friend class TrackerPipeline;
+
+		/// @name VRPN objects
+		/// @{
+		PoseConnection * _connection;
+		int _listenPort;
+		TrackerPipeline * _pipelines[MAX_PIPELINES];
+		int _numPipelines;
+		/// Hardware Wiimotes among the pipelines
+		unsigned _numWiimotes;
+		bool _loopbackClients;
+		bool _sharedMemory;
+		bool _latestValue;
+		std::string _replayFile;
+		double _replaySpeed;
+		SimulationParameters _simulation;
+		/// @}
+
+		/// @name Hand-off to the front end
+		/// @{
+		SpscQueue<TrackingCommand, 32> _commands;
+		SpscQueue<SystemEvent, 64> _events;
+		NotifyCallback _notify;
+		void * _notifyData;
+		/// @}
+
+		/// @name Startup state machine
+		/// @{
+		bool _starting;
+		bool _firstPoseEver;
+		/// @}
+
+		/// @name Main loop scheduling
+		/// @{
+		EventLoop _loop;
+		LoopStatistics _loopStats;
+		bool _pollingLoop;
+		/// Pipelines whose Wiimotes were connected at the last socket
+		/// search, one bit each, and the sockets it found
+		unsigned long _bluetoothPipelines;
+		std::vector<int> _bluetoothSockets;
+		double _bluetoothSearchedAt;
+		/// @}
+
+		/// Raw report recording, controlled by CMD_START/STOP_RECORDING
+		FrameRecorder _recorder;
+
+		/// @name Stage latency metrics
+		/// @{
+		StageMetrics _metrics;
+		TripleBuffer<StageMetrics> _metricsOut;
+		double _metricsSince;
+		double _metricsPublishedAt;
+		/// Whether poses have been published since the last send
+		bool _posesPending;
+		/// @}
+
+		/// @name Thread management
+		/// @{
+		vrpn_Thread * _thread;
+		volatile long _threadFinished;
+		volatile long _quitRequested;
+		/// @}
+};
+
+// -- inline implementations -- //
+
+inline int TrackingSystem::getPipelineCount() const {
+	return _numPipelines;
+}
+
+inline const TrackerConfiguration & TrackingSystem::getConfiguration(const int pipeline) const {
+	return _pipelines[pipeline]->getConfiguration();
+}
+
+inline bool TrackingSystem::usingLoopbackClients() const {
+	return _loopbackClients;
+}
+
+inline bool TrackingSystem::usingSharedMemory() const {
+	return _sharedMemory;
+}
+
+inline bool TrackingSystem::usingLatestValue() const {
+	return _latestValue;
+}
+
+inline const std::string & TrackingSystem::getReplayFile() const {
+	return _replayFile;
+}
+
+inline double TrackingSystem::getReplaySpeed() const {
+	return _replaySpeed;
+}
+
+inline const SimulationParameters & TrackingSystem::getSimulation() const {
+	return _simulation;
+}
+
+inline void TrackingSystem::recordStage(const MetricStage stage, const double seconds) {
+	_metrics.stages[stage].record(seconds);
+}
+
+inline StageMetrics * TrackingSystem::getStageMetrics() {
+	return &_metrics;
+}
+
+inline bool TrackingSystem::isStarting() const {
+	return _starting;
+}
+
+#endif // _TRACKINGSYSTEM_H
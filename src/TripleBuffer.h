@@ -0,0 +1,85 @@
+/** @file	TripleBuffer.h
+	@brief	header for a lock-free single-producer/single-consumer snapshot
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _TRIPLEBUFFER_H
+#define _TRIPLEBUFFER_H
+
+// Internal Includes
+#include "AtomicOps.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+/// @brief Hands the latest value of T from one thread to another without
+/// locks: neither side ever waits, and the reader always sees a complete value.
+///
+/// The writer fills writeBuffer() and calls publish(); the reader calls
+/// update() and, if it returns true, reads readBuffer().
+template<class T>
+class TripleBuffer {
+	public:
+		TripleBuffer() :
+				_back(0),
+				_middle(1),
+				_front(2) {}
+
+		/// @name Writer side
+		/// @{
+		T & writeBuffer() {
+			return _slots[_back];
+		}
+
+		void publish() {
+			_back = atomic::exchange(&_middle, _back | FRESH) & INDEX_MASK;
+		}
+		/// @}
+
+		/// @name Reader side
+		/// @{
+		/// @returns true if a newer value was published since the last call
+		bool update() {
+			if (!(atomic::load(&_middle) & FRESH)) {
+				return false;
+			}
+			_front = atomic::exchange(&_middle, _front) & INDEX_MASK;
+			return true;
+		}
+
+		const T & readBuffer() const {
+			return _slots[_front];
+		}
+		/// @}
+
+	protected:
+		enum {
+			INDEX_MASK = 0x3,
+			FRESH = 0x4
+		};
+
+		T _slots[3];
+		long _back;
+		volatile long _middle;
+		long _front;
+};
+
+#endif // _TRIPLEBUFFER_H
@@ -0,0 +1,115 @@
+/**	@file	WiimoteDevice.cpp
+	@brief	Implementation of the Wiimote server device with an in-process tap
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "WiimoteDevice.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstddef>
+#include <cstring>
+#ifdef __linux__
+#	include <poll.h>
+#	include <sys/resource.h>
+#	include <sys/socket.h>
+#endif
+
+#ifndef AF_BLUETOOTH
+#	define AF_BLUETOOTH 31
+#endif
+
+/// HID interrupt channel, which Wiimote reports arrive on - the control
+/// channel wiiuse writes to is never read, so must not be waited on.
+const unsigned short HID_INTERRUPT_PSM = 0x13;
+/// Scan no further than this, however high the descriptor limit
+const int MAX_SCANNED_DESCRIPTOR = 4096;
+
+WiimoteDevice::WiimoteDevice(const char * name,
+		vrpn_Connection * c,
+		unsigned which,
+		unsigned useMS,
+		unsigned useIR,
+		unsigned reorderButtons) :
+		vrpn_WiiMote(name, c, which, useMS, useIR, reorderButtons),
+		_observer(NULL) {
+}
+
+void WiimoteDevice::mainloop() {
+	vrpn_WiiMote::mainloop();
+}
+
+void WiimoteDevice::setObserver(TrackerObserver * observer) {
+	_observer = observer;
+}
+
+bool WiimoteDevice::isConnected() const {
+	return isValid();
+}
+
+bool WiimoteDevice::readsBluetooth() const {
+	return true;
+}
+
+vrpn_int32 WiimoteDevice::encode_to(char * buf) {
+	if (_observer) {
+		_observer->wiimoteReported(timestamp, channel, num_channel);
+	}
+	return vrpn_Analog::encode_to(buf);
+}
+
+bool wiimote::findSockets(std::vector<int> & fds) {
+	fds.clear();
+#ifdef __linux__
+	struct rlimit limit;
+	int last = MAX_SCANNED_DESCRIPTOR;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < rlim_t(last)) {
+		last = int(limit.rlim_cur);
+	}
+	for (int fd = 0; fd < last; ++fd) {
+		// sockaddr_l2: family, then the PSM in Bluetooth (little-endian)
+		// byte order
+		struct sockaddr_storage peer;
+		socklen_t size = sizeof(peer);
+		std::memset(&peer, 0, sizeof(peer));
+		if (getpeername(fd, reinterpret_cast<struct sockaddr *>(&peer), &size) != 0 ||
+				peer.ss_family != AF_BLUETOOTH || size < 4) {
+			continue;
+		}
+		const unsigned char * bytes = reinterpret_cast<const unsigned char *>(&peer);
+		const unsigned short psm = (unsigned short)(bytes[2] | (bytes[3] << 8));
+		if (psm != HID_INTERRUPT_PSM) {
+			continue;
+		}
+		// Skip one already hung up: it would wake every poll until
+		// wiiuse gets round to closing it
+		struct pollfd state;
+		state.fd = fd;
+		state.events = POLLIN;
+		state.revents = 0;
+		if (poll(&state, 1, 0) < 0 || (state.revents & (POLLERR | POLLHUP | POLLNVAL))) {
+			continue;
+		}
+		fds.push_back(fd);
+	}
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,79 @@
+/** @file	WiimoteDevice.h
+	@brief	header for the Wiimote server device with an in-process tap
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _WIIMOTEDEVICE_H
+#define _WIIMOTEDEVICE_H
+
+// Internal Includes
+#include "TrackerObserver.h"
+#include "WiimoteSource.h"
+
+// Library/third-party includes
+#include <vrpn_WiiMote.h>
+
+// Standard includes
+#include <vector>
+
+/// @brief vrpn_WiiMote that also hands each analog report it sends to an
+/// in-process TrackerObserver.
+class WiimoteDevice : public vrpn_WiiMote, public WiimoteSource {
+	public:
+		WiimoteDevice(const char * name,
+			vrpn_Connection * c,
+			unsigned which,
+			unsigned useMS,
+			unsigned useIR,
+			unsigned reorderButtons);
+
+		/// @name WiimoteSource interface
+		/// @{
+		virtual void mainloop();
+		virtual void setObserver(TrackerObserver * observer);
+		virtual bool isConnected() const;
+		virtual bool readsBluetooth() const;
+		/// @}
+
+	protected:
+		/// @brief Called by vrpn_Analog for every analog report it sends.
+		virtual vrpn_int32 encode_to(char * buf);
+
+		TrackerObserver * _observer;
+};
+
+namespace wiimote {
+
+/// @addtogroup FreeFunctions Free Functions
+/// @{
+
+	/// @brief Find the sockets wiiuse reads connected Wiimotes' reports
+	/// from, which turn readable as each report arrives.
+	///
+	/// wiiuse keeps them to itself, but on Linux they are the process's
+	/// only L2CAP sockets connected to a HID interrupt channel, so they
+	/// can be told apart from everything else it has open. This scans
+	/// every descriptor: call it when Wiimotes come and go, not per pass.
+	/// @returns false where the platform gives no way to find them.
+	bool findSockets(std::vector<int> & fds);
+
+/// @}
+
+} // end of wiimote namespace
+
+#endif // _WIIMOTEDEVICE_H
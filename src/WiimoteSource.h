@@ -0,0 +1,82 @@
+/** @file	WiimoteSource.h
+	@brief	header for the interface to one pipeline's Wiimote input
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _WIIMOTESOURCE_H
+#define _WIIMOTESOURCE_H
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+// - none
+
+class TrackerObserver;
+struct timeval;
+
+/// @brief A device serving the vrpn_WiiMote analog channel layout under a
+/// VRPN name - a real Wiimote, or something standing in for one - which a
+/// head tracker device reads its IR points from.
+class WiimoteSource {
+	public:
+		/// @brief Analog channel layout of vrpn_WiiMote
+		enum {
+			CHANNEL_BATTERY = 0,
+			/// Three channels, in g
+			CHANNEL_ACCEL = 1,
+			/// x, y and size for each IR point, -1 when not seen
+			CHANNEL_IR = 4,
+			IR_POINTS = 4,
+			CHANNEL_COUNT = 16
+		};
+
+		virtual ~WiimoteSource() {}
+
+		/// @brief Service the device, sending any new reports.
+		virtual void mainloop() = 0;
+
+		/// @brief Set the observer to tap reports, or NULL for none.
+		virtual void setObserver(TrackerObserver * observer) = 0;
+
+		/// @brief Whether reports are (or could be) flowing.
+		virtual bool isConnected() const = 0;
+
+		/// @brief Seconds until the next report is due, for sources that
+		/// know - negative if the loop has to learn it from the reports.
+		virtual double untilNextReport(const struct timeval & /*now*/) const {
+			return -1;
+		}
+
+		/// @brief Whether a source with a finite supply of reports has
+		/// sent the last one.
+		virtual bool isFinished() const {
+			return false;
+		}
+
+		/// @brief Whether reports arrive on the Bluetooth sockets wiiuse
+		/// opens - see wiimote::findSockets().
+		virtual bool readsBluetooth() const {
+			return false;
+		}
+};
+
+#endif // _WIIMOTESOURCE_H
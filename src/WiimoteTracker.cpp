@@ -19,422 +19,297 @@
 // Internal Includes
 #include "WiimoteTracker.h"
 #include "WiimoteTrackerView.h"
+#include "Trace.h"
 
 // Library/third-party includes
-#include <vrpn_Configure.h>
-#include <vrpn_WiiMote.h>
-#include <vrpn_Tracker_WiimoteHead.h>
+#include <FL/Fl.H>
 
 // Standard includes
 #include <cassert>
 #include <iostream>
-#include <sstream>
 #include <fstream>
-#include <iomanip>
 
 #undef VERBOSE
-#undef VERY_VERBOSE
 
-
-const int	CONNECTION_PORT = vrpn_DEFAULT_LISTEN_PORT_NO;  // Port for connection to listen on
-const int	TRACKER_FREQUENCY = 60;
-
-const char * WIIMOTE_NAME = "WiiMote0";
-const char * WIIMOTE_REMOTE_NAME = "*WiiMote0";
-
-/// @name VRPN utility function and callback
-/// @{
-static	double	duration(struct timeval t1, struct timeval t2) {
-	return (t1.tv_usec - t2.tv_usec) / 1000000.0 +
-	       (t1.tv_sec - t2.tv_sec);
-}
-
-static void	VRPN_CALLBACK handle_pos(void* userdata, const vrpn_TRACKERCB t) {
-	static bool first = true;
-	static int count = 0;
-	static struct timeval last_display;
-	if (first) {
-		vrpn_gettimeofday(&last_display, NULL);
-		first = false;
-	}
-	count++;
-	if (count > REPORT_STRIDE) {
-		struct timeval now;
-		vrpn_gettimeofday(&now, NULL);
-		const double interval = duration(now, last_display);
-		const double frequency = count / interval;
-		std::ostringstream pos, rot;
-		pos << "(" << std::fixed << std::setprecision(4) <<
-			t.pos[0] << ", " <<
-			t.pos[1] << ", " <<
-			t.pos[2] << ")";
-		rot << "(" << std::fixed << std::setprecision(3) <<
-			t.quat[0] << ", " <<
-			t.quat[1] << ", " <<
-			t.quat[2] << ", " <<
-			t.quat[3] << ")";
-		static_cast<WiimoteTracker*>(userdata)->setReport(pos.str(), rot.str(), frequency);
-		count = 0;
-		last_display = now;
-	}
+/// @brief Called on the tracking thread: wake up the GUI thread.
+static void wakeView(void *) {
+	Fl::awake();
 }
 
-static void VRPN_CALLBACK handle_wiimote(void* userdata, const vrpn_ANALOGCB a) {
-	static_cast<WiimoteTracker*>(userdata)->setBattery(a.channel[0]);
-}
-/// @}
-
 WiimoteTracker::WiimoteTracker() :
-		_activeConfig(),
-		_connection(NULL),
-		_wiimote(NULL),
-		_tracker(NULL),
-		_client(NULL),
-		_wiimoteClient(NULL),
-		_wiimoteOutClient(NULL),
+		_configs(1),
+		_source(SOURCE_WIIMOTE),
+		_selected(0),
+		_startingStation(0),
+		_system(),
 		_view(new WiimoteTrackerView(this)),
-		_newReport(true),
-		_pos("Report not yet received."),
-		_rot("Report not yet received."),
-		_rate(0),
-		_grabBattery(false),
-		_batLevel(""),
-		_supportsSensitivity(false) {
+		_reports(1),
+		_systemRunning(false),
+		_metrics(),
+		_guiLatency(),
+		_metricsFile() {
 }
 
 WiimoteTracker::~WiimoteTracker() {
-	teardownConnection();
+	_system.stopThread();
+	delete _view;
+	_view = NULL;
 }
 
-bool WiimoteTracker::loadDefaultConfigFile() {
-	if (_connection || _wiimote || _tracker || _client) {
-		std::cerr << "Can't load default config file if system is running!" << std::endl;
+bool WiimoteTracker::loadDefaultConfigFiles() {
+	if (_systemRunning) {
+		std::cerr << "Can't load default config files if system is running!" << std::endl;
 		return false;
 	}
 
-	std::ifstream confFile("default.headtrackconfig");
-	if (!confFile.is_open()) {
-		return false;
-	}
-	TrackerConfiguration newConfig;
-	try {
-		confFile >> newConfig;
-
-		// Can just directly set the _activeConfig since the tracker isn't started yet
-		_activeConfig = newConfig;
-	} catch (std::exception & e) {
-		std::cerr << "Could not load configuration from default.headtrackconfig" << std::endl;
-		std::cerr << "Exception details: " << e.what() << std::endl;
-		return false;
+	bool loaded = false;
+	for (int station = 0; station < getStationCount(); ++station) {
+		// Stations without a file of their own follow the first
+		if (station > 0) {
+			_configs[station] = configurationForStation(_configs[0], station);
+		}
+		const std::string fn = defaultConfigFileName(station);
+		std::ifstream confFile(fn.c_str());
+		if (!confFile.is_open()) {
+			continue;
+		}
+		TrackerConfiguration newConfig;
+		try {
+			confFile >> newConfig;
+
+			// Can just directly set the config since the tracker isn't started yet
+			_configs[station] = newConfig;
+			loaded = true;
+			std::cerr << "Loaded config file " << fn << std::endl;
+		} catch (std::exception & e) {
+			std::cerr << "Could not load configuration from " << fn << std::endl;
+			std::cerr << "Exception details: " << e.what() << std::endl;
+		}
 	}
-	
-	return true;
+	return loaded;
 }
 
 void WiimoteTracker::run() {
+	trace::nameThread("gui");
 	// Set up view
 	_view->run();
 
-	// Attempt to load default config file
-	bool defaultConfLoaded = loadDefaultConfigFile();
-	if (defaultConfLoaded) {
-		std::cerr << "Loaded default config file default.headtrackconfig" << std::endl;
-	} else {
-		std::cerr << "No valid default config file default.headtrackconfig found - using compiled-in defaults." << std::endl;
+	// Attempt to load default config files
+	bool defaultConfLoaded = loadDefaultConfigFiles();
+	if (!defaultConfLoaded) {
+		std::cerr << "No valid default config file " << defaultConfigFileName(0) << " found - using compiled-in defaults." << std::endl;
 	}
-	_view->updateConfigDisplay();
-
-	startTrackerSystem();
 
-	while (_view->processView()) {
-		if (isSystemRunning()) {
-			_wiimote->mainloop();
-			_tracker->mainloop();
-			_connection->mainloop();
+	// Enable FLTK's thread support so the tracking thread can wake us
+	Fl::lock();
+	for (int station = 0; station < getStationCount(); ++station) {
+		if (_system.addPipeline(_configs[station], _source) < 0) {
+			// Most likely two station files with the same tracker name
+			_configs.resize(station);
+			_reports.resize(station);
+			break;
 		}
-		// Sleep for 1ms so we don't eat the CPU
-		vrpn_SleepMsecs(1);
 	}
-}
-
-void WiimoteTracker::stopTrackerSystem() {
-	_view->systemInTransition();
-	teardownConnection();
-
-	// Remove old from screen when shutting down tracker
-	_pos = " ";
-	_rot = " ";
-	_rate = 0;
-	_batLevel = " ";
-	_newReport = true;
-
-	_view->systemIsDown();
-}
-
-void WiimoteTracker::startTrackerSystem() {
-	_view->systemInTransition();
-
-	bool ret;
-	// Create connection
-	if (!_connection) {
-		_view->setProgress(STG_NOT_STARTED);
-		ret = startConnection();
-		if (!ret) {
-			return;
-		}
-	}
-
-	// Start up the wiimote
-	if (!_wiimote) {
-		ret = startWiimoteDevice();
-		if (!ret) {
-			return;
-		}
-	}
-
-	// Start up the tracker
-	if (!_tracker) {
-		ret = startTrackerDevice();
-		if (!ret) {
-			return;
-		}
+	if (_configs.empty()) {
+		return;
 	}
-
-	// Start up the client
-	if (!_client) {
-		ret = startClientDevice();
-		if (!ret) {
-			return;
-		}
+	_view->updateStationList();
+	_view->updateConfigDisplay();
+	_system.setNotifyCallback(&wakeView, this);
+	if (!_system.startThread()) {
+		return;
 	}
-	_view->systemIsUp();
-}
-
 
-bool WiimoteTracker::startConnection() {
-#ifdef VERBOSE
-	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
-#endif
-	_view->setProgress(STG_CONNECTION_STARTING);
+	startTrackerSystem();
 
-	_connection = vrpn_create_server_connection(CONNECTION_PORT);
-	if (!_connection) {
-		// error condition creating connection
-		_view->setProgress(STG_CONNECTION_FAILED);
-		return false;
-	}
+	// Blocks in FLTK until a GUI event arrives or the tracking thread
+	// wakes us with news - tracking carries on regardless.
+	while (_view->processView(true)) {}
 
-	_view->setProgress(STG_CONNECTION_RUNNING);
-	return true;
+	_system.stopThread();
 }
 
+void WiimoteTracker::usePollingLoop(bool polling) {
+	_system.usePollingLoop(polling);
+}
 
-bool WiimoteTracker::startWiimoteDevice() {
-#ifdef VERBOSE
-	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
-#endif
-
-	teardownWiimoteDevice();
-	if (!_connection) {
-		return false;
-	}
-
-	_view->setProgress(STG_WIIMOTE_STARTING);
-	_wiimote = new vrpn_WiiMote(WIIMOTE_NAME, _connection, 0, 1, 1, 1);
-
-	if (!_wiimote) {
-		// error condition creating wiimote
-		_view->setProgress(STG_WIIMOTE_ALLOCATE_FAILED);
-		return false;
-	}
-/*
-	if (!_wiimote->isValid()) {
-		_view->setProgress(STG_WIIMOTE_CONNECT_FAILED);
-		return false;
-	}
-*/
-	_view->setProgress(STG_WIIMOTE_RUNNING);
-	return true;
+void WiimoteTracker::useLoopbackClients(bool loopback) {
+	_system.useLoopbackClients(loopback);
 }
 
-bool WiimoteTracker::startTrackerDevice() {
-#ifdef VERBOSE
-	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
-#endif
-	teardownTrackerDevice();
-	if (!_wiimote || !_connection) {
-		return false;
-	}
-	_view->setProgress(STG_TRACKER_STARTING);
+void WiimoteTracker::useSharedMemory(bool shared) {
+	_system.useSharedMemory(shared);
+}
 
-	_tracker = new vrpn_Tracker_WiimoteHead(_activeConfig.getTrackerName().c_str(),
-			_connection,
-			WIIMOTE_REMOTE_NAME,
-			TRACKER_FREQUENCY,
-			_activeConfig.getLEDDistance());
+void WiimoteTracker::useLatestValue(bool latest) {
+	_system.useLatestValue(latest);
+}
 
-	if (!_tracker) {
-		// error condition creating tracker device
-		_view->setProgress(STG_TRACKER_ALLOCATE_FAILED);
-		return false;
+void WiimoteTracker::setStations(int count, WiimoteSourceType source) {
+	if (count < 1) {
+		count = 1;
+	} else if (count > MAX_PIPELINES) {
+		count = MAX_PIPELINES;
 	}
-
-	_view->setProgress(STG_TRACKER_RUNNING);
-	return true;
+	_configs.resize(count);
+	_reports.resize(count);
+	_source = source;
 }
 
-bool WiimoteTracker::startClientDevice() {
-#ifdef VERBOSE
-	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
-#endif
-
-	teardownClientDevice();
-	if (!_wiimote || !_connection || !_tracker) {
-		return false;
-	}
-	_view->setProgress(STG_CLIENT_STARTING);
+void WiimoteTracker::setReplay(const std::string & filename, double speed) {
+	_system.setReplay(filename, speed);
+}
 
-	_client = new vrpn_Tracker_Remote(_activeConfig.getTrackerName().c_str(),
-			_connection);
+void WiimoteTracker::setSimulation(const SimulationParameters & params) {
+	_system.setSimulation(params);
+}
 
-	if (!_client) {
-		// error condition creating client device
-		_view->setProgress(STG_CLIENT_ALLOCATE_FAILED);
-		return false;
+void WiimoteTracker::selectStation(int station) {
+	if (station >= 0 && station < getStationCount()) {
+		_selected = station;
 	}
+}
 
-	_client->register_change_handler(this, handle_pos);
-
-	_wiimoteClient = new vrpn_Analog_Remote(WIIMOTE_NAME,
-			_connection);
+void WiimoteTracker::stopTrackerSystem() {
+	_view->systemInTransition();
+	_system.postCommand(TrackingCommand(TrackingCommand::CMD_STOP));
+}
 
-	_wiimoteOutClient = new vrpn_Analog_Output_Remote(WIIMOTE_NAME,
-			_connection);
-	if (!_wiimoteClient || ! _wiimoteOutClient) {
-		// error condition creating client devices
-		_view->setProgress(STG_CLIENT_ALLOCATE_FAILED);
-		return false;
-	}
-	_wiimoteClient->register_change_handler(this, handle_wiimote);
-	_supportsSensitivity = (_wiimoteOutClient->getNumChannels() >= 2);
+void WiimoteTracker::startTrackerSystem() {
+	_view->systemInTransition();
+	_system.postCommand(TrackingCommand(TrackingCommand::CMD_START));
+}
 
-	_view->setProgress(STG_CLIENT_RUNNING);
-	return true;
+void WiimoteTracker::teardown(TrackerComponent cmp) {
+	TrackingCommand cmd(TrackingCommand::CMD_TEARDOWN);
+	cmd.component = cmp;
+	cmd.pipeline = _startingStation;
+	_system.postCommand(cmd);
+	_systemRunning = false;
 }
 
 void WiimoteTracker::teardownConnection() {
-#ifdef VERBOSE
-	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
-#endif
-	teardownWiimoteDevice();
-	if (_connection) {
-		delete _connection;
-		_connection = NULL;
-	}
+	teardown(CMP_CONNECTION);
 }
 
 void WiimoteTracker::teardownWiimoteDevice() {
-#ifdef VERBOSE
-	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
-#endif
-	teardownTrackerDevice();
-	if (_wiimote) {
-		delete _wiimote;
-		_wiimote = NULL;
-	}
+	teardown(CMP_WIIMOTE);
 }
 
 void WiimoteTracker::teardownTrackerDevice() {
-#ifdef VERBOSE
-	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
-#endif
-	teardownClientDevice();
-	if (_tracker) {
-		delete _tracker;
-		_tracker = NULL;
-	}
+	teardown(CMP_TRACKER);
 }
 
 void WiimoteTracker::teardownClientDevice() {
-#ifdef VERBOSE
-	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
-#endif
-	if (_client) {
-		delete _client;
-		_client = NULL;
-	}
-	if (_wiimoteClient) {
-		delete _wiimoteClient;
-		_wiimoteClient = NULL;
-	}
-	delete _wiimoteOutClient;
-	_wiimoteOutClient = NULL;
+	teardown(CMP_CLIENT);
 }
 
 bool WiimoteTracker::applyNewConfiguration(const TrackerConfiguration & config) {
-	// If we were running, we will start running again.
-	bool wasRunning(isSystemRunning());
-	_view->systemInTransition();
-	teardownTrackerDevice();
-	_activeConfig = config;
-	if (wasRunning) {
-		bool ret = startTrackerDevice();
-		if (!ret) {
+	for (int station = 0; station < getStationCount(); ++station) {
+		if (station != _selected && _configs[station].getTrackerName() == config.getTrackerName()) {
+			std::cerr << "Another station already serves tracker " << config.getTrackerName() << std::endl;
 			return false;
 		}
-
-		ret = startClientDevice();
-		if (!ret) {
-			return false;
-		}
-
-		_view->systemIsUp();
-	} else {
-		_view->systemIsDown();
 	}
+	_view->systemInTransition();
+	TrackingCommand cmd(TrackingCommand::CMD_APPLY_CONFIG);
+	cmd.pipeline = _selected;
+	cmd.config = config;
+	_system.postCommand(cmd);
+	// Any failure to restart shows up in the startup progress window
+	_configs[_selected] = config;
 	return true;
 }
 
 bool WiimoteTracker::isSystemRunning() const {
-#ifdef VERY_VERBOSE
-	std::cout << "In " << __FILE__ << ":" << __LINE__ << "  " << __FUNCTION__ << std::endl;
-#endif
-	return (_connection && _wiimote && _tracker && _client);
+	return _systemRunning;
 }
 
-bool WiimoteTracker::isWiimoteConnected() {
-	if (_wiimote && _wiimote->isValid()) {
-		return true;
-	} else {
-		_batLevel.clear();
-		return false;
+bool WiimoteTracker::isWiimoteConnected() const {
+	return _systemRunning && _reports[_selected].wiimoteConnected;
+}
+
+bool WiimoteTracker::supportsSensitivityChange() const {
+	return _reports[_selected].supportsSensitivity;
+}
+
+void WiimoteTracker::setSensitivity(int level) {
+	TrackingCommand cmd(TrackingCommand::CMD_SET_SENSITIVITY);
+	cmd.pipeline = _selected;
+	cmd.level = level;
+	_system.postCommand(cmd);
+}
+
+void WiimoteTracker::startRecording(const std::string & filename) {
+	TrackingCommand cmd(TrackingCommand::CMD_START_RECORDING);
+	cmd.path = filename;
+	_system.postCommand(cmd);
+}
+
+void WiimoteTracker::stopRecording() {
+	_system.postCommand(TrackingCommand(TrackingCommand::CMD_STOP_RECORDING));
+}
+
+void WiimoteTracker::processSystemEvents() {
+	SystemEvent evt;
+	while (_system.nextEvent(evt)) {
+		switch (evt.type) {
+			case SystemEvent::EVT_PROGRESS:
+				if (evt.pipeline >= 0) {
+					_startingStation = evt.pipeline;
+				}
+				_view->setProgress(evt.stage, evt.pipeline);
+				break;
+
+			case SystemEvent::EVT_TRANSITION:
+				_systemRunning = false;
+				_view->systemInTransition();
+				break;
+
+			case SystemEvent::EVT_UP:
+				_systemRunning = true;
+				_view->systemIsUp();
+				break;
+
+			case SystemEvent::EVT_DOWN:
+				_systemRunning = false;
+				_view->systemIsDown();
+				break;
+
+			case SystemEvent::EVT_SOURCE_FINISHED:
+				// The last pose stays up until the user stops the tracker
+				break;
+		}
 	}
 }
 
-void WiimoteTracker::setReport(const std::string & pos, const std::string & rot, const double rate) {
-	_pos = pos;
-	_rot = rot;
-	_rate = rate;
-	_newReport = true;
-	_grabBattery = true;
+void WiimoteTracker::setMetricsFile(const std::string & filename) {
+	_metricsFile = filename;
 }
 
-void WiimoteTracker::setBattery(const double batLevel) {
-	if (_grabBattery) {
-		_grabBattery = false;
-		std::ostringstream bat;
-		bat << std::fixed << std::setprecision(1) <<
-			batLevel * 100.0 << "%";
-		_batLevel = bat.str();
+bool WiimoteTracker::updateMetrics() {
+	if (!_system.latestMetrics(_metrics)) {
+		return false;
 	}
+	_metrics.stages[STAGE_GUI] = _guiLatency;
+	if (!_metricsFile.empty() && !metrics::writeFile(_metricsFile, _metrics)) {
+		std::cerr << "Could not write metrics file " << _metricsFile << std::endl;
+		// Once is enough
+		_metricsFile.clear();
+	}
+	return true;
 }
 
-bool WiimoteTracker::supportsSensitivityChange() const {
-	return _supportsSensitivity;
+void WiimoteTracker::recordGuiLatency(const double seconds) {
+	_guiLatency.record(seconds);
 }
 
-void WiimoteTracker::setSensitivity(int level) {
-	if (_supportsSensitivity) {
-		_wiimoteOutClient->request_change_channel_value(1, level);
+bool WiimoteTracker::updateReports() {
+	bool updated = false;
+	for (int station = 0; station < getStationCount(); ++station) {
+		if (_system.latestReport(station, _reports[station])) {
+			updated = true;
+		}
 	}
+	return updated;
 }
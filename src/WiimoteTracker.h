@@ -24,24 +24,20 @@
 // Internal Includes
 #include "SystemComponents.h"
 #include "TrackerConfiguration.h"
+#include "TrackingSystem.h"
+#include "StageMetrics.h"
 
 // Library/third-party includes
 // - none
 
 // Standard includes
 #include <string>
-
-class vrpn_Connection;
-class vrpn_WiiMote;
-class vrpn_Tracker_WiimoteHead;
-class vrpn_Tracker_Remote;
-class vrpn_Analog_Remote;
-class vrpn_Analog_Output_Remote;
+#include <vector>
 
 class WiimoteTrackerView;
 
-#define REPORT_STRIDE 30
-
+/// @brief GUI-side controller: forwards user actions to the tracking
+/// thread and relays its status and reports to the view.
 class WiimoteTracker {
 	public:
 		WiimoteTracker();
@@ -49,73 +45,149 @@ class WiimoteTracker {
 
 		void run();
 
-		/// @name VRPN-related methods
+		/// @brief Use the old fixed 1 ms sleep loop instead of waiting
+		/// for input - kept for comparing the two.
+		void usePollingLoop(bool polling);
+
+		/// @brief Get poses through VRPN remotes instead of the in-process
+		/// tap - for diagnosing the VRPN side.
+		void useLoopbackClients(bool loopback);
+
+		/// @brief Also publish poses in shared memory for clients on this
+		/// host - call before run().
+		void useSharedMemory(bool shared);
+
+		/// @brief Send slow clients only the newest reports - call
+		/// before run().
+		void useLatestValue(bool latest);
+
+		/// @brief Serve count Wiimotes (stations) instead of one, or
+		/// stand-ins for them - call before run().
+		void setStations(int count, WiimoteSourceType source);
+
+		/// @brief IR log to play back with SOURCE_REPLAY - call before run().
+		void setReplay(const std::string & filename, double speed);
+
+		/// @brief How SOURCE_SIMULATED stations behave - call before run().
+		void setSimulation(const SimulationParameters & params);
+
+		/// @name Stations
+		/// @{
+		int getStationCount() const;
+		/// @brief The station the view shows and configures
+		int getSelectedStation() const;
+		void selectStation(int station);
+		const TrackerConfiguration & getConfiguration(int station) const;
+		const TrackerReport & getReport(int station) const;
+		/// @}
+
+		/// @name Tracking system control - requests run on the tracking thread.
+		/// Teardowns below the connection act on the station last seen
+		/// starting up.
 		/// @{
 		void stopTrackerSystem();
 		void startTrackerSystem();
 
-		bool startConnection();
 		void teardownConnection();
-
-		bool startWiimoteDevice();
 		void teardownWiimoteDevice();
-
-		bool startTrackerDevice();
 		void teardownTrackerDevice();
-
-		bool startClientDevice();
 		void teardownClientDevice();
 		/// @}
 
 		bool isSystemRunning() const;
 
-		bool isWiimoteConnected();
+		bool isWiimoteConnected() const;
 
-		bool loadDefaultConfigFile();
+		/// @brief Load each station's default configuration file, if any
+		bool loadDefaultConfigFiles();
+		/// @brief Reconfigure the selected station
 		bool applyNewConfiguration(const TrackerConfiguration & config);
 
 		bool supportsSensitivityChange() const;
 		void setSensitivity(int level);
 
-		/// @brief Function used by the VRPN callback to store periodic data
-		void setReport(const std::string & pos, const std::string & rot, const double rate);
+		/// @name Raw report recording, for later replay
+		/// @{
+		/// @brief Record every station's Wiimote reports to an irlog file
+		void startRecording(const std::string & filename);
+		void stopRecording();
+		/// @}
+
+		/// @brief Pass status changes from the tracking thread on to the view.
+		void processSystemEvents();
 
-		/// @brief Function used by the VRPN callback to store periodic data
-		void setBattery(const double batLevel);
+		/// @brief Collect the latest reports from the tracking thread.
+		/// @returns true if any changed since the last call.
+		bool updateReports();
 
-	protected:
-		/// @name Configuration data
+		/// @name Stage latency metrics
 		/// @{
-		TrackerConfiguration _activeConfig;
+		/// @brief Also write the metrics to filename whenever they're
+		/// updated - call before run().
+		void setMetricsFile(const std::string & filename);
+		/// @brief Collect the tracking thread's latest metrics snapshot,
+		/// adding our own GUI stage. @returns true if it changed.
+		bool updateMetrics();
+		const StageMetrics & getMetrics() const;
+		/// @brief Count the time from a report's publication to its display
+		void recordGuiLatency(const double seconds);
 		/// @}
 
-		/// @name VRPN objects
+	protected:
+		void teardown(TrackerComponent cmp);
+
+		/// @name Configuration data, per station
 		/// @{
-		vrpn_Connection * _connection;
-		vrpn_WiiMote * _wiimote;
-		vrpn_Tracker_WiimoteHead * _tracker;
-		vrpn_Tracker_Remote * _client;
-		vrpn_Analog_Remote * _wiimoteClient;
-		vrpn_Analog_Output_Remote * _wiimoteOutClient;
+		std::vector<TrackerConfiguration> _configs;
+		WiimoteSourceType _source;
+		int _selected;
+		/// Station whose startup progress is being shown
+		int _startingStation;
 		/// @}
 
+		/// @brief The tracking pipeline, run on its own thread
+		TrackingSystem _system;
+
 		/// @brief Pointer to view
 		WiimoteTrackerView * _view;
 
-		/// @name Data from selected reports, to display
+		/// @name Latest state received from the tracking thread
 		/// @{
-		bool _newReport;
-		std::string _pos;
-		std::string _rot;
-		float _rate;
-
-		bool _grabBattery;
-		std::string _batLevel;
+		std::vector<TrackerReport> _reports;
+		bool _systemRunning;
+		StageMetrics _metrics;
 		/// @}
 
-		bool _supportsSensitivity;
+		/// @name Our own stage timing, and where metrics go
+		/// @{
+		LatencyHistogram _guiLatency;
+		std::string _metricsFile;
+		/// @}
 
 		/// @todo Remove this once configuration adjustment is improved.
 		friend class WiimoteTrackerView;
 };
+
+// -- inline implementations -- //
+
+inline const StageMetrics & WiimoteTracker::getMetrics() const {
+	return _metrics;
+}
+
+inline int WiimoteTracker::getStationCount() const {
+	return int(_configs.size());
+}
+
+inline int WiimoteTracker::getSelectedStation() const {
+	return _selected;
+}
+
+inline const TrackerConfiguration & WiimoteTracker::getConfiguration(int station) const {
+	return _configs[station];
+}
+
+inline const TrackerReport & WiimoteTracker::getReport(int station) const {
+	return _reports[station];
+}
+
 #endif // WIIMOTETRACKER
@@ -20,6 +20,8 @@
 #include "WiimoteTrackerView.h"
 
 #include "WiimoteTracker.h"
+#include "MonotonicClock.h"
+#include "Trace.h"
 
 #include <WiimoteTrackerGUI.h>
 
@@ -32,6 +34,7 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <iomanip>
 
 WiimoteTrackerView::WiimoteTrackerView(WiimoteTracker * controller) :
 		_progress(new StartupProgress(430,360, "Starting Tracking System...")),
@@ -39,7 +42,10 @@ WiimoteTrackerView::WiimoteTrackerView(WiimoteTracker * controller) :
 		_gui(new WiimoteTrackerGUI(520, 560, "Wii Remote Head Tracker")),
 		_fc(NULL),
 		_controller(controller),
-		_wmConnected(false) {
+		_wmConnected(false),
+		_reportText(),
+		_reportDirty(true),
+		_shownPublishedAt(0) {
 	assert(_progress);
 	assert(_config);
 	assert(_gui);
@@ -88,11 +94,24 @@ WiimoteTrackerView::~WiimoteTrackerView() {
 void WiimoteTrackerView::applyNewConfiguration() {
 	std::string trackerName = _config->_trackerName->value();
 	float distanceInMeters = _config->_ledDistance->value() / 100.0;
+	float publishRate = _config->_publishRate->value();
+	bool adaptive = (_config->_adaptivePublish->value() != 0);
+	float predictionHorizon = _config->_predictionHorizon->value();
+	PredictionModel predictionModel = (_config->_predictAcceleration->value() != 0) ?
+		PREDICT_CONSTANT_ACCELERATION : PREDICT_CONSTANT_VELOCITY;
+	const TrackerConfiguration & current = _controller->getConfiguration(_controller->getSelectedStation());
+	FilterParameters smoothing = current.getSmoothing();
+	smoothing.minCutoff = _config->_smoothingCutoff->value();
+	smoothing.positionBeta = _config->_smoothingPositionBeta->value();
+	smoothing.orientationBeta = _config->_smoothingOrientationBeta->value();
 	TrackerConfiguration newConfig;
 	try {
-		newConfig = TrackerConfiguration(distanceInMeters, trackerName);
+		newConfig = TrackerConfiguration(distanceInMeters, trackerName, publishRate, adaptive,
+			predictionHorizon, predictionModel, smoothing, current.getCoastTime(),
+			current.getConstellation(), current.getTransport(),
+			current.getDisplayPeriod(), current.getDisplayPhase());
 	} catch (std::exception & e) {
-		std::cerr << "Could not create new configuration with parameters " << distanceInMeters << " and '" << trackerName << "'" << std::endl;
+		std::cerr << "Could not create new configuration with parameters " << distanceInMeters << ", '" << trackerName << "' and " << publishRate << " Hz" << std::endl;
 		std::cerr << "Exception details: " << e.what() << std::endl;
 		updateConfigDisplay();
 		return;
@@ -154,9 +173,17 @@ void WiimoteTrackerView::setProgressRanges() {
 	_progress->_clientProgress->maximum(1.0);
 }
 
-void WiimoteTrackerView::setProgress(const StartupStage stg) {
+void WiimoteTrackerView::setProgress(const StartupStage stg, const int station) {
 	_progress->show();
 
+	if (station >= 0 && _controller->getStationCount() > 1) {
+		// Bars below the connection are for one station at a time
+		std::ostringstream s;
+		s << "Starting " << _controller->getConfiguration(station).getTrackerName() <<
+			" (station " << station + 1 << " of " << _controller->getStationCount() << ")...";
+		_progress->copy_label(s.str().c_str());
+	}
+
 	// Use switch statement and intentional fall-through to
 	// reset all later components to "not started"
 	switch (stg) {
@@ -248,7 +275,8 @@ void WiimoteTrackerView::setProgress(const StartupStage stg) {
 			setProgress(CMP_CLIENT, 1.0, "Running");
 			break;
 	}
-	mainloop_ui(PROGRESS_EVENT_TIMEOUT);
+	// No waiting here: the widgets redraw on the next pass of the view's
+	// event loop, while the tracking thread carries on starting up.
 }
 
 void WiimoteTrackerView::setProgress(const TrackerComponent cmp, const double completion, const char * message, bool fail) {
@@ -310,16 +338,38 @@ void WiimoteTrackerView::systemInTransition() {
 }
 
 void WiimoteTrackerView::updateConfigDisplay() {
+	const TrackerConfiguration & active = _controller->getConfiguration(_controller->getSelectedStation());
+
 	/// Update config window
-	_config->_trackerName->value(_controller->_activeConfig.getTrackerName().c_str());
-	_config->_ledDistance->value(_controller->_activeConfig.getLEDDistance() * 100.0);
+	_config->_trackerName->value(active.getTrackerName().c_str());
+	_config->_ledDistance->value(active.getLEDDistance() * 100.0);
+	_config->setPublication(active.getPublishRate(), active.getAdaptivePublish());
+	_config->setPrediction(active.getPredictionHorizon(),
+		active.getPredictionModel() == PREDICT_CONSTANT_ACCELERATION);
+	const FilterParameters & smoothing = active.getSmoothing();
+	_config->setSmoothing(smoothing.minCutoff, smoothing.positionBeta, smoothing.orientationBeta);
 
 	_config->_apply->deactivate();
 	_config->_save->activate();
 
 	/// Update main window
-	_gui->_trackerName->value(_controller->_activeConfig.getTrackerName().c_str());
-	_gui->_ledDistance->value(_controller->_activeConfig.getLEDDistance() * 100.0);
+	_gui->_trackerName->value(active.getTrackerName().c_str());
+	_gui->_ledDistance->value(active.getLEDDistance() * 100.0);
+	char publication[64];
+	int len = REPORT_SNPRINTF(publication, sizeof(publication),
+		active.getAdaptivePublish() ? "Each IR frame, or %g Hz" : "Fixed %g Hz",
+		active.getPublishRate());
+	if (active.getPredictionHorizon() > 0 && len > 0 && len < int(sizeof(publication))) {
+		// Predicted pose goes out as sensor 1
+		const int more = REPORT_SNPRINTF(publication + len, sizeof(publication) - len, ", +%g ms",
+			active.getPredictionHorizon());
+		len = (more < 0) ? -1 : len + more;
+	}
+	if (active.getSmoothing().enabled() && len > 0 && len < int(sizeof(publication))) {
+		REPORT_SNPRINTF(publication + len, sizeof(publication) - len, ", smoothed");
+	}
+	publication[sizeof(publication) - 1] = '\0';
+	_gui->_publication->value(publication);
 	
 	refresh_ui();
 }
@@ -329,7 +379,8 @@ void WiimoteTrackerView::saveConfig() {
 	_fc = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
 	_fc->title("Save Wii Remote Head Tracker Config File...");
 	_fc->filter("Head Tracker Config Files\t*.headtrackconfig");
-	_fc->preset_file("default.headtrackconfig");
+	const std::string presetFile = defaultConfigFileName(_controller->getSelectedStation());
+	_fc->preset_file(presetFile.c_str());
 	int ret = _fc->show();
 	if (ret != 0) {
 		// No file picked, for one reason or another.
@@ -341,10 +392,50 @@ void WiimoteTrackerView::saveConfig() {
 		fl_alert("Could not save configuration to file %s - perhaps try another file name or location", _fc->filename());
 		return;
 	}
-	confFile << _controller->_activeConfig;
+	confFile << _controller->getConfiguration(_controller->getSelectedStation());
 	confFile.close();
 }
 
+void WiimoteTrackerView::startRecording() {
+	delete _fc;
+	_fc = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
+	_fc->title("Record Raw Wii Remote Reports To...");
+	_fc->filter("Wii Remote IR Logs\t*.irlog");
+	_fc->preset_file("recording.irlog");
+	int ret = _fc->show();
+	if (ret != 0) {
+		// No file picked, for one reason or another.
+		return;
+	}
+	_controller->startRecording(_fc->filename());
+}
+
+void WiimoteTrackerView::stopRecording() {
+	_controller->stopRecording();
+}
+
+void WiimoteTrackerView::writeTrace() {
+	if (!trace::enabled()) {
+		if (trace::start()) {
+			fl_message("Tracing started - choose Write trace again to save what has been recorded.");
+		}
+		return;
+	}
+	delete _fc;
+	_fc = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
+	_fc->title("Save Chrome Trace...");
+	_fc->filter("Chrome Trace Files\t*.json");
+	_fc->preset_file("trace.json");
+	int ret = _fc->show();
+	if (ret != 0) {
+		// No file picked, for one reason or another.
+		return;
+	}
+	if (!trace::writeFile(_fc->filename())) {
+		fl_alert("Could not save the trace to file %s - perhaps try another file name or location", _fc->filename());
+	}
+}
+
 void WiimoteTrackerView::openConfig() {
 	delete _fc;
 	_fc = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_FILE);
@@ -378,13 +469,115 @@ void WiimoteTrackerView::openConfig() {
 	updateConfigDisplay();
 }
 
+void WiimoteTrackerView::selectStation(int station) {
+	_controller->selectStation(station);
+	_reportDirty = true;
+	updateReportDisplay();
+	_wmConnected = _controller->isWiimoteConnected();
+	_gui->updateWiimoteStatus(_wmConnected);
+	updateConfigDisplay();
+}
+
+void WiimoteTrackerView::updateStationList() {
+	Fl_Browser * list = _gui->_stations;
+	const int count = _controller->getStationCount();
+	ReportText text;
+	for (int station = 0; station < count; ++station) {
+		text.formatSummary(_controller->getReport(station),
+			_controller->getConfiguration(station).getTrackerName().c_str());
+		if (station < list->size()) {
+			list->text(station + 1, text.summary);
+		} else {
+			list->add(text.summary);
+		}
+	}
+	if (list->value() == 0) {
+		list->select(_controller->getSelectedStation() + 1);
+	}
+}
+
+void WiimoteTrackerView::updateReportDisplay() {
+	if (!_reportDirty || !_gui->visible()) {
+		// Nothing new, or nobody to see it: format when it can be shown
+		return;
+	}
+	const TrackerReport & r = _controller->getReport(_controller->getSelectedStation());
+	_reportText.format(r, _controller->isSystemRunning() ? "Report not yet received." : " ");
+	_gui->_rate->value(_reportText.rate);
+	_gui->_gaps->value(_reportText.gaps);
+	_gui->_poseAge->value(_reportText.poseAge);
+	_gui->_pos->value(_reportText.pos);
+	_gui->_rot->value(_reportText.rot);
+	_gui->_bat->value(_reportText.battery);
+	_reportDirty = false;
+
+	if (r.publishedAt > 0 && r.publishedAt != _shownPublishedAt) {
+		_shownPublishedAt = r.publishedAt;
+		_controller->recordGuiLatency(monotonic::seconds() - r.publishedAt);
+	}
+}
+
+void WiimoteTrackerView::updateDiagnostics() {
+	Fl_Browser * table = _gui->_diagnostics;
+	const StageMetrics & m = _controller->getMetrics();
+	if (table->size() == 0) {
+		table->add("@bStage\t@bCount\t@bp50 ms\t@bp99 ms\t@bp99.9 ms\t@bMax ms");
+	}
+	for (int s = 0; s < STAGE_COUNT; ++s) {
+		const LatencyHistogram & h = m.stages[s];
+		std::ostringstream row;
+		row << metrics::stageName(MetricStage(s)) << "\t" << h.getCount() << "\t" <<
+			std::fixed << std::setprecision(3) <<
+			h.getPercentile(0.5) * 1000.0 << "\t" <<
+			h.getPercentile(0.99) * 1000.0 << "\t" <<
+			h.getPercentile(0.999) * 1000.0 << "\t" <<
+			h.getMax() * 1000.0;
+		if (s + 2 <= table->size()) {
+			table->text(s + 2, row.str().c_str());
+		} else {
+			table->add(row.str().c_str());
+		}
+	}
+
+	// Then a row per connected client, for its send waits
+	int line = STAGE_COUNT + 2;
+	for (int c = 0; c < StageMetrics::CLIENTS; ++c) {
+		const ClientDelivery & d = m.clients[c];
+		if (!d.connected) {
+			continue;
+		}
+		const LatencyHistogram & h = d.sendLatency;
+		std::ostringstream row;
+		row << "client " << c << " (" << d.superseded << " superseded, " <<
+			d.queueDepth << " B queued)\t" << d.delivered << "\t" <<
+			std::fixed << std::setprecision(3) <<
+			h.getPercentile(0.5) * 1000.0 << "\t" <<
+			h.getPercentile(0.99) * 1000.0 << "\t" <<
+			h.getPercentile(0.999) * 1000.0 << "\t" <<
+			h.getMax() * 1000.0;
+		if (line <= table->size()) {
+			table->text(line, row.str().c_str());
+		} else {
+			table->add(row.str().c_str());
+		}
+		line++;
+	}
+	while (table->size() >= line) {
+		table->remove(table->size());
+	}
+}
+
 bool WiimoteTrackerView::processView(bool wait) {
-	if (_controller->_newReport) {
-		_gui->_bat->value(_controller->_batLevel.c_str());
-		_gui->_pos->value(_controller->_pos.c_str());
-		_gui->_rot->value(_controller->_rot.c_str());
-		_gui->_rate->value(_controller->_rate);
-		_controller->_newReport = false;
+	TraceScope scope("processView");
+	// Collect the report first: status events may depend on it.
+	if (_controller->updateReports()) {
+		_reportDirty = true;
+		updateStationList();
+	}
+	_controller->processSystemEvents();
+	updateReportDisplay();
+	if (_controller->updateMetrics()) {
+		updateDiagnostics();
 	}
 	bool currentConnectStatus = _controller->isWiimoteConnected();
 	if (currentConnectStatus != _wmConnected) {
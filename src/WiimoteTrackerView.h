@@ -23,6 +23,7 @@
 
 // Internal Includes
 #include "SystemComponents.h"
+#include "ReportText.h"
 
 // Library/third-party includes
 // - none
@@ -54,7 +55,8 @@ class WiimoteTrackerView {
 
 		/// @name System status signals
 		/// @{
-		void setProgress(const StartupStage stg);
+		/// @param station The station starting, or -1 for the connection
+		void setProgress(const StartupStage stg, const int station = -1);
 		void setProgress(const TrackerComponent cmp, const double completion, const char * message, bool fail = false);
 
 		void systemIsDown();
@@ -75,10 +77,34 @@ class WiimoteTrackerView {
 		void openConfig();
 		/// @}
 
+		/// @name Raw report recording
+		/// @{
+		void startRecording();
+		void stopRecording();
+		/// @}
+
+		/// @brief Start tracing, or if it is on, save the trace so far
+		void writeTrace();
+
+		/// @name Stations
+		/// @{
+		/// @brief Show and configure a different station
+		void selectStation(int station);
+		/// @brief Refresh the one-line status of every station
+		void updateStationList();
+		/// @}
+
+		/// @brief Refresh the stage latency table on the Diagnostics tab
+		void updateDiagnostics();
+
 		/// @brief Call to event loop, non-blocking by default
 		bool processView(bool wait = false);
 
 	protected:
+		/// @brief Show the controller's latest report values, if changed
+		/// and visible
+		void updateReportDisplay();
+
 		/// @name GUI windows
 		/// @{
 		StartupProgress * _progress;
@@ -92,6 +118,14 @@ class WiimoteTrackerView {
 
 		/// What we think is the latest connection status
 		bool _wmConnected;
+
+		/// @name Report display text, formatted only when shown
+		/// @{
+		ReportText _reportText;
+		bool _reportDirty;
+		/// Publication time of the report last shown, to time each once
+		double _shownPublishedAt;
+		/// @}
 };
 
 #endif // _WIIMOTETRACKERVIEW_H
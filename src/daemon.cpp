@@ -0,0 +1,544 @@
+/** @file	daemon.cpp
+	@brief	Main entry point for the headless (no GUI) Wii Remote head tracker
+
+	Runs the same connection/Wiimote/tracker pipeline as the GUI app,
+	configured from the command line and/or a .headtrackconfig file.
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+*/
+/*
+	Copyright Iowa State University 2009-2011
+	Distributed under the Boost Software License, Version 1.0.
+	(See accompanying file LICENSE_1_0.txt or copy at
+	http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "TrackingSystem.h"
+#include "TrackerConfiguration.h"
+#include "FromString.h"
+#include "Trace.h"
+
+#include <vrpn_Connection.h>
+#include <vrpn_Shared.h>
+
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+static TrackingSystem * g_system = NULL;
+static int g_exitCode = 0;
+static bool g_verbose = false;
+/// Replayed stations still sending, when replaying a log
+static int g_replaying = 0;
+/// Where to write stage latency metrics, if anywhere
+static std::string g_metricsFile;
+/// How often the main thread collects events, reports and metrics
+static const double STATUS_INTERVAL = 0.05;
+
+static void handleSignal(int) {
+	if (g_system) {
+		g_system->requestQuit();
+	}
+}
+
+static const char * describeStage(const StartupStage stg) {
+	switch (stg) {
+		case STG_NOT_STARTED:				return "Starting tracking system";
+		case STG_CONNECTION_STARTING:		return "Creating server connection...";
+		case STG_CONNECTION_FAILED:			return "Could not create server connection";
+		case STG_CONNECTION_RUNNING:		return "Server connection running";
+		case STG_WIIMOTE_STARTING:			return "Connecting to Wiimote - press 1 and 2 on the Wiimote now";
+		case STG_WIIMOTE_ALLOCATE_FAILED:	return "Could not allocate Wiimote device";
+		case STG_WIIMOTE_CONNECT_FAILED:	return "Could not connect to a Wiimote";
+		case STG_WIIMOTE_RUNNING:			return "Wiimote device running";
+		case STG_TRACKER_STARTING:			return "Creating tracker device...";
+		case STG_TRACKER_ALLOCATE_FAILED:	return "Could not allocate tracker device";
+		case STG_TRACKER_RUNNING:			return "Tracker device running";
+		case STG_CLIENT_STARTING:			return "Starting client device...";
+		case STG_CLIENT_ALLOCATE_FAILED:	return "Could not allocate client device";
+		case STG_CLIENT_RUNNING:			return "Client device running";
+		case STG_STARTUP_COMPLETE:			return "Startup complete";
+	}
+	return "Unknown startup stage";
+}
+
+static bool isFailure(const StartupStage stg) {
+	return stg == STG_CONNECTION_FAILED ||
+		stg == STG_WIIMOTE_ALLOCATE_FAILED ||
+		stg == STG_WIIMOTE_CONNECT_FAILED ||
+		stg == STG_TRACKER_ALLOCATE_FAILED ||
+		stg == STG_CLIENT_ALLOCATE_FAILED;
+}
+
+/// @brief Drain and print whatever the tracking thread has for us, and
+/// write the metrics file - on the main thread, so neither the console
+/// nor the disk can hold up a pose.
+static void printStatus(TrackingSystem * system) {
+	SystemEvent evt;
+	while (system->nextEvent(evt)) {
+		switch (evt.type) {
+			case SystemEvent::EVT_PROGRESS:
+				if (evt.pipeline >= 0) {
+					std::cout << system->getConfiguration(evt.pipeline).getTrackerName() << ": ";
+				}
+				std::cout << describeStage(evt.stage) << std::endl;
+				if (isFailure(evt.stage)) {
+					// Let a supervisor restart us rather than sit half-started
+					g_exitCode = 1;
+					system->requestQuit();
+				}
+				break;
+
+			case SystemEvent::EVT_UP:
+				std::cout << "Tracking system running" << std::endl;
+				break;
+
+			case SystemEvent::EVT_DOWN:
+				std::cout << "Tracking system stopped" << std::endl;
+				break;
+
+			case SystemEvent::EVT_TRANSITION:
+				break;
+
+			case SystemEvent::EVT_SOURCE_FINISHED:
+				// A replay is a batch job: done when every station is
+				if (g_replaying > 0 && --g_replaying == 0) {
+					system->requestQuit();
+				}
+				break;
+		}
+	}
+
+	// The loop publishes metrics once a second: print poses as often
+	StageMetrics metrics;
+	if (!system->latestMetrics(metrics)) {
+		return;
+	}
+	if (!g_metricsFile.empty()) {
+		if (!metrics::writeFile(g_metricsFile, metrics)) {
+			std::cerr << "Could not write metrics file " << g_metricsFile << std::endl;
+			g_metricsFile.clear();
+		}
+	}
+
+	TrackerReport report;
+	for (int i = 0; i < system->getPipelineCount(); ++i) {
+		if (system->latestReport(i, report) && g_verbose && report.hasPose) {
+			std::cout << system->getConfiguration(i).getTrackerName() << ": " <<
+				std::fixed << std::setprecision(4) <<
+				"(" << report.pos[0] << ", " << report.pos[1] << ", " << report.pos[2] << ") " <<
+				std::setprecision(3) <<
+				"(" << report.quat[0] << ", " << report.quat[1] << ", " <<
+				report.quat[2] << ", " << report.quat[3] << ") " <<
+				std::setprecision(1) << report.rate << " Hz, gap " <<
+				std::setprecision(2) << report.minGap * 1000.0 << "-" <<
+				report.maxGap * 1000.0 << " ms (std. dev. " <<
+				report.gapStdDev * 1000.0 << " ms), " <<
+				report.droppedFrames << " dropped, pose age " <<
+				std::setprecision(1) << report.poseAge * 1000.0 << " ms, confidence " <<
+				std::setprecision(2) << report.confidence << std::endl;
+		}
+	}
+}
+
+static void usage(const char * argv0) {
+	std::cerr << "Usage: " << argv0 << " [options]" << std::endl <<
+		"  --config FILE          Load configuration from FILE" << std::endl <<
+		"                         (default: default.headtrackconfig, if present)" << std::endl <<
+		"  --led-distance METERS  Distance between the LEDs" << std::endl <<
+		"  --tracker-name NAME    VRPN name to serve the tracker under" << std::endl <<
+		"  --publish-rate HZ      Poses per second to send (keep-alive rate with --adaptive)" << std::endl <<
+		"  --adaptive             Publish each IR frame as soon as it arrives" << std::endl <<
+		"  --predict MS           Also publish the pose predicted MS ahead, as sensor 1" << std::endl <<
+		"  --predict-acceleration Predict with constant acceleration (default: velocity)" << std::endl <<
+		"  --smoothing HZ         Smooth poses, with cutoff HZ at rest (0 = off)" << std::endl <<
+		"  --smoothing-position-beta N" << std::endl <<
+		"  --smoothing-orientation-beta N" << std::endl <<
+		"                         How quickly smoothing backs off with head speed" << std::endl <<
+		"  --constellation FILE   Solve full 6-DOF pose from 3 or 4 LEDs, one \"x y z\" per" << std::endl <<
+		"                         line of FILE, in meters (see src/LedConstellation.h)" << std::endl <<
+		"  --coast MS             Carry the pose on through LED occlusions up to MS long" << std::endl <<
+		"                         before holding it (default 250, 0 = hold at once)" << std::endl <<
+		"  --transport MODE       Send poses reliable (TCP only), unreliable (UDP where" << std::endl <<
+		"                         the client has it, Nagle off on TCP) or default" << std::endl <<
+		"  --socket-buffer KB     Kernel send buffer for each client socket (0 = system's)" << std::endl <<
+		"  --display-period MS    Publish just before each deadline of a display" << std::endl <<
+		"                         refreshing every MS (e.g. 16.667), predicted to it" << std::endl <<
+		"  --display-phase MS     Where deadlines fall in the display period, on the" << std::endl <<
+		"                         system clock (default 0)" << std::endl <<
+		"  --stations N           Serve N Wiimotes, as trackers named like the first" << std::endl <<
+		"                         with the station number (1-" << MAX_PIPELINES << ", default 1);" << std::endl <<
+		"                         station N > 0 loads stationN.headtrackconfig if present" << std::endl <<
+		"  --simulate             Use simulated Wiimotes - no hardware needed" << std::endl <<
+		"  --sim-rate HZ          Simulated IR frame rate (default 100, up to " <<
+		SimulationParameters::MAX_FRAME_RATE << ")" << std::endl <<
+		"  --sim-noise PIXELS     Standard deviation of simulated blob positions" << std::endl <<
+		"  --sim-dropout P        Chance of each simulated LED going unseen (0-1)" << std::endl <<
+		"  --sim-trajectory FILE  Move the simulated head along a keyframe script" << std::endl <<
+		"  --replay FILE          Play back the reports recorded in FILE (an irlog)" << std::endl <<
+		"                         instead, and exit at its end" << std::endl <<
+		"  --replay-speed N       Replay at N times the recorded pace (default 1);" << std::endl <<
+		"                         0 = as fast as possible, with the recorded spacing" << std::endl <<
+		"                         (use --adaptive for the same poses every run)" << std::endl <<
+		"  --record FILE          Record raw Wiimote reports to FILE (an irlog)" << std::endl <<
+		"  --port N               Listen for VRPN clients on port N (default " <<
+		vrpn_DEFAULT_LISTEN_PORT_NO << ")" << std::endl <<
+		"  --shared-memory        Also publish poses in shared memory for clients on" << std::endl <<
+		"                         this host (see src/SharedPoseReader.h)" << std::endl <<
+		"  --latest-value         Send clients that fall behind only the newest" << std::endl <<
+		"                         poses, not everything they missed" << std::endl <<
+		"  --poll-loop            Use the fixed 1 ms sleep main loop" << std::endl <<
+		"  --loopback-client      Watch poses through a VRPN client on our own" << std::endl <<
+		"                         connection instead of the in-process tap" << std::endl <<
+		"  --trace FILE           Record a Chrome trace of the main loop, written" << std::endl <<
+		"                         to FILE at exit" << std::endl <<
+		"  --metrics FILE         Write stage latency histograms to FILE every second" << std::endl <<
+		"  --verbose              Print periodic pose reports" << std::endl;
+}
+
+static bool loadConfig(const std::string & fn, TrackerConfiguration & config) {
+	std::ifstream confFile(fn.c_str());
+	if (!confFile.is_open()) {
+		return false;
+	}
+	try {
+		confFile >> config;
+	} catch (std::exception & e) {
+		std::cerr << "Could not load configuration from " << fn << std::endl;
+		std::cerr << "Exception details: " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	std::string configFile;
+	std::string trackerName;
+	float ledDistance = 0;
+	float publishRate = 0;
+	bool adaptive = false;
+	float predictionHorizon = -1;
+	bool predictAcceleration = false;
+	float smoothingCutoff = -1;
+	float positionBeta = -1;
+	float orientationBeta = -1;
+	float coastTime = -1;
+	std::string constellationFile;
+	std::string transportMode;
+	int socketBuffer = -1;
+	float displayPeriod = -1;
+	float displayPhase = -1;
+	int stations = 1;
+	bool simulate = false;
+	SimulationParameters simulation;
+	std::string replayFile;
+	float replaySpeed = 1;
+	std::string recordFile;
+	int port = vrpn_DEFAULT_LISTEN_PORT_NO;
+	std::string traceFile;
+	bool pollingLoop = false;
+	bool loopbackClients = false;
+	bool sharedMemory = false;
+	bool latestValue = false;
+
+	for (int i = 1; i < argc; ++i) {
+		const bool haveValue = (i + 1 < argc);
+		if (std::strcmp(argv[i], "--config") == 0 && haveValue) {
+			configFile = argv[++i];
+		} else if (std::strcmp(argv[i], "--led-distance") == 0 && haveValue) {
+			if (!fromString<float>(ledDistance, argv[++i])) {
+				std::cerr << "Invalid LED distance: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--tracker-name") == 0 && haveValue) {
+			trackerName = argv[++i];
+		} else if (std::strcmp(argv[i], "--publish-rate") == 0 && haveValue) {
+			if (!fromString<float>(publishRate, argv[++i])) {
+				std::cerr << "Invalid publication rate: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--adaptive") == 0) {
+			adaptive = true;
+		} else if (std::strcmp(argv[i], "--predict") == 0 && haveValue) {
+			if (!fromString<float>(predictionHorizon, argv[++i])) {
+				std::cerr << "Invalid prediction horizon: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--predict-acceleration") == 0) {
+			predictAcceleration = true;
+		} else if (std::strcmp(argv[i], "--smoothing") == 0 && haveValue) {
+			if (!fromString<float>(smoothingCutoff, argv[++i])) {
+				std::cerr << "Invalid smoothing cutoff: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--smoothing-position-beta") == 0 && haveValue) {
+			if (!fromString<float>(positionBeta, argv[++i])) {
+				std::cerr << "Invalid position smoothing coefficient: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--smoothing-orientation-beta") == 0 && haveValue) {
+			if (!fromString<float>(orientationBeta, argv[++i])) {
+				std::cerr << "Invalid orientation smoothing coefficient: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--constellation") == 0 && haveValue) {
+			constellationFile = argv[++i];
+		} else if (std::strcmp(argv[i], "--coast") == 0 && haveValue) {
+			if (!fromString<float>(coastTime, argv[++i])) {
+				std::cerr << "Invalid coast time: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--transport") == 0 && haveValue) {
+			transportMode = argv[++i];
+			if (transportMode != "default" && transportMode != "reliable" &&
+					transportMode != "unreliable") {
+				std::cerr << "Invalid transport: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--socket-buffer") == 0 && haveValue) {
+			if (!fromString<int>(socketBuffer, argv[++i]) || socketBuffer < 0) {
+				std::cerr << "Invalid socket buffer size: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--display-period") == 0 && haveValue) {
+			if (!fromString<float>(displayPeriod, argv[++i])) {
+				std::cerr << "Invalid display period: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--display-phase") == 0 && haveValue) {
+			if (!fromString<float>(displayPhase, argv[++i])) {
+				std::cerr << "Invalid display phase: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--stations") == 0 && haveValue) {
+			if (!fromString<int>(stations, argv[++i]) || stations < 1 || stations > MAX_PIPELINES) {
+				std::cerr << "Invalid number of stations: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--simulate") == 0) {
+			simulate = true;
+		} else if (std::strcmp(argv[i], "--sim-rate") == 0 && haveValue) {
+			if (!fromString<float>(simulation.frameRate, argv[++i]) || simulation.frameRate <= 0 ||
+					simulation.frameRate > SimulationParameters::MAX_FRAME_RATE) {
+				std::cerr << "Invalid simulated frame rate: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--sim-noise") == 0 && haveValue) {
+			if (!fromString<float>(simulation.noise, argv[++i]) || simulation.noise < 0) {
+				std::cerr << "Invalid simulated noise: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--sim-dropout") == 0 && haveValue) {
+			if (!fromString<float>(simulation.dropout, argv[++i]) || simulation.dropout < 0 ||
+					simulation.dropout > 1) {
+				std::cerr << "Invalid simulated dropout chance: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--sim-trajectory") == 0 && haveValue) {
+			simulation.trajectoryFile = argv[++i];
+		} else if (std::strcmp(argv[i], "--replay") == 0 && haveValue) {
+			replayFile = argv[++i];
+		} else if (std::strcmp(argv[i], "--replay-speed") == 0 && haveValue) {
+			if (!fromString<float>(replaySpeed, argv[++i]) || replaySpeed < 0) {
+				std::cerr << "Invalid replay speed: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--record") == 0 && haveValue) {
+			recordFile = argv[++i];
+		} else if (std::strcmp(argv[i], "--port") == 0 && haveValue) {
+			if (!fromString<int>(port, argv[++i]) || port <= 0 || port > 65535) {
+				std::cerr << "Invalid port: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--shared-memory") == 0) {
+			sharedMemory = true;
+		} else if (std::strcmp(argv[i], "--latest-value") == 0) {
+			latestValue = true;
+		} else if (std::strcmp(argv[i], "--poll-loop") == 0) {
+			pollingLoop = true;
+		} else if (std::strcmp(argv[i], "--loopback-client") == 0) {
+			loopbackClients = true;
+		} else if (std::strcmp(argv[i], "--trace") == 0 && haveValue) {
+			traceFile = argv[++i];
+		} else if (std::strcmp(argv[i], "--metrics") == 0 && haveValue) {
+			g_metricsFile = argv[++i];
+		} else if (std::strcmp(argv[i], "--verbose") == 0) {
+			g_verbose = true;
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	TrackerConfiguration config;
+	if (!configFile.empty()) {
+		if (!loadConfig(configFile, config)) {
+			std::cerr << "Could not open configuration file " << configFile << std::endl;
+			return 1;
+		}
+		std::cerr << "Loaded config file " << configFile << std::endl;
+	} else if (loadConfig(defaultConfigFileName(0), config)) {
+		std::cerr << "Loaded default config file " << defaultConfigFileName(0) << std::endl;
+	}
+
+	// Command line overrides the file
+	FilterParameters smoothing = config.getSmoothing();
+	if (smoothingCutoff >= 0) {
+		smoothing.minCutoff = smoothingCutoff;
+	}
+	if (positionBeta >= 0) {
+		smoothing.positionBeta = positionBeta;
+	}
+	if (orientationBeta >= 0) {
+		smoothing.orientationBeta = orientationBeta;
+	}
+	LedConstellation constellation = config.getConstellation();
+	if (!constellationFile.empty() && !loadConstellation(constellationFile, constellation)) {
+		return 1;
+	}
+	TransportParameters transport = config.getTransport();
+	if (transportMode == "reliable") {
+		transport.mode = TRANSPORT_RELIABLE;
+	} else if (transportMode == "unreliable") {
+		transport.mode = TRANSPORT_UNRELIABLE;
+	} else if (transportMode == "default") {
+		transport.mode = TRANSPORT_DEFAULT;
+	}
+	if (socketBuffer >= 0) {
+		transport.socketBuffer = socketBuffer;
+	}
+	try {
+		config = TrackerConfiguration(
+			ledDistance > 0 ? ledDistance : config.getLEDDistance(),
+			trackerName.empty() ? config.getTrackerName() : trackerName,
+			publishRate > 0 ? publishRate : config.getPublishRate(),
+			adaptive || config.getAdaptivePublish(),
+			predictionHorizon >= 0 ? predictionHorizon : config.getPredictionHorizon(),
+			predictAcceleration ? PREDICT_CONSTANT_ACCELERATION : config.getPredictionModel(),
+			smoothing,
+			coastTime >= 0 ? coastTime : config.getCoastTime(),
+			constellation,
+			transport,
+			displayPeriod >= 0 ? displayPeriod : config.getDisplayPeriod(),
+			displayPhase >= 0 ? displayPhase : config.getDisplayPhase());
+	} catch (std::exception & e) {
+		std::cerr << "Invalid configuration: " << e.what() << std::endl;
+		return 1;
+	}
+	const char * kind = !replayFile.empty() ? "replayed " : (simulate ? "simulated " : "");
+	std::cerr << "Serving " << kind << "tracker " << config.getTrackerName() <<
+		" with LED distance " << config.getLEDDistance() << " m, publishing " <<
+		(config.getAdaptivePublish() ? "each IR frame (keep-alive " : "at ") <<
+		config.getPublishRate() << " Hz" << (config.getAdaptivePublish() ? ")" : "") << std::endl;
+	if (config.getPredictionHorizon() > 0) {
+		std::cerr << "Predicting " << config.getPredictionHorizon() << " ms ahead with constant " <<
+			(config.getPredictionModel() == PREDICT_CONSTANT_ACCELERATION ? "acceleration" : "velocity") <<
+			" as sensor 1" << std::endl;
+	}
+	if (config.getDisplayPeriod() > 0) {
+		std::cerr << "Publishing for a display every " << config.getDisplayPeriod() <<
+			" ms, deadlines " << config.getDisplayPhase() << " ms into each period" << std::endl;
+	}
+	if (config.getTransport().mode != TRANSPORT_DEFAULT) {
+		std::cerr << "Sending poses on the " <<
+			(config.getTransport().mode == TRANSPORT_RELIABLE ? "reliable" : "unreliable") <<
+			" channel only" << std::endl;
+	}
+	if (config.getConstellation().usable()) {
+		std::cerr << "Solving 6-DOF pose from " << config.getConstellation().count <<
+			" LEDs: " << config.getConstellation() << std::endl;
+	}
+	if (config.getSmoothing().enabled()) {
+		std::cerr << "Smoothing poses: cutoff " << config.getSmoothing().minCutoff <<
+			" Hz at rest, speed coefficients " << config.getSmoothing().positionBeta <<
+			" (position) and " << config.getSmoothing().orientationBeta << " (orientation)" << std::endl;
+	}
+
+	TrackingSystem system;
+	g_system = &system;
+	std::signal(SIGINT, &handleSignal);
+	std::signal(SIGTERM, &handleSignal);
+
+	WiimoteSourceType source = simulate ? SOURCE_SIMULATED : SOURCE_WIIMOTE;
+	if (simulate) {
+		system.setSimulation(simulation);
+		std::cerr << "Simulating " << simulation.frameRate << " IR frames/sec";
+		if (simulation.noise > 0) {
+			std::cerr << ", " << simulation.noise << " px noise";
+		}
+		if (simulation.dropout > 0) {
+			std::cerr << ", " << simulation.dropout * 100.0f << "% dropouts";
+		}
+		std::cerr << ", head " << (simulation.trajectoryFile.empty() ? "swaying" :
+			"following " + simulation.trajectoryFile) << std::endl;
+	}
+	if (!replayFile.empty()) {
+		source = SOURCE_REPLAY;
+		system.setReplay(replayFile, replaySpeed);
+		g_replaying = stations;
+		std::cerr << "Replaying " << replayFile << " ";
+		if (replaySpeed > 0) {
+			std::cerr << "at " << replaySpeed << "x the recorded pace" << std::endl;
+		} else {
+			std::cerr << "as fast as possible" << std::endl;
+		}
+	}
+	system.addPipeline(config, source);
+	for (int station = 1; station < stations; ++station) {
+		TrackerConfiguration stationConfig = configurationForStation(config, station);
+		const std::string fn = defaultConfigFileName(station);
+		if (loadConfig(fn, stationConfig)) {
+			std::cerr << "Loaded config file " << fn << std::endl;
+		}
+		if (system.addPipeline(stationConfig, source) < 0) {
+			return 1;
+		}
+		std::cerr << "Serving " << kind << "tracker " <<
+			stationConfig.getTrackerName() << " as station " << station << std::endl;
+	}
+	system.setListenPort(port);
+	system.usePollingLoop(pollingLoop);
+	system.useLoopbackClients(loopbackClients);
+	system.useSharedMemory(sharedMemory);
+	system.useLatestValue(latestValue);
+	if (!recordFile.empty()) {
+		TrackingCommand record(TrackingCommand::CMD_START_RECORDING);
+		record.path = recordFile;
+		system.postCommand(record);
+		std::cerr << "Recording raw Wiimote reports to " << recordFile << std::endl;
+	}
+	system.postCommand(TrackingCommand(TrackingCommand::CMD_START));
+
+	if (!traceFile.empty()) {
+		trace::start();
+	}
+
+	// The loop runs on its own thread until a signal, a startup failure
+	// or the end of a replay; this one just reports on it
+	if (!system.startThread()) {
+		return 1;
+	}
+	while (system.isThreadRunning()) {
+		vrpn_SleepMsecs(STATUS_INTERVAL * 1000.0);
+		printStatus(&system);
+	}
+	system.stopThread();
+	printStatus(&system);
+
+	if (!traceFile.empty()) {
+		trace::writeFile(traceFile);
+	}
+
+	g_system = NULL;
+	return g_exitCode;
+}
@@ -21,15 +21,75 @@
 
 #include <iostream>
 #include <string>
+#include <cstring>
 
 #include "WiimoteTracker.h"
+#include "FromString.h"
+#include "Trace.h"
 
 int main(int argc, char* argv[]) {
 	// Instantiate controller
 	WiimoteTracker tracker;
 
+	int stations = 1;
+	WiimoteSourceType source = SOURCE_WIIMOTE;
+	SimulationParameters simulation;
+	std::string traceFile;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--poll-loop") == 0) {
+			// Old fixed-sleep main loop, for comparison
+			tracker.usePollingLoop(true);
+		} else if (std::strcmp(argv[i], "--loopback-client") == 0) {
+			// Display what a VRPN client receives, not the direct tap
+			tracker.useLoopbackClients(true);
+		} else if (std::strcmp(argv[i], "--shared-memory") == 0) {
+			// Poses for same-host clients, alongside VRPN
+			tracker.useSharedMemory(true);
+		} else if (std::strcmp(argv[i], "--latest-value") == 0) {
+			// Slow clients skip to the newest pose
+			tracker.useLatestValue(true);
+		} else if (std::strcmp(argv[i], "--stations") == 0 && i + 1 < argc) {
+			// Several Wiimotes, each served as its own tracker
+			if (!fromString<int>(stations, argv[++i])) {
+				std::cerr << "Invalid number of stations: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--simulate") == 0) {
+			// Stand-in Wiimotes, for running without hardware
+			source = SOURCE_SIMULATED;
+		} else if (std::strcmp(argv[i], "--sim-rate") == 0 && i + 1 < argc) {
+			// Frame rate, camera noise, dropouts and motion of --simulate
+			fromString<float>(simulation.frameRate, argv[++i]);
+		} else if (std::strcmp(argv[i], "--sim-noise") == 0 && i + 1 < argc) {
+			fromString<float>(simulation.noise, argv[++i]);
+		} else if (std::strcmp(argv[i], "--sim-dropout") == 0 && i + 1 < argc) {
+			fromString<float>(simulation.dropout, argv[++i]);
+		} else if (std::strcmp(argv[i], "--sim-trajectory") == 0 && i + 1 < argc) {
+			simulation.trajectoryFile = argv[++i];
+		} else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			// Play back a recorded IR log instead of the Wiimotes
+			source = SOURCE_REPLAY;
+			tracker.setReplay(argv[++i], 1.0);
+		} else if (std::strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+			// Stage latencies for a monitoring agent, rewritten every second
+			tracker.setMetricsFile(argv[++i]);
+		} else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+			// Trace from launch, written at exit
+			traceFile = argv[++i];
+		}
+	}
+	tracker.setStations(stations, source);
+	tracker.setSimulation(simulation);
+	if (!traceFile.empty()) {
+		trace::start();
+	}
+
 	// Start run loop - will return when all windows closed.
 	tracker.run();
 
+	if (!traceFile.empty()) {
+		trace::writeFile(traceFile);
+	}
+
 	return 0;
 }
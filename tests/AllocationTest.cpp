@@ -0,0 +1,163 @@
+/**	@file	AllocationTest.cpp
+	@brief	Checks that a running tracking system never touches the heap once warmed up
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "TrackingSystem.h"
+#include "TrackerConfiguration.h"
+#include "SharedPoseReader.h"
+#include "AllocationCounter.h"
+#include "MonotonicClock.h"
+
+// Library/third-party includes
+#include <vrpn_Connection.h>
+#include <vrpn_Shared.h>
+#include <vrpn_Tracker.h>
+#define BOOST_TEST_MODULE Allocations
+#include <BoostTestTargetConfig.h>
+
+// Standard includes
+#include <sstream>
+
+/// Each case serves on a port of its own, above the VRPN default, so
+/// they can't collide with each other or a running tracker
+static const int BASE_PORT = 3893;
+
+/// Long enough to start up, take the client and size every buffer
+static const double WARM_UP = 2.0;
+/// Long enough for everything done once a second to happen a few times
+static const double MEASURED = 3.0;
+
+static LedConstellation headBand() {
+	LedConstellation leds;
+	leds.add(-0.09, 0, 0);
+	leds.add(0.09, 0, 0);
+	leds.add(0, 0.05, 0.04);
+	leds.add(0, -0.04, 0.02);
+	return leds;
+}
+
+static void VRPN_CALLBACK countPose(void * userdata, const vrpn_TRACKERCB) {
+	(*static_cast<unsigned long *>(userdata))++;
+}
+
+/// @brief A VRPN client of the tracker over the loopback interface,
+/// on the test's own thread - whose allocations aren't counted.
+class LoopbackClient {
+	public:
+		LoopbackClient(const std::string & trackerName, const int port) :
+				_client(NULL),
+				_poses(0) {
+			std::ostringstream name;
+			name << trackerName << "@localhost:" << port;
+			_client = new vrpn_Tracker_Remote(name.str().c_str());
+			_client->register_change_handler(&_poses, &countPose);
+		}
+
+		~LoopbackClient() {
+			delete _client;
+		}
+
+		/// @brief Take in poses for seconds
+		void run(const double seconds) {
+			const double end = monotonic::seconds() + seconds;
+			while (monotonic::seconds() < end) {
+				_client->mainloop();
+				vrpn_SleepMsecs(1);
+			}
+		}
+
+		unsigned long getPoses() const {
+			return _poses;
+		}
+
+	private:
+		vrpn_Tracker_Remote * _client;
+		unsigned long _poses;
+};
+
+/// @brief Start a whole tracking system - simulated Wiimote, tracker,
+/// in-process tap, shared memory and a network client - run it past its
+/// warm-up, then fail if its loop allocated at all after that.
+static void checkNoAllocations(const int port, const TrackerConfiguration & config,
+		const SimulationParameters & simulation = SimulationParameters()) {
+	BOOST_REQUIRE(allocations::counted());
+	// Starting and stopping, and all the client side, may allocate
+	allocations::ignoreThisThread(true);
+
+	TrackingSystem system;
+	system.setSimulation(simulation);
+	BOOST_REQUIRE(system.addPipeline(config, SOURCE_SIMULATED) == 0);
+	system.setListenPort(port);
+	system.useSharedMemory(true);
+	BOOST_REQUIRE(system.startThread());
+	system.postCommand(TrackingCommand(TrackingCommand::CMD_START));
+
+	LoopbackClient client(config.getTrackerName(), port);
+	client.run(WARM_UP);
+	BOOST_REQUIRE(client.getPoses() > 0);
+	SharedPoseReader shared;
+	BOOST_REQUIRE(shared.open(config.getTrackerName()));
+
+	TrackerReport report;
+	const unsigned long clientBefore = client.getPoses();
+	const unsigned int sharedBefore = shared.published();
+	const unsigned long before = allocations::total();
+	client.run(MEASURED);
+	const unsigned long allocated = allocations::total() - before;
+
+	// Every path a pose takes out of the loop was taken
+	BOOST_CHECK(client.getPoses() > clientBefore);
+	BOOST_CHECK(shared.published() != sharedBefore);
+	BOOST_CHECK(system.latestReport(0, report) && report.hasPose);
+	BOOST_CHECK_EQUAL(allocated, 0UL);
+
+	system.stopThread();
+	allocations::ignoreThisThread(false);
+}
+
+BOOST_AUTO_TEST_CASE(BarAtFixedRate) {
+	checkNoAllocations(BASE_PORT, TrackerConfiguration());
+}
+
+BOOST_AUTO_TEST_CASE(BarAdaptive) {
+	SimulationParameters simulation;
+	simulation.frameRate = 200;
+	checkNoAllocations(BASE_PORT + 1,
+		TrackerConfiguration(.205f, "Tracker0", 60, true), simulation);
+}
+
+BOOST_AUTO_TEST_CASE(ConstellationFilteredAndPredicted) {
+	// Noise and dropped LEDs take the solver, smoothing, prediction and
+	// coasting down every branch they have
+	SimulationParameters simulation;
+	simulation.frameRate = 200;
+	simulation.noise = 0.5f;
+	simulation.dropout = 0.2f;
+	checkNoAllocations(BASE_PORT + 2,
+		TrackerConfiguration(.205f, "Tracker0", 120, false, 30,
+			PREDICT_CONSTANT_ACCELERATION, FilterParameters(1.0, 1.0, 10.0, 2.0),
+			100, headBand()),
+		simulation);
+}
+
+BOOST_AUTO_TEST_CASE(DisplaySynced) {
+	checkNoAllocations(BASE_PORT + 3,
+		TrackerConfiguration(.205f, "Tracker0", 60, false, 0,
+			PREDICT_CONSTANT_VELOCITY, FilterParameters(), 250,
+			LedConstellation(), TransportParameters(), 1000.0f / 60.0f, 4));
+}
@@ -0,0 +1,187 @@
+/**	@file	OcclusionTest.cpp
+	@brief	Checks coasting and confidence through a scripted LED occlusion
+
+	@date	2011
+
+	@author
+	Ryan Pavlik ( <rpavlik@iastate.edu> http://academic.cleardefinition.com/ ),
+	Iowa State University
+	Virtual Reality Applications Center and
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// Internal Includes
+#include "SimulatedStation.h"
+
+// Library/third-party includes
+#define BOOST_TEST_MODULE Occlusion
+#include <BoostTestTargetConfig.h>
+
+// Standard includes
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static const unsigned short PORT = 3894;
+
+/// The head sweeps across at 0.1 m/s; both LEDs go out of sight from
+/// OCCLUDED_FROM to OCCLUDED_TO.
+static const double OCCLUDED_FROM = 1.0;
+static const double OCCLUDED_TO = 1.6;
+static const double COAST_TIME = 0.3;
+static const double END = 2.2;
+static const float FRAME_RATE = 100;
+
+/// Margin either side of each phase, so a frame stamped on an edge is
+/// left out whichever way rounding takes it
+static const double MARGIN = 1.5 / FRAME_RATE;
+
+struct Sample {
+	double time;
+	double pos[3];
+	double confidence;
+};
+
+static double distance(const double a[3], const double b[3]) {
+	const double d[3] = {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+	return std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+}
+
+/// @brief The occlusion script, written to the temporary directory for
+/// as long as the object lives.
+class TrajectoryFile {
+	public:
+		TrajectoryFile() {
+#ifdef _WIN32
+			const char * dir = std::getenv("TEMP");
+			_path = std::string(dir ? dir : ".") + "\\";
+#else
+			const char * dir = std::getenv("TMPDIR");
+			_path = std::string((dir && *dir) ? dir : "/tmp") + "/";
+#endif
+			_path += "wiimoteheadtracker-occlusion-trajectory.txt";
+			std::ofstream out(_path.c_str());
+			out << "# seconds  x      y  z    yaw roll hidden" << std::endl <<
+				"0          -0.10  0  0.7  0   0" << std::endl <<
+				OCCLUDED_FROM << "  0.00  0  0.7  0   0    3" << std::endl <<
+				OCCLUDED_TO << "  0.06  0  0.7  0   0" << std::endl <<
+				"4.0        0.30   0  0.7  0   0" << std::endl;
+			_written = bool(out);
+		}
+
+		~TrajectoryFile() {
+			std::remove(_path.c_str());
+		}
+
+		bool written() const {
+			return _written;
+		}
+
+		const std::string & path() const {
+			return _path;
+		}
+
+	private:
+		std::string _path;
+		bool _written;
+};
+
+/// @brief Step the occlusion through a station a frame at a time,
+/// sampling each pose and the confidence in it.
+static void playOcclusion(const double coastTime, std::vector<Sample> & samples) {
+	TrajectoryFile trajectory;
+	BOOST_REQUIRE(trajectory.written());
+	SimulationParameters params;
+	params.frameRate = FRAME_RATE;
+	params.trajectoryFile = trajectory.path();
+	SimulatedStation station(PORT, LedConstellation::bar(0.145), params);
+	BOOST_REQUIRE(station.isOkay());
+	station.tracker().setCoastTime(coastTime);
+
+	while (station.getTime() < END) {
+		BOOST_REQUIRE(station.step());
+		Sample s;
+		s.time = station.getTime();
+		const double * pos = station.getPosition();
+		s.pos[0] = pos[0];
+		s.pos[1] = pos[1];
+		s.pos[2] = pos[2];
+		s.confidence = station.tracker().getConfidence();
+		samples.push_back(s);
+	}
+}
+
+/// @brief Samples wholly inside [from, to], with the margin taken off
+static std::vector<Sample> between(const std::vector<Sample> & samples,
+		const double from, const double to) {
+	std::vector<Sample> ret;
+	for (unsigned int i = 0; i < samples.size(); ++i) {
+		if (samples[i].time >= from + MARGIN && samples[i].time <= to - MARGIN) {
+			ret.push_back(samples[i]);
+		}
+	}
+	return ret;
+}
+
+BOOST_AUTO_TEST_CASE(CoastsThenHoldsThenRecovers) {
+	std::vector<Sample> samples;
+	playOcclusion(COAST_TIME, samples);
+
+	// In sight: full confidence
+	const std::vector<Sample> seen = between(samples, 0.5, OCCLUDED_FROM);
+	BOOST_REQUIRE(!seen.empty());
+	for (unsigned int i = 0; i < seen.size(); ++i) {
+		BOOST_CHECK(seen[i].confidence > 0.9);
+	}
+
+	// Coasting: still moving, with confidence falling but not gone
+	const std::vector<Sample> coasting = between(samples, OCCLUDED_FROM,
+		OCCLUDED_FROM + COAST_TIME);
+	BOOST_REQUIRE(coasting.size() >= 2);
+	for (unsigned int i = 0; i < coasting.size(); ++i) {
+		BOOST_CHECK(coasting[i].confidence < 0.95);
+		BOOST_CHECK(coasting[i].confidence > 0.0);
+		if (i > 0) {
+			BOOST_CHECK(coasting[i].confidence < coasting[i - 1].confidence);
+		}
+	}
+	BOOST_CHECK(distance(coasting.front().pos, coasting.back().pos) > 0.001);
+
+	// Coast over: held still, with no confidence
+	const std::vector<Sample> held = between(samples, OCCLUDED_FROM + COAST_TIME,
+		OCCLUDED_TO);
+	BOOST_REQUIRE(held.size() >= 2);
+	for (unsigned int i = 0; i < held.size(); ++i) {
+		BOOST_CHECK_SMALL(held[i].confidence, 1e-6);
+		BOOST_CHECK_SMALL(distance(held[i].pos, held.front().pos), 1e-6);
+	}
+
+	// Back in sight: tracking again
+	const std::vector<Sample> recovered = between(samples, OCCLUDED_TO + 0.1, END);
+	BOOST_REQUIRE(!recovered.empty());
+	for (unsigned int i = 0; i < recovered.size(); ++i) {
+		BOOST_CHECK(recovered[i].confidence > 0.9);
+	}
+	BOOST_CHECK(distance(recovered.front().pos, held.back().pos) > 0.005);
+}
+
+BOOST_AUTO_TEST_CASE(NoCoastHoldsAtOnce) {
+	std::vector<Sample> samples;
+	playOcclusion(0, samples);
+
+	const std::vector<Sample> held = between(samples, OCCLUDED_FROM, OCCLUDED_TO);
+	BOOST_REQUIRE(held.size() >= 2);
+	for (unsigned int i = 0; i < held.size(); ++i) {
+		BOOST_CHECK_SMALL(held[i].confidence, 1e-6);
+		BOOST_CHECK_SMALL(distance(held[i].pos, held.front().pos), 1e-6);
+	}
+}
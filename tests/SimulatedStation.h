@@ -0,0 +1,189 @@
+/** @file	SimulatedStation.h
+	@brief	header for a simulated Wiimote driving a head tracker device, for tests
+
+	@date	2011
+
+	@author
+	Ryan Pavlik
+	<rpavlik@iastate.edu> and <abiryan@ryand.net>
+	http://academic.cleardefinition.com/
+	Iowa State University Virtual Reality Applications Center
+	Human-Computer Interaction Graduate Program
+ */
+/*
+ Copyright Iowa State University 2009-2011
+ Distributed under the Boost Software License, Version 1.0.
+ (See accompanying file LICENSE_1_0.txt or copy at
+ http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+#ifndef _SIMULATEDSTATION_H
+#define _SIMULATEDSTATION_H
+
+// Internal Includes
+#include "HeadTrackerDevice.h"
+#include "PoseConnection.h"
+#include "SimulatedWiimote.h"
+#include "TrackerObserver.h"
+#include "MonotonicClock.h"
+
+// Library/third-party includes
+#include <vrpn_Shared.h>
+
+// Standard includes
+#include <cmath>
+#include <algorithm>
+
+/// @brief A SimulatedWiimote whose frames are sent when asked, stamped
+/// by a clock of the test's own rather than the wall clock.
+class SteppedWiimote : public SimulatedWiimote {
+	public:
+		SteppedWiimote(const char * name,
+			vrpn_Connection * c,
+			const LedConstellation & leds,
+			const SimulationParameters & params) :
+				SimulatedWiimote(name, c, leds, params) {}
+
+		/// @brief Send the frame for t seconds after construction.
+		void sendFrame(const double t) {
+			server_mainloop();
+			generate(t);
+			report(vrpn_CONNECTION_LOW_LATENCY,
+				vrpn_TimevalSum(_start, vrpn_MsecsTimeval(t * 1000.0)));
+		}
+};
+
+/// @brief One station wired as TrackerPipeline wires it - a simulated
+/// Wiimote feeding a head tracker device over a connection of its own -
+/// stepped a frame at a time.
+///
+/// The tracker publishes adaptively, so each frame gives one pose, and
+/// everything it computes goes by the frames' own time stamps: a run
+/// comes out the same however slow the machine.
+class SimulatedStation : public TrackerObserver {
+	public:
+		SimulatedStation(const unsigned short port,
+			const LedConstellation & leds,
+			const SimulationParameters & params = SimulationParameters());
+		~SimulatedStation();
+
+		bool isOkay() const;
+		HeadTrackerDevice & tracker();
+
+		/// @brief Send the next frame, then run the tracker until it has
+		/// published the pose for it.
+		/// @returns false if no pose came out.
+		bool step();
+
+		/// @brief Simulated seconds at the last frame stepped in
+		double getTime() const;
+		unsigned long getPoses() const;
+		/// @brief The last pose reported
+		const double * getPosition() const;
+
+		/// @name TrackerObserver interface
+		/// @{
+		virtual void poseReported(const struct timeval & time,
+			const double pos[3], const double quat[4]);
+		virtual void wiimoteReported(const struct timeval & time,
+			const double channels[], int numChannels);
+		/// @}
+
+	protected:
+		PoseConnection * _connection;
+		SteppedWiimote * _wiimote;
+		HeadTrackerDevice * _tracker;
+		const double _period;
+		unsigned long _frames;
+		double _time;
+		unsigned long _poses;
+		double _pos[3];
+};
+
+// -- inline implementations -- //
+
+inline SimulatedStation::SimulatedStation(const unsigned short port,
+		const LedConstellation & leds,
+		const SimulationParameters & params) :
+		_connection(new PoseConnection(port)),
+		_wiimote(NULL),
+		_tracker(NULL),
+		_period(1.0 / params.frameRate),
+		_frames(0),
+		_time(0),
+		_poses(0) {
+	_pos[0] = _pos[1] = _pos[2] = 0;
+	if (!_connection->doing_okay()) {
+		return;
+	}
+	_wiimote = new SteppedWiimote("WiiMote0", _connection, leds, params);
+	// A bar's spacing, or any for a constellation: it plays no part
+	const double spacing = (leds.count == 2) ?
+		std::fabs(leds.leds[1][0] - leds.leds[0][0]) : 0.145;
+	// Adaptive, with the keep-alive too slow to come between frames
+	_tracker = new HeadTrackerDevice("Tracker0", _connection, "*WiiMote0",
+		1.0f, true, float(spacing));
+	if (leds.usable()) {
+		_tracker->setConstellation(leds);
+	}
+	_wiimote->setObserver(this);
+	_tracker->setObserver(this);
+}
+
+inline SimulatedStation::~SimulatedStation() {
+	delete _tracker;
+	delete _wiimote;
+	delete _connection;
+}
+
+inline bool SimulatedStation::isOkay() const {
+	return _tracker != NULL;
+}
+
+inline HeadTrackerDevice & SimulatedStation::tracker() {
+	return *_tracker;
+}
+
+inline bool SimulatedStation::step() {
+	// The base tracker reports at most every half millisecond of real
+	// time: make sure it will for this frame. Sleeping longer only
+	// slows the test down.
+	vrpn_SleepMsecs(1);
+	_time = _frames * _period;
+	_frames++;
+	const unsigned long poses = _poses;
+	_wiimote->sendFrame(_time);
+
+	const double giveUp = monotonic::seconds() + 1.0;
+	while (_poses == poses && monotonic::seconds() < giveUp) {
+		_tracker->mainloop();
+		_connection->mainloop();
+	}
+	return _poses > poses;
+}
+
+inline double SimulatedStation::getTime() const {
+	return _time;
+}
+
+inline unsigned long SimulatedStation::getPoses() const {
+	return _poses;
+}
+
+inline const double * SimulatedStation::getPosition() const {
+	return _pos;
+}
+
+inline void SimulatedStation::poseReported(const struct timeval & /*time*/,
+		const double pos[3], const double /*quat*/[4]) {
+	_poses++;
+	std::copy(pos, pos + 3, _pos);
+}
+
+inline void SimulatedStation::wiimoteReported(const struct timeval & time,
+		const double channels[], int numChannels) {
+	_tracker->frameArrived(time, channels, numChannels);
+}
+
+#endif // _SIMULATEDSTATION_H